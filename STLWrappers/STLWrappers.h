@@ -12,12 +12,453 @@
 #include <unordered_set>
 #include <map>
 #include <unordered_map>
+#include <vector>
+#include <functional>
+#include <iterator>
+#include <initializer_list>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <cstring>
+#include <cstddef>
+#include <cassert>
+#include <type_traits>
+#include <tuple>
+#include <utility>
+#include <array>
+#include <cstdio>
+#include <charconv>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STLWRAPPERS_SSE2_
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define STLWRAPPERS_COROUTINES_
+#endif
+#endif
+
+#if (defined(__SSE4_2__) || defined(__AVX__)) && (defined(__x86_64__) || defined(_M_X64))
+#define STLWRAPPERS_CRC32_
+#include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32) && defined(__aarch64__)
+#define STLWRAPPERS_CRC32_
+#include <arm_acle.h>
+#endif
 
 /// This namespace contains some STL wrapper functions that provide a simpler interface to the STL.
 /// Read the STLWrappers.h file level documentation and readme.md for more info.
 namespace STLWrappers
 {
 
+	// internal, number of set bits in a 32 bit word
+	inline unsigned popcount32_(uint32_t word)
+	{
+#if defined(_MSC_VER)
+		return __popcnt(word);
+#elif defined(__GNUC__) || defined(__clang__)
+		return static_cast<unsigned>(__builtin_popcount(word));
+#else
+		unsigned count = 0;
+		for (; word != 0; word &= word - 1)
+			++count;
+		return count;
+#endif
+	}
+
+	// internal, index of the lowest set bit of a (non zero) 32 bit word
+	inline unsigned countTrailingZeros32_(uint32_t word)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, word);
+		return static_cast<unsigned>(index);
+#elif defined(__GNUC__) || defined(__clang__)
+		return static_cast<unsigned>(__builtin_ctz(word));
+#else
+		unsigned index = 0;
+		for (; (word & 1) == 0; word >>= 1)
+			++index;
+		return index;
+#endif
+	}
+
+	// internal, index of the lowest set bit of a (non zero) 64 bit word
+	inline unsigned countTrailingZeros64_(uint64_t word)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index;
+		_BitScanForward64(&index, word);
+		return static_cast<unsigned>(index);
+#elif defined(__GNUC__) || defined(__clang__)
+		return static_cast<unsigned>(__builtin_ctzll(word));
+#else
+		uint32_t low = static_cast<uint32_t>(word);
+		return low != 0 ? countTrailingZeros32_(low) : 32 + countTrailingZeros32_(static_cast<uint32_t>(word >> 32));
+#endif
+	}
+
+	// internal, hints the processor to start loading the cache line holding the address
+	inline void prefetch_(const void* address)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		__builtin_prefetch(address);
+#elif defined(STLWRAPPERS_SSE2_)
+		_mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+		(void)address;
+#endif
+	}
+
+	// internal, true for the item types that the byte search kernels below handle
+	template<typename ItemType>
+	constexpr bool isByte_ = std::is_same_v<ItemType, char> || std::is_same_v<ItemType, signed char> ||
+		std::is_same_v<ItemType, unsigned char> || std::is_same_v<ItemType, std::byte>;
+
+	// internal, returns the first occurrence of the byte, or nullptr (plain memchr, which C libraries implement with SIMD)
+	inline const uint8_t* findByte_(const uint8_t* data, size_t size, uint8_t byte)
+	{
+		return size == 0 ? nullptr : static_cast<const uint8_t*>(std::memchr(data, byte, size));
+	}
+
+	// internal, counts the occurrences of the byte, comparing 32 (AVX2) or 16 (SSE2) bytes at a time
+	inline size_t countByte_(const uint8_t* data, size_t size, uint8_t byte)
+	{
+		size_t result = 0;
+		size_t i = 0;
+#if defined(__AVX2__)
+		__m256i wanted32 = _mm256_set1_epi8(static_cast<char>(byte));
+		for (; i + 32 <= size; i += 32) {
+			__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+			uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, wanted32)));
+			result += popcount32_(mask);
+		}
+#endif
+#if defined(STLWRAPPERS_SSE2_)
+		__m128i wanted16 = _mm_set1_epi8(static_cast<char>(byte));
+		for (; i + 16 <= size; i += 16) {
+			__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+			result += popcount32_(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, wanted16))));
+		}
+#endif
+		for (; i < size; ++i)
+			result += data[i] == byte ? 1 : 0;
+		return result;
+	}
+
+	// internal, returns the first occurrence of the needle in the haystack, or nullptr.
+	// Candidate positions are found by comparing the first and last byte of the needle against 16
+	// positions at a time (SSE2), and only those are compared in full.
+	inline const uint8_t* findBytes_(const uint8_t* haystack, size_t size, const uint8_t* needle, size_t needleSize)
+	{
+		if (needleSize == 0)
+			return haystack;
+		if (needleSize > size)
+			return nullptr;
+		if (needleSize == 1)
+			return findByte_(haystack, size, needle[0]);
+
+		size_t last = size - needleSize; // last possible start of a match
+		size_t i = 0;
+#if defined(STLWRAPPERS_SSE2_)
+		__m128i first = _mm_set1_epi8(static_cast<char>(needle[0]));
+		__m128i lastByte = _mm_set1_epi8(static_cast<char>(needle[needleSize - 1]));
+		for (; i + 16 <= last + 1; i += 16) {
+			__m128i starts = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i));
+			__m128i ends = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i + needleSize - 1));
+			uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(starts, first), _mm_cmpeq_epi8(ends, lastByte))));
+			while (mask != 0) {
+				size_t candidate = i + countTrailingZeros32_(mask);
+				if (std::memcmp(haystack + candidate + 1, needle + 1, needleSize - 2) == 0)
+					return haystack + candidate;
+				mask &= mask - 1;
+			}
+		}
+#endif
+		while (i <= last) {
+			const uint8_t* candidate = findByte_(haystack + i, last + 1 - i, needle[0]);
+			if (candidate == nullptr)
+				return nullptr;
+			if (std::memcmp(candidate + 1, needle + 1, needleSize - 1) == 0)
+				return candidate;
+			i = static_cast<size_t>(candidate - haystack) + 1;
+		}
+		return nullptr;
+	}
+
+	// internal, multiplies two 64 bit words into 128 bits and folds the halves together (the "mum" mix of wyhash)
+	inline uint64_t multiplyMix_(uint64_t a, uint64_t b)
+	{
+#if defined(__SIZEOF_INT128__)
+		__extension__ typedef unsigned __int128 Uint128_;
+		Uint128_ product = static_cast<Uint128_>(a) * b;
+		return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+		uint64_t high;
+		uint64_t low = _umul128(a, b, &high);
+		return low ^ high;
+#else
+		uint64_t aLow = a & 0xffffffff, aHigh = a >> 32, bLow = b & 0xffffffff, bHigh = b >> 32;
+		uint64_t lowLow = aLow * bLow, lowHigh = aLow * bHigh, highLow = aHigh * bLow, highHigh = aHigh * bHigh;
+		uint64_t middle = (lowLow >> 32) + (lowHigh & 0xffffffff) + (highLow & 0xffffffff);
+		uint64_t low = (lowLow & 0xffffffff) | (middle << 32);
+		uint64_t high = highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+		return low ^ high;
+#endif
+	}
+
+	// internal, unaligned little endian reads
+	inline uint64_t read64_(const uint8_t* data)
+	{
+		uint64_t word;
+		std::memcpy(&word, data, 8);
+		return word;
+	}
+
+	inline uint64_t read32_(const uint8_t* data)
+	{
+		uint32_t word;
+		std::memcpy(&word, data, 4);
+		return word;
+	}
+
+	/// Mixes a 64 bit value so that every bit of the result depends on every bit of the value.
+	/// Used to hash integers, and to spread hashes that are poorly distributed (e.g. an identity std::hash).
+	inline uint64_t mixHash(uint64_t value)
+	{
+		return multiplyMix_(value, 0x9e3779b97f4a7c15ULL);
+	}
+
+	/// Combines a hash into a seed (e.g. the hashes of the members of a struct, one after another).
+	/// The order matters, hashCombine(hashCombine(0, a), b) differs from hashCombine(hashCombine(0, b), a).
+	inline uint64_t hashCombine(uint64_t seed, uint64_t hash)
+	{
+		return multiplyMix_(seed ^ 0xa0761d6478bd642fULL, hash ^ 0xe7037ed1a0b428dbULL);
+	}
+
+	/// Hashes a range of bytes, the same way on every platform and build (in the style of wyhash: 16 bytes
+	/// per step folded in with 64x64->128 bit multiplies, three independent lanes for long inputs).
+	/// Use this for hashes that are stored (e.g. in files); FastHash may use hardware CRC32 instead.
+	inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0)
+	{
+		const uint64_t prime0 = 0xa0761d6478bd642fULL, prime1 = 0xe7037ed1a0b428dbULL;
+		const uint64_t prime2 = 0x8ebc6af09c88c6e3ULL, prime3 = 0x589965cc75374cc3ULL;
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		seed ^= multiplyMix_(seed ^ prime0, prime1);
+		uint64_t a, b;
+		if (size <= 16) {
+			if (size >= 4) {
+				// two overlapping pairs of 4 byte reads cover 4 to 16 bytes without branching on the length
+				size_t quarter = (size >> 3) << 2;
+				a = (read32_(bytes) << 32) | read32_(bytes + quarter);
+				b = (read32_(bytes + size - 4) << 32) | read32_(bytes + size - 4 - quarter);
+			}
+			else if (size > 0) {
+				a = (uint64_t(bytes[0]) << 16) | (uint64_t(bytes[size >> 1]) << 8) | bytes[size - 1];
+				b = 0;
+			}
+			else {
+				a = b = 0;
+			}
+		}
+		else {
+			size_t left = size;
+			if (left > 48) {
+				uint64_t lane1 = seed, lane2 = seed;
+				do {
+					seed = multiplyMix_(read64_(bytes) ^ prime1, read64_(bytes + 8) ^ seed);
+					lane1 = multiplyMix_(read64_(bytes + 16) ^ prime2, read64_(bytes + 24) ^ lane1);
+					lane2 = multiplyMix_(read64_(bytes + 32) ^ prime3, read64_(bytes + 40) ^ lane2);
+					bytes += 48;
+					left -= 48;
+				} while (left > 48);
+				seed ^= lane1 ^ lane2;
+			}
+			while (left > 16) {
+				seed = multiplyMix_(read64_(bytes) ^ prime1, read64_(bytes + 8) ^ seed);
+				bytes += 16;
+				left -= 16;
+			}
+			// the last 16 bytes (overlapping bytes already hashed if needed)
+			a = read64_(bytes + left - 16);
+			b = read64_(bytes + left - 8);
+		}
+		return multiplyMix_(prime1 ^ size, multiplyMix_(a ^ prime1, b ^ seed));
+	}
+
+#if defined(STLWRAPPERS_CRC32_)
+	// internal, one step of the hardware CRC32-C instruction
+	inline uint64_t crc32Step_(uint64_t crc, uint64_t word)
+	{
+#if defined(__ARM_FEATURE_CRC32)
+		return __crc32cd(static_cast<uint32_t>(crc), word);
+#else
+		return _mm_crc32_u64(crc, word);
+#endif
+	}
+
+	// internal, hashes bytes with two interleaved CRC32-C lanes (8 bytes per instruction each) and a final mix
+	inline uint64_t hashBytesCrc32_(const uint8_t* bytes, size_t size)
+	{
+		uint64_t a = 0x8ebc6af0, b = 0x75374cc3;
+		if (size >= 16) {
+			size_t i = 0;
+			for (; i + 16 <= size; i += 16) {
+				a = crc32Step_(a, read64_(bytes + i));
+				b = crc32Step_(b, read64_(bytes + i + 8));
+			}
+			if (i < size) {
+				a = crc32Step_(a, read64_(bytes + size - 16));
+				b = crc32Step_(b, read64_(bytes + size - 8));
+			}
+		}
+		else if (size >= 8) {
+			a = crc32Step_(a, read64_(bytes));
+			b = crc32Step_(b, read64_(bytes + size - 8));
+		}
+		else if (size >= 4) {
+			a = crc32Step_(a, read32_(bytes));
+			b = crc32Step_(b, read32_(bytes + size - 4));
+		}
+		else if (size > 0) {
+			a = crc32Step_(a, (uint64_t(bytes[0]) << 16) | (uint64_t(bytes[size >> 1]) << 8) | bytes[size - 1]);
+		}
+		return mixHash(((a << 32) | b) ^ size);
+	}
+#endif
+
+	// internal, hashes bytes for in memory tables, with the hardware CRC32-C instruction when it is available
+	inline uint64_t hashBytesFast_(const void* data, size_t size)
+	{
+#if defined(STLWRAPPERS_CRC32_)
+		return hashBytesCrc32_(static_cast<const uint8_t*>(data), size);
+#else
+		return hashBytes(data, size);
+#endif
+	}
+
+	/// The hash function used by default by the hashed containers and temporaries of this library, and
+	/// usable for your own containers (e.g. std::unordered_set<Key, STLWrappers::FastHash<Key>>).
+	/// - integers, enums and pointers are mixed with mixHash() (std::hash is often the identity for them,
+	///   which clusters keys in open addressing tables and in tables with a power of two number of buckets)
+	/// - strings and string views are hashed with a wyhash style byte hash, or with the hardware CRC32-C
+	///   instruction when the build targets SSE4.2 (or ARM with CRC32); the string hash is transparent, so a
+	///   std::string key can be hashed from a std::string_view without copying it
+	/// - pairs and tuples combine the FastHash of their elements with hashCombine()
+	/// - anything else uses std::hash, mixed with mixHash()
+	/// @note Values may differ between builds, use hashBytes() for hashes that are stored.
+	template<typename T, typename Enable = void>
+	struct FastHash
+	{
+		size_t operator()(const T& value) const
+		{
+			return static_cast<size_t>(mixHash(static_cast<uint64_t>(std::hash<T>{}(value))));
+		}
+	};
+
+	template<typename T>
+	struct FastHash<T, std::enable_if_t<std::is_integral_v<T> || std::is_enum_v<T>>>
+	{
+		size_t operator()(T value) const
+		{
+			return static_cast<size_t>(mixHash(static_cast<uint64_t>(value)));
+		}
+	};
+
+	template<typename T>
+	struct FastHash<T, std::enable_if_t<std::is_pointer_v<T>>>
+	{
+		size_t operator()(T value) const
+		{
+			return static_cast<size_t>(mixHash(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value))));
+		}
+	};
+
+	template<typename T>
+	struct FastHash<T, std::enable_if_t<std::is_floating_point_v<T>>>
+	{
+		size_t operator()(T value) const
+		{
+			double number = value == 0 ? 0.0 : static_cast<double>(value); // 0.0 and -0.0 are equal
+			uint64_t bits;
+			std::memcpy(&bits, &number, sizeof(bits));
+			return static_cast<size_t>(mixHash(bits));
+		}
+	};
+
+	template<typename Traits, typename Allocator>
+	struct FastHash<std::basic_string<char, Traits, Allocator>>
+	{
+		using is_transparent = void;
+
+		size_t operator()(std::string_view value) const
+		{
+			return static_cast<size_t>(hashBytesFast_(value.data(), value.size()));
+		}
+	};
+
+	template<>
+	struct FastHash<std::string_view> : FastHash<std::string> {};
+
+	template<typename First, typename Second>
+	struct FastHash<std::pair<First, Second>>
+	{
+		size_t operator()(const std::pair<First, Second>& value) const
+		{
+			uint64_t first = FastHash<std::remove_cv_t<First>>{}(value.first);
+			return static_cast<size_t>(hashCombine(first, FastHash<std::remove_cv_t<Second>>{}(value.second)));
+		}
+	};
+
+	template<typename... Types>
+	struct FastHash<std::tuple<Types...>>
+	{
+		size_t operator()(const std::tuple<Types...>& value) const
+		{
+			return std::apply([](const auto&... items) {
+				uint64_t hash = 0;
+				((hash = hashCombine(hash, FastHash<std::decay_t<decltype(items)>>{}(items))), ...);
+				return static_cast<size_t>(hash);
+			}, value);
+		}
+	};
+
 	/// @name find(inContainer, item)
 	/// Finds an item in a container.
 	/// Returns an iterator to the item if found, otherwise returns the end iterator.
@@ -34,32 +475,48 @@ namespace STLWrappers
 	}
 	///
 	/// find() overload for set, uses binary search tree, thus complexity is logarithmic.
-	template<typename ItemType>
-	auto find(const std::set<ItemType>& inContainer, const ItemType& item)
+	template<typename ItemType, typename Compare, typename Allocator>
+	auto find(const std::set<ItemType, Compare, Allocator>& inContainer, const ItemType& item)
 	{
 		return inContainer.find(item);
 	}
 	///
 	/// find() overload for unordered set, uses hash table, thus complexity is constant.
-	template<typename ItemType>
-	auto find(const std::unordered_set<ItemType>& inContainer, const ItemType& item)
+	template<typename ItemType, typename Hash, typename KeyEqual, typename Allocator>
+	auto find(const std::unordered_set<ItemType, Hash, KeyEqual, Allocator>& inContainer, const ItemType& item)
 	{
 		return inContainer.find(item);
 	}
 	///
 	/// find() overload for map, uses binary search tree, thus complexity is logarithmic.
-	template<typename KeyType, typename ValueType>
-	auto find(const std::map<KeyType,ValueType>& inContainer, const KeyType& item)
+	template<typename KeyType, typename ValueType, typename Compare, typename Allocator>
+	auto find(const std::map<KeyType, ValueType, Compare, Allocator>& inContainer, const KeyType& item)
 	{
 		return inContainer.find(item);
 	}
 	///
 	/// find() overload for unordered map, uses hash table, thus complexity is constant.
-	template<typename KeyType, typename ValueType>
-	auto find(const std::unordered_map<KeyType, ValueType>& inContainer, const KeyType& item)
+	template<typename KeyType, typename ValueType, typename Hash, typename KeyEqual, typename Allocator>
+	auto find(const std::unordered_map<KeyType, ValueType, Hash, KeyEqual, Allocator>& inContainer, const KeyType& item)
 	{
 		return inContainer.find(item);
 	}
+	///
+	/// find() overload for string, uses a vectorized byte search. Complexity is linear.
+	inline auto find(const std::string& inContainer, char item)
+	{
+		auto found = findByte_(reinterpret_cast<const uint8_t*>(inContainer.data()), inContainer.size(), static_cast<uint8_t>(item));
+		return found == nullptr ? inContainer.end() : inContainer.begin() + (reinterpret_cast<const char*>(found) - inContainer.data());
+	}
+	///
+	/// find() overload for vectors of bytes (char, signed char, unsigned char, std::byte), uses a vectorized
+	/// byte search. Complexity is linear.
+	template<typename ItemType, std::enable_if_t<isByte_<ItemType>, int> = 0>
+	auto find(const std::vector<ItemType>& inContainer, const ItemType& item)
+	{
+		auto found = findByte_(reinterpret_cast<const uint8_t*>(inContainer.data()), inContainer.size(), static_cast<uint8_t>(item));
+		return found == nullptr ? inContainer.end() : inContainer.begin() + (reinterpret_cast<const ItemType*>(found) - inContainer.data());
+	}
 	///@}
 
 	/// Returns true if the specified container contains the specified item.
@@ -155,28 +612,28 @@ namespace STLWrappers
 	}
 	///
 	/// remove() overload for set, complexity is logarithmic.
-	template<typename ItemType>
-	void remove(std::set<ItemType>& fromContainer, const ItemType& item)
+	template<typename ItemType, typename Compare, typename Allocator>
+	void remove(std::set<ItemType, Compare, Allocator>& fromContainer, const ItemType& item)
 	{
 		fromContainer.erase(item);
 	}
 	///
 	/// remove() overload for unordred set, complexity is constant.
-	template<typename ItemType>
-	void remove(std::unordered_set<ItemType>& fromContainer, const ItemType& item)
+	template<typename ItemType, typename Hash, typename KeyEqual, typename Allocator>
+	void remove(std::unordered_set<ItemType, Hash, KeyEqual, Allocator>& fromContainer, const ItemType& item)
 	{
 		fromContainer.erase(item);
 	}
 	/// remove() overload for map, complexity is logarithmic.
-	template<typename KeyType, typename ValueType>
-	void remove(std::map<KeyType,ValueType>& fromContainer, const KeyType& item)
+	template<typename KeyType, typename ValueType, typename Compare, typename Allocator>
+	void remove(std::map<KeyType, ValueType, Compare, Allocator>& fromContainer, const KeyType& item)
 	{
 		fromContainer.erase(item);
 	}
 	///
 	/// remove() overload for unordered map, complexity is constant.
-	template<typename KeyType, typename ValueType>
-	void remove(std::unordered_map<KeyType, ValueType>& fromContainer, const KeyType& item)
+	template<typename KeyType, typename ValueType, typename Hash, typename KeyEqual, typename Allocator>
+	void remove(std::unordered_map<KeyType, ValueType, Hash, KeyEqual, Allocator>& fromContainer, const KeyType& item)
 	{
 		fromContainer.erase(item);
 	}
@@ -235,34 +692,121 @@ namespace STLWrappers
 	}
 	///
 	/// count() overload for set, complexity is logarithmic.
-	template<typename ItemType>
-	size_t count(const std::set<ItemType>& inContainer, const ItemType& item)
+	template<typename ItemType, typename Compare, typename Allocator>
+	size_t count(const std::set<ItemType, Compare, Allocator>& inContainer, const ItemType& item)
 	{
 		return inContainer.count(item);
 	}
 	///
 	/// count() overload for unordered set, complexity is constant.
-	template<typename ItemType>
-	size_t count(const std::unordered_set<ItemType>& inContainer, const ItemType& item)
+	template<typename ItemType, typename Hash, typename KeyEqual, typename Allocator>
+	size_t count(const std::unordered_set<ItemType, Hash, KeyEqual, Allocator>& inContainer, const ItemType& item)
 	{
 		return inContainer.count(item);
 	}
 	///
 	/// count() overload for map, complexity is logarithmic.
-	template<typename KeyType, typename ValueType>
-	size_t count(const std::map<KeyType,ValueType>& inContainer, const KeyType& item)
+	template<typename KeyType, typename ValueType, typename Compare, typename Allocator>
+	size_t count(const std::map<KeyType, ValueType, Compare, Allocator>& inContainer, const KeyType& item)
 	{
 		return inContainer.count(item);
 	}
 	///
 	/// count() overload for unordered map, complexity is constant.
-	template<typename KeyType, typename ValueType>
-	size_t count(const std::unordered_map<KeyType, ValueType>& inContainer, const KeyType& item)
+	template<typename KeyType, typename ValueType, typename Hash, typename KeyEqual, typename Allocator>
+	size_t count(const std::unordered_map<KeyType, ValueType, Hash, KeyEqual, Allocator>& inContainer, const KeyType& item)
 	{
 		return inContainer.count(item);
 	}
+	///
+	/// count() overload for string, uses a vectorized byte count. Complexity is linear.
+	inline size_t count(const std::string& inContainer, char item)
+	{
+		return countByte_(reinterpret_cast<const uint8_t*>(inContainer.data()), inContainer.size(), static_cast<uint8_t>(item));
+	}
+	///
+	/// count() overload for vectors of bytes, uses a vectorized byte count. Complexity is linear.
+	template<typename ItemType, std::enable_if_t<isByte_<ItemType>, int> = 0>
+	size_t count(const std::vector<ItemType>& inContainer, const ItemType& item)
+	{
+		return countByte_(reinterpret_cast<const uint8_t*>(inContainer.data()), inContainer.size(), static_cast<uint8_t>(item));
+	}
+	///@}
+
+	/// @name findSubsequence(inContainer, subsequence)
+	/// Finds the first occurrence of a subsequence (e.g. a substring) in a container.
+	/// Returns an iterator to the start of the first occurrence if found, otherwise returns the end iterator.
+	/// `subsequence` can be another container or an initializer list.
+	/// @note For strings and vectors of bytes a vectorized search is used, for other containers std::search().
+	///@{
+	///
+	/// Generic findSubsequence() overload that works on any container. Complexity is O(n*m).
+	template<typename ContainerType, typename SubsequenceType>
+	auto findSubsequence(const ContainerType& inContainer, const SubsequenceType& subsequence)
+	{
+		return std::search(std::begin(inContainer), std::end(inContainer), std::begin(subsequence), std::end(subsequence));
+	}
+	///
+	/// findSubsequence() overload for initializer lists.
+	template<typename ContainerType, typename ItemType>
+	auto findSubsequence(const ContainerType& inContainer, const std::initializer_list<ItemType>& subsequence)
+	{
+		return std::search(std::begin(inContainer), std::end(inContainer), std::begin(subsequence), std::end(subsequence));
+	}
+	///
+	/// findSubsequence() overload for strings (the subsequence can be anything convertible to a std::string_view),
+	/// complexity is linear in practice.
+	template<typename SubsequenceType, std::enable_if_t<std::is_convertible_v<const SubsequenceType&, std::string_view>, int> = 0>
+	auto findSubsequence(const std::string& inContainer, const SubsequenceType& item)
+	{
+		std::string_view subsequence(item);
+		auto found = findBytes_(reinterpret_cast<const uint8_t*>(inContainer.data()), inContainer.size(),
+			reinterpret_cast<const uint8_t*>(subsequence.data()), subsequence.size());
+		return found == nullptr ? inContainer.end() : inContainer.begin() + (reinterpret_cast<const char*>(found) - inContainer.data());
+	}
+	///
+	/// findSubsequence() overload for vectors of bytes, complexity is linear in practice.
+	template<typename ItemType, std::enable_if_t<isByte_<ItemType>, int> = 0>
+	auto findSubsequence(const std::vector<ItemType>& inContainer, const std::vector<ItemType>& subsequence)
+	{
+		auto found = findBytes_(reinterpret_cast<const uint8_t*>(inContainer.data()), inContainer.size(),
+			reinterpret_cast<const uint8_t*>(subsequence.data()), subsequence.size());
+		return found == nullptr ? inContainer.end() : inContainer.begin() + (reinterpret_cast<const ItemType*>(found) - inContainer.data());
+	}
+	///@}
+
+	/// @name containsSubsequence(container, subsequence)
+	/// Returns true if the container contains the subsequence (e.g. a substring).
+	/// `subsequence` can be another container or an initializer list.
+	/// @note Uses the same search as findSubsequence().
+	///@{
+	///
+	template<typename ContainerType, typename SubsequenceType>
+	bool containsSubsequence(const ContainerType& container, const SubsequenceType& subsequence)
+	{
+		return findSubsequence(container, subsequence) != std::end(container);
+	}
+	///
+	template<typename ContainerType, typename ItemType>
+	bool containsSubsequence(const ContainerType& container, const std::initializer_list<ItemType>& subsequence)
+	{
+		return findSubsequence(container, subsequence) != std::end(container);
+	}
 	///@}
 
+	// internal function with core logic, used to reduce duplicate code
+	template<typename FirstContainerType, typename SecondContainerType>
+	auto inFirstButNotInSecond_(const FirstContainerType& firstContainer, const SecondContainerType& secondContainer) {
+		using ItemType = typename FirstContainerType::value_type;
+		// the documented result type, so it keeps the standard hash (FastHash is only used for temporaries)
+		std::unordered_set<ItemType> results{};
+		for (const auto& item : firstContainer) {
+			if (!contains(secondContainer, item))
+				results.insert(item);
+		}
+		return results;
+	}
+
 	/// @name inFirstButNotSecond(firstContainer,secondContainer)
 	/// Returns the set of items in the 'firstContainer' but not in the 'secondContainer'.
 	///@{
@@ -291,15 +835,7866 @@ namespace STLWrappers
 		return inFirstButNotInSecond_(firstContainer, secondContainer);
 	}
 
-	// internal function with core logic, used to reduce duplicate code
-	template<typename FirstContainerType, typename SecondContainerType>
-	auto inFirstButNotInSecond_(const FirstContainerType& firstContainer, const SecondContainerType& secondContainer) {
-		std::unordered_set<FirstContainerType::value_type> results{};
-		for (const auto& item : firstContainer) {
-			if (!contains(secondContainer, item))
-				results.insert(item);
+	///@}
+
+	/// A sorted set stored in a packed memory array (a sorted array with gaps spread evenly through it).
+	/// The array is split into segments; the items of each segment are packed at its start and the rest
+	/// of the segment is free space. Searching is a binary search over the (nearly) contiguous array, just
+	/// like a sorted vector, but adding or removing an item only shifts the items of a single small segment.
+	/// When a segment gets too full (or too empty), the smallest enclosing window of segments that is within
+	/// its density bounds is evenly re-spread, and when the whole array is out of bounds it is resized.
+	/// This gives O(log n) find(), amortized O(log^2 n) add() and remove(), and near-contiguous iteration
+	/// (in sorted order).
+	/// @note ItemType must be default constructible (empty slots hold default constructed items).
+	template<typename ItemType, typename Compare = std::less<ItemType>>
+	class PackedMemoryArray
+	{
+	public:
+		using value_type = ItemType;
+		using size_type = size_t;
+
+		/// Iterates over the items in sorted order, skipping over the gaps.
+		/// Any add() or remove() invalidates all iterators.
+		class const_iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = ItemType;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const ItemType*;
+			using reference = const ItemType&;
+
+			const_iterator() = default;
+			const_iterator(const PackedMemoryArray* array, size_t slot) : array_(array), slot_(slot) { skipGaps_(); }
+
+			reference operator*() const { return array_->slots_[slot_]; }
+			pointer operator->() const { return &array_->slots_[slot_]; }
+			const_iterator& operator++() { ++slot_; skipGaps_(); return *this; }
+			const_iterator operator++(int) { const_iterator old = *this; ++(*this); return old; }
+			bool operator==(const const_iterator& other) const { return slot_ == other.slot_; }
+			bool operator!=(const const_iterator& other) const { return slot_ != other.slot_; }
+
+		private:
+			// moves to the start of the next segment if we are past the last item of the current one
+			void skipGaps_()
+			{
+				size_t capacity = array_->slots_.size();
+				while (slot_ < capacity) {
+					size_t segment = slot_ / array_->segmentSize_;
+					if (slot_ - segment * array_->segmentSize_ < array_->counts_[segment])
+						return;
+					slot_ = (segment + 1) * array_->segmentSize_;
+				}
+				slot_ = capacity;
+			}
+
+			const PackedMemoryArray* array_ = nullptr;
+			size_t slot_ = 0;
+		};
+		using iterator = const_iterator;
+
+		PackedMemoryArray() { rebuild_(std::vector<ItemType>{}); }
+
+		PackedMemoryArray(std::initializer_list<ItemType> items) : PackedMemoryArray()
+		{
+			for (const auto& item : items)
+				insert(item);
 		}
-		return results;
+
+		const_iterator begin() const { return const_iterator(this, 0); }
+		const_iterator end() const { return const_iterator(this, slots_.size()); }
+		size_t size() const { return size_; }
+		bool empty() const { return size_ == 0; }
+		void clear() { rebuild_(std::vector<ItemType>{}); }
+
+		/// Returns an iterator to the item, or end() if it is not in the array. Complexity is logarithmic.
+		const_iterator find(const ItemType& item) const
+		{
+			size_t slot = lowerBound_(item);
+			if (slot != npos_ && !less_(item, slots_[slot]))
+				return const_iterator(this, slot);
+			return end();
+		}
+
+		/// Returns 1 if the item is in the array, otherwise 0.
+		size_t count(const ItemType& item) const
+		{
+			return find(item) == end() ? 0 : 1;
+		}
+
+		/// Adds the item (if it is not already in the array). Returns true if it was added.
+		bool insert(const ItemType& item)
+		{
+			size_t segment = locateSegment_(item);
+			ItemType* first = &slots_[segment * segmentSize_];
+			ItemType* last = first + counts_[segment];
+			ItemType* position = std::lower_bound(first, last, item, less_);
+			if (position != last && !less_(item, *position))
+				return false;
+
+			if (counts_[segment] < segmentSize_) {
+				std::move_backward(position, last, last + 1);
+				*position = item;
+				++counts_[segment];
+				++size_;
+				return true;
+			}
+
+			// segment is full, find the smallest enclosing window that can take one more item
+			size_t segmentCount = slots_.size() / segmentSize_;
+			size_t height = log2_(segmentCount);
+			for (size_t level = 1; level <= height; ++level) {
+				size_t windowSegments = size_t(1) << level;
+				size_t windowStart = segment / windowSegments * windowSegments;
+				size_t windowItems = itemsIn_(windowStart, windowSegments) + 1;
+				if (windowItems <= upperDensity_(level, height) * (windowSegments * segmentSize_)) {
+					std::vector<ItemType> items = takeItems_(windowStart, windowSegments, &item);
+					spread_(windowStart, windowSegments, items);
+					++size_;
+					return true;
+				}
+			}
+
+			// even the whole array is too dense, grow it
+			std::vector<ItemType> items = takeItems_(0, segmentCount, &item);
+			rebuild_(std::move(items));
+			return true;
+		}
+
+		/// Removes the item (if it is in the array). Returns true if it was removed.
+		bool erase(const ItemType& item)
+		{
+			size_t segment = locateSegment_(item);
+			ItemType* first = &slots_[segment * segmentSize_];
+			ItemType* last = first + counts_[segment];
+			ItemType* position = std::lower_bound(first, last, item, less_);
+			if (position == last || less_(item, *position))
+				return false;
+
+			std::move(position + 1, last, position);
+			*(last - 1) = ItemType{};
+			--counts_[segment];
+			--size_;
+
+			if (counts_[segment] * 8 >= segmentSize_)
+				return true;
+
+			// segment is too sparse, find the smallest enclosing window that is dense enough
+			size_t segmentCount = slots_.size() / segmentSize_;
+			size_t height = log2_(segmentCount);
+			if (height == 0)
+				return true;
+			for (size_t level = 1; level <= height; ++level) {
+				size_t windowSegments = size_t(1) << level;
+				size_t windowStart = segment / windowSegments * windowSegments;
+				size_t windowItems = itemsIn_(windowStart, windowSegments);
+				if (windowItems >= lowerDensity_(level, height) * (windowSegments * segmentSize_)) {
+					std::vector<ItemType> items = takeItems_(windowStart, windowSegments, nullptr);
+					spread_(windowStart, windowSegments, items);
+					return true;
+				}
+			}
+
+			// even the whole array is too sparse, shrink it
+			rebuild_(takeItems_(0, segmentCount, nullptr));
+			return true;
+		}
+
+	private:
+		static constexpr size_t npos_ = size_t(-1);
+		static constexpr size_t minSegmentSize_ = 8;
+
+		static size_t log2_(size_t n)
+		{
+			size_t result = 0;
+			while (n > 1) {
+				n >>= 1;
+				++result;
+			}
+			return result;
+		}
+
+		// density thresholds are interpolated between the leaves (segments) and the root (whole array)
+		static double upperDensity_(size_t level, size_t height)
+		{
+			return 1.0 - 0.25 * level / height;
+		}
+
+		static double lowerDensity_(size_t level, size_t height)
+		{
+			return 0.125 + 0.125 * level / height;
+		}
+
+		size_t itemsIn_(size_t firstSegment, size_t segmentCount) const
+		{
+			size_t total = 0;
+			for (size_t i = firstSegment; i < firstSegment + segmentCount; ++i)
+				total += counts_[i];
+			return total;
+		}
+
+		// Returns the segment that the item belongs in. Every segment holds at least one item
+		// (unless the whole array is empty), so this is a binary search on the first item of each segment.
+		size_t locateSegment_(const ItemType& item) const
+		{
+			size_t low = 0;
+			size_t high = slots_.size() / segmentSize_;
+			if (size_ == 0)
+				return 0;
+			while (low < high) {
+				size_t middle = low + (high - low) / 2;
+				if (less_(item, slots_[middle * segmentSize_]))
+					high = middle;
+				else
+					low = middle + 1;
+			}
+			return low == 0 ? 0 : low - 1;
+		}
+
+		// Returns the slot of the first item not less than 'item', or npos_ if there is none in its segment.
+		size_t lowerBound_(const ItemType& item) const
+		{
+			size_t segment = locateSegment_(item);
+			const ItemType* first = &slots_[segment * segmentSize_];
+			const ItemType* last = first + counts_[segment];
+			const ItemType* position = std::lower_bound(first, last, item, less_);
+			if (position == last)
+				return npos_;
+			return static_cast<size_t>(position - slots_.data());
+		}
+
+		// Moves the items of a window of segments out into a vector (in order), optionally merging in 'extra'.
+		std::vector<ItemType> takeItems_(size_t firstSegment, size_t segmentCount, const ItemType* extra)
+		{
+			std::vector<ItemType> items;
+			items.reserve(itemsIn_(firstSegment, segmentCount) + 1);
+			bool extraTaken = extra == nullptr;
+			for (size_t segment = firstSegment; segment < firstSegment + segmentCount; ++segment) {
+				ItemType* first = &slots_[segment * segmentSize_];
+				for (ItemType* slot = first; slot != first + counts_[segment]; ++slot) {
+					if (!extraTaken && less_(*extra, *slot)) {
+						items.push_back(*extra);
+						extraTaken = true;
+					}
+					items.push_back(std::move(*slot));
+					*slot = ItemType{};
+				}
+				counts_[segment] = 0;
+			}
+			if (!extraTaken)
+				items.push_back(*extra);
+			return items;
+		}
+
+		// Evenly spreads the (sorted) items over a window of (empty) segments.
+		void spread_(size_t firstSegment, size_t segmentCount, std::vector<ItemType>& items)
+		{
+			size_t perSegment = items.size() / segmentCount;
+			size_t remainder = items.size() % segmentCount;
+			auto next = items.begin();
+			for (size_t i = 0; i < segmentCount; ++i) {
+				size_t segment = firstSegment + i;
+				size_t count = perSegment + (i < remainder ? 1 : 0);
+				std::move(next, next + count, slots_.begin() + segment * segmentSize_);
+				next += count;
+				counts_[segment] = count;
+			}
+		}
+
+		// Reallocates the array so that its density is about one half and spreads the items over it.
+		void rebuild_(std::vector<ItemType> items)
+		{
+			size_t capacity = minSegmentSize_;
+			while (capacity < items.size() * 2)
+				capacity *= 2;
+			segmentSize_ = minSegmentSize_;
+			while (segmentSize_ < log2_(capacity))
+				segmentSize_ *= 2;
+
+			slots_.assign(capacity, ItemType{});
+			counts_.assign(capacity / segmentSize_, 0);
+			size_ = items.size();
+			spread_(0, counts_.size(), items);
+		}
+
+		std::vector<ItemType> slots_;
+		std::vector<size_t> counts_; // number of items packed at the start of each segment
+		size_t segmentSize_ = minSegmentSize_;
+		size_t size_ = 0;
+		Compare less_;
+	};
+
+	/// @name PackedMemoryArray overloads
+	/// Overloads of the wrapper functions for PackedMemoryArray.
+	/// contains(), containsAll(), containsAny(), addAll() and inFirstButNotInSecond() work through these.
+	///@{
+	///
+	/// find() overload for packed memory array, uses binary search, thus complexity is logarithmic.
+	template<typename ItemType, typename Compare>
+	auto find(const PackedMemoryArray<ItemType, Compare>& inContainer, const ItemType& item)
+	{
+		return inContainer.find(item);
+	}
+	///
+	/// count() overload for packed memory array, complexity is logarithmic.
+	template<typename ItemType, typename Compare>
+	size_t count(const PackedMemoryArray<ItemType, Compare>& inContainer, const ItemType& item)
+	{
+		return inContainer.count(item);
+	}
+	///
+	/// add() overload for packed memory array, amortized complexity is O(log^2 n).
+	template<typename ItemType, typename Compare>
+	void add(PackedMemoryArray<ItemType, Compare>& inContainer, const ItemType& item)
+	{
+		inContainer.insert(item);
+	}
+	///
+	/// remove() overload for packed memory array, amortized complexity is O(log^2 n).
+	template<typename ItemType, typename Compare>
+	void remove(PackedMemoryArray<ItemType, Compare>& fromContainer, const ItemType& item)
+	{
+		fromContainer.erase(item);
+	}
+	///@}
+
+	/// A Bloom filter, a compact set that can only answer "definitely not present" or "maybe present".
+	/// Used to skip searching storage that can't contain an item.
+	template<typename ItemType, typename Hash = FastHash<ItemType>>
+	class BloomFilter
+	{
+	public:
+		/// Creates a filter sized for 'expectedItems' items with 'bitsPerItem' bits each
+		/// (10 bits per item gives about a 1% false positive rate).
+		explicit BloomFilter(size_t expectedItems = 0, size_t bitsPerItem = 10)
+		{
+			size_t bits = expectedItems * bitsPerItem;
+			if (bits < 64)
+				bits = 64;
+			words_.assign((bits + 63) / 64, 0);
+			// the optimal number of hash functions is bitsPerItem * ln(2)
+			hashCount_ = bitsPerItem * 7 / 10;
+			if (hashCount_ < 1)
+				hashCount_ = 1;
+		}
+
+		void add(const ItemType& item)
+		{
+			forEachBit_(item, [this](size_t bit) { words_[bit / 64] |= uint64_t(1) << (bit % 64); });
+		}
+
+		/// Returns false if the item was definitely never added.
+		bool mayContain(const ItemType& item) const
+		{
+			bool result = true;
+			forEachBit_(item, [this, &result](size_t bit) {
+				if ((words_[bit / 64] & (uint64_t(1) << (bit % 64))) == 0)
+					result = false;
+			});
+			return result;
+		}
+
+	private:
+		// double hashing, derives all the bit positions from one (mixed) hash
+		template<typename Function>
+		void forEachBit_(const ItemType& item, Function function) const
+		{
+			uint64_t hash = mixHash(static_cast<uint64_t>(Hash{}(item)));
+			uint64_t step = (hash >> 32) | 1;
+			size_t bits = words_.size() * 64;
+			for (size_t i = 0; i < hashCount_; ++i) {
+				function(static_cast<size_t>(hash % bits));
+				hash += step;
+			}
+		}
+
+		std::vector<uint64_t> words_;
+		size_t hashCount_ = 1;
+	};
+
+	/// A write optimized set, in the style of a log structured merge tree.
+	/// add() and remove() simply append to an unsorted buffer, indexed by a small hash table of the newest
+	/// entry per item. When the buffer is full it is sorted and sealed into an immutable sorted run, and runs
+	/// of similar size are merged incrementally (so there are only O(log n) runs). A search probes the buffer
+	/// index, then the runs from newest to oldest (binary search, skipping runs whose Bloom filter rules the
+	/// item out).
+	/// Compared to std::set, adding is much cheaper (no tree insert or allocation per item) at the cost
+	/// of a more expensive search: a hash probe plus up to O(log n) binary searches, one per run the
+	/// filters don't rule out (usually only the run that holds the item).
+	/// @note Iterating or calling size() first merges everything into a single run, even through a const
+	/// LsmSet, so const reads are not safe to run concurrently while there are unmerged writes. Call
+	/// compact() after the last change before sharing the set with concurrent readers: reads of a compacted
+	/// set don't change it.
+	template<typename ItemType, typename Compare = std::less<ItemType>, typename Hash = FastHash<ItemType>>
+	class LsmSet
+	{
+		struct Entry_
+		{
+			ItemType item;
+			bool removed; // tombstone, hides older entries for the same item
+		};
+
+		struct Run_
+		{
+			std::vector<Entry_> entries; // sorted, at most one entry per item
+			BloomFilter<ItemType, Hash> filter;
+		};
+
+	public:
+		using value_type = ItemType;
+		using size_type = size_t;
+
+		/// Iterates over the items in sorted order.
+		class const_iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = ItemType;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const ItemType*;
+			using reference = const ItemType&;
+
+			const_iterator() = default;
+			explicit const_iterator(const Entry_* entry) : entry_(entry) {}
+
+			reference operator*() const { return entry_->item; }
+			pointer operator->() const { return &entry_->item; }
+			const_iterator& operator++() { ++entry_; return *this; }
+			const_iterator operator++(int) { const_iterator old = *this; ++entry_; return old; }
+			bool operator==(const const_iterator& other) const { return entry_ == other.entry_; }
+			bool operator!=(const const_iterator& other) const { return entry_ != other.entry_; }
+
+		private:
+			const Entry_* entry_ = nullptr;
+		};
+		using iterator = const_iterator;
+
+		/// 'bufferCapacity' is the number of writes buffered before they are sealed into a run.
+		/// 'bloomBitsPerItem' sizes the per run Bloom filters (0 disables them).
+		explicit LsmSet(size_t bufferCapacity = 1024, size_t bloomBitsPerItem = 10)
+			: bufferCapacity_(bufferCapacity < 1 ? 1 : bufferCapacity), bloomBitsPerItem_(bloomBitsPerItem)
+		{
+			buffer_.reserve(bufferCapacity_);
+			size_t slots = 2;
+			while (slots < 2 * bufferCapacity_)
+				slots *= 2;
+			bufferIndex_.assign(slots, 0);
+		}
+
+		LsmSet(std::initializer_list<ItemType> items) : LsmSet()
+		{
+			for (const auto& item : items)
+				insert(item);
+		}
+
+		/// Adds the item. Complexity is amortized O(log n), with no per item allocation.
+		void insert(const ItemType& item)
+		{
+			append_(item, false);
+		}
+
+		/// Removes the item (if it is in the set). Complexity is amortized O(log n).
+		void erase(const ItemType& item)
+		{
+			append_(item, true);
+		}
+
+		/// Returns a pointer to the item if it is in the set, otherwise nullptr.
+		/// Complexity is O(1) for the buffer plus O(log n) per run searched (at most r, the number of runs).
+		const ItemType* find(const ItemType& item) const
+		{
+			if (!buffer_.empty()) {
+				size_t position = bufferIndex_[bufferSlot_(item)];
+				if (position != 0)
+					return buffer_[position - 1].removed ? nullptr : &buffer_[position - 1].item;
+			}
+
+			for (auto run = runs_.rbegin(); run != runs_.rend(); ++run) {
+				if (bloomBitsPerItem_ != 0 && !run->filter.mayContain(item))
+					continue;
+				auto entry = std::lower_bound(run->entries.begin(), run->entries.end(), item,
+					[this](const Entry_& entry, const ItemType& item) { return less_(entry.item, item); });
+				if (entry != run->entries.end() && !less_(item, entry->item))
+					return entry->removed ? nullptr : &entry->item;
+			}
+			return nullptr;
+		}
+
+		/// Returns 1 if the item is in the set, otherwise 0.
+		size_t count(const ItemType& item) const
+		{
+			return find(item) == nullptr ? 0 : 1;
+		}
+
+		/// Merges the buffer and all runs into a single run.
+		/// The oldest run never holds removed items, so afterwards the run holds exactly the items in the set.
+		void compact()
+		{
+			compact_();
+		}
+
+		const_iterator begin() const
+		{
+			compact_();
+			return runs_.empty() ? const_iterator() : const_iterator(runs_[0].entries.data());
+		}
+
+		const_iterator end() const
+		{
+			compact_();
+			return runs_.empty() ? const_iterator() : const_iterator(runs_[0].entries.data() + runs_[0].entries.size());
+		}
+
+		size_t size() const
+		{
+			compact_();
+			return runs_.empty() ? 0 : runs_[0].entries.size();
+		}
+
+		bool empty() const { return size() == 0; }
+
+		void clear()
+		{
+			buffer_.clear();
+			std::fill(bufferIndex_.begin(), bufferIndex_.end(), 0);
+			runs_.clear();
+		}
+
+		/// Returns the number of sealed runs (mostly useful for tuning the buffer capacity).
+		size_t runCount() const { return runs_.size(); }
+
+	private:
+		// reads of a compacted set only check that there is nothing to merge, and don't write
+		void compact_() const
+		{
+			if (!buffer_.empty())
+				seal_();
+			while (runs_.size() > 1)
+				mergeNewestRuns_();
+		}
+
+		bool equal_(const ItemType& a, const ItemType& b) const
+		{
+			return !less_(a, b) && !less_(b, a);
+		}
+
+		static std::vector<Entry_> withoutTombstones_(std::vector<Entry_> entries)
+		{
+			entries.erase(std::remove_if(entries.begin(), entries.end(), [](const Entry_& entry) { return entry.removed; }),
+				entries.end());
+			return entries;
+		}
+
+		// the slot of the buffer index that holds the newest buffer entry for the item, or the empty slot for it
+		size_t bufferSlot_(const ItemType& item) const
+		{
+			size_t mask = bufferIndex_.size() - 1;
+			size_t slot = static_cast<size_t>(mixHash(static_cast<uint64_t>(Hash{}(item)))) & mask;
+			while (bufferIndex_[slot] != 0 && !equal_(buffer_[bufferIndex_[slot] - 1].item, item))
+				slot = (slot + 1) & mask;
+			return slot;
+		}
+
+		void append_(const ItemType& item, bool removed)
+		{
+			size_t slot = bufferSlot_(item);
+			buffer_.push_back(Entry_{ item, removed });
+			bufferIndex_[slot] = buffer_.size();
+			if (buffer_.size() >= bufferCapacity_)
+				seal_();
+		}
+
+		Run_ makeRun_(std::vector<Entry_> entries) const
+		{
+			Run_ run{ std::move(entries), BloomFilter<ItemType, Hash>() };
+			if (bloomBitsPerItem_ != 0) {
+				run.filter = BloomFilter<ItemType, Hash>(run.entries.size(), bloomBitsPerItem_);
+				for (const auto& entry : run.entries)
+					run.filter.add(entry.item);
+			}
+			return run;
+		}
+
+		// sorts the buffer into a new run (the newest write of each item wins), then merges runs of similar size
+		void seal_() const
+		{
+			std::stable_sort(buffer_.begin(), buffer_.end(),
+				[this](const Entry_& a, const Entry_& b) { return less_(a.item, b.item); });
+			std::vector<Entry_> entries;
+			entries.reserve(buffer_.size());
+			for (auto& entry : buffer_) {
+				if (!entries.empty() && equal_(entries.back().item, entry.item))
+					entries.back() = std::move(entry);
+				else
+					entries.push_back(std::move(entry));
+			}
+			buffer_.clear();
+			std::fill(bufferIndex_.begin(), bufferIndex_.end(), 0);
+			if (runs_.empty())
+				entries = withoutTombstones_(std::move(entries));
+			runs_.push_back(makeRun_(std::move(entries)));
+
+			// keep run sizes geometrically decreasing from oldest to newest, so there are O(log n) runs
+			while (runs_.size() > 1 && runs_[runs_.size() - 2].entries.size() <= 2 * runs_.back().entries.size())
+				mergeNewestRuns_();
+		}
+
+		// merges the two newest runs, entries of the newer run win
+		void mergeNewestRuns_() const
+		{
+			std::vector<Entry_> newer = std::move(runs_.back().entries);
+			runs_.pop_back();
+			std::vector<Entry_> older = std::move(runs_.back().entries);
+			runs_.pop_back();
+
+			std::vector<Entry_> merged;
+			merged.reserve(older.size() + newer.size());
+			auto a = older.begin();
+			auto b = newer.begin();
+			while (a != older.end() && b != newer.end()) {
+				if (less_(a->item, b->item))
+					merged.push_back(std::move(*a++));
+				else if (less_(b->item, a->item))
+					merged.push_back(std::move(*b++));
+				else {
+					merged.push_back(std::move(*b++));
+					++a;
+				}
+			}
+			std::move(a, older.end(), std::back_inserter(merged));
+			std::move(b, newer.end(), std::back_inserter(merged));
+
+			// nothing older than the oldest run, so its tombstones have nothing left to hide
+			if (runs_.empty())
+				merged = withoutTombstones_(std::move(merged));
+			runs_.push_back(makeRun_(std::move(merged)));
+		}
+
+		// mutable because reading (iteration) may compact, which doesn't change the contents of the set
+		mutable std::vector<Entry_> buffer_;
+		mutable std::vector<size_t> bufferIndex_; // open addressing, 1 + the position of the newest buffer entry per item (0 is empty)
+		mutable std::vector<Run_> runs_; // oldest first
+		size_t bufferCapacity_;
+		size_t bloomBitsPerItem_;
+		Compare less_;
+	};
+
+	/// @name LsmSet overloads
+	/// Overloads of the wrapper functions for LsmSet.
+	///@{
+	///
+	/// find() overload for lsm set. Returns a pointer to the item if found, otherwise nullptr.
+	template<typename ItemType, typename Compare, typename Hash>
+	const ItemType* find(const LsmSet<ItemType, Compare, Hash>& inContainer, const ItemType& item)
+	{
+		return inContainer.find(item);
+	}
+	///
+	/// contains() overload for lsm set (find() doesn't return an iterator for it).
+	template<typename ItemType, typename Compare, typename Hash>
+	bool contains(const LsmSet<ItemType, Compare, Hash>& container, const ItemType& item)
+	{
+		return container.find(item) != nullptr;
+	}
+	///
+	/// count() overload for lsm set.
+	template<typename ItemType, typename Compare, typename Hash>
+	size_t count(const LsmSet<ItemType, Compare, Hash>& inContainer, const ItemType& item)
+	{
+		return inContainer.count(item);
+	}
+	///
+	/// add() overload for lsm set, amortized complexity is O(log n).
+	template<typename ItemType, typename Compare, typename Hash>
+	void add(LsmSet<ItemType, Compare, Hash>& inContainer, const ItemType& item)
+	{
+		inContainer.insert(item);
+	}
+	///
+	/// remove() overload for lsm set, amortized complexity is O(log n).
+	template<typename ItemType, typename Compare, typename Hash>
+	void remove(LsmSet<ItemType, Compare, Hash>& fromContainer, const ItemType& item)
+	{
+		fromContainer.erase(item);
+	}
+	///@}
+
+	// internal, hash array mapped trie shared by PersistentHashMap and PersistentHashSet.
+	// Nodes are immutable and shared between versions; an update copies only the nodes on the path from the
+	// root to the changed entry (at most 13 nodes for a 64 bit hash, 5 bits per level).
+	// Each node has one bitmap for the entries stored inline and one for its children (as in CHAMP),
+	// and the position of an entry/child is the popcount of the bitmap bits below its bit.
+	template<typename EntryType, typename KeyType, typename KeyOf, typename Hash>
+	class Hamt_
+	{
+		struct Node_
+		{
+			uint32_t entryMap = 0;
+			uint32_t childMap = 0;
+			std::vector<EntryType> entries; // when past the last level, holds all the colliding entries
+			std::vector<std::shared_ptr<const Node_>> children;
+		};
+		using NodePtr_ = std::shared_ptr<const Node_>;
+
+		static constexpr unsigned bitsPerLevel_ = 5;
+		static constexpr unsigned hashBits_ = 64;
+
+	public:
+		/// Iterates over the entries (in no particular order).
+		class const_iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = EntryType;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const EntryType*;
+			using reference = const EntryType&;
+
+			const_iterator() = default;
+			explicit const_iterator(const Node_* root)
+			{
+				if (root != nullptr) {
+					stack_.push_back(Frame_{ root, 0, 0 });
+					settle_();
+				}
+			}
+
+			reference operator*() const { return stack_.back().node->entries[stack_.back().entry]; }
+			pointer operator->() const { return &**this; }
+			const_iterator& operator++() { ++stack_.back().entry; settle_(); return *this; }
+			const_iterator operator++(int) { const_iterator old = *this; ++(*this); return old; }
+			bool operator==(const const_iterator& other) const
+			{
+				if (stack_.empty() || other.stack_.empty())
+					return stack_.empty() == other.stack_.empty();
+				return &**this == &*other;
+			}
+			bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+		private:
+			struct Frame_
+			{
+				const Node_* node;
+				size_t entry;
+				size_t child;
+			};
+
+			// moves to the next entry (depth first), or to the end (empty stack)
+			void settle_()
+			{
+				while (!stack_.empty()) {
+					Frame_& frame = stack_.back();
+					if (frame.entry < frame.node->entries.size())
+						return;
+					if (frame.child < frame.node->children.size()) {
+						const Node_* child = frame.node->children[frame.child++].get();
+						stack_.push_back(Frame_{ child, 0, 0 });
+					}
+					else
+						stack_.pop_back();
+				}
+			}
+
+			std::vector<Frame_> stack_;
+		};
+
+		const_iterator begin() const { return const_iterator(root_.get()); }
+		const_iterator end() const { return const_iterator(); }
+		size_t size() const { return size_; }
+
+		/// Returns a pointer to the entry with the key, or nullptr.
+		const EntryType* find(const KeyType& key) const
+		{
+			uint64_t hash = hash_(key);
+			const Node_* node = root_.get();
+			for (unsigned shift = 0; node != nullptr; shift += bitsPerLevel_) {
+				if (shift >= hashBits_) {
+					for (const auto& entry : node->entries)
+						if (KeyOf::get(entry) == key)
+							return &entry;
+					return nullptr;
+				}
+				uint32_t bit = bitFor_(hash, shift);
+				if (node->entryMap & bit) {
+					const EntryType& entry = node->entries[indexOf_(node->entryMap, bit)];
+					return KeyOf::get(entry) == key ? &entry : nullptr;
+				}
+				if (!(node->childMap & bit))
+					return nullptr;
+				node = node->children[indexOf_(node->childMap, bit)].get();
+			}
+			return nullptr;
+		}
+
+		/// Returns a new version with the entry added (replacing any entry with the same key).
+		Hamt_ with(const EntryType& entry) const
+		{
+			bool added = false;
+			Hamt_ result;
+			result.root_ = insert_(root_.get(), entry, hash_(KeyOf::get(entry)), 0, added);
+			result.size_ = size_ + (added ? 1 : 0);
+			return result;
+		}
+
+		/// Returns a new version without the entry with the key (shares everything if there is no such entry).
+		Hamt_ without(const KeyType& key) const
+		{
+			if (find(key) == nullptr)
+				return *this;
+			Hamt_ result;
+			result.root_ = erase_(root_.get(), key, hash_(key), 0);
+			result.size_ = size_ - 1;
+			if (result.size_ == 0)
+				result.root_.reset();
+			return result;
+		}
+
+	private:
+		static uint64_t hash_(const KeyType& key)
+		{
+			// mix, so that keys whose hash is the identity (e.g. std::hash of an int) still spread over the whole trie
+			return mixHash(static_cast<uint64_t>(Hash{}(key)));
+		}
+
+		static uint32_t bitFor_(uint64_t hash, unsigned shift)
+		{
+			return uint32_t(1) << ((hash >> shift) & 31);
+		}
+
+		static size_t indexOf_(uint32_t map, uint32_t bit)
+		{
+			return popcount32_(map & (bit - 1));
+		}
+
+		// returns a node holding the two entries (with different keys), pushed down as deep as needed
+		static NodePtr_ pair_(const EntryType& a, uint64_t hashA, const EntryType& b, uint64_t hashB, unsigned shift)
+		{
+			auto node = std::make_shared<Node_>();
+			if (shift >= hashBits_) {
+				node->entries.push_back(a);
+				node->entries.push_back(b);
+				return node;
+			}
+			uint32_t bitA = bitFor_(hashA, shift);
+			uint32_t bitB = bitFor_(hashB, shift);
+			if (bitA == bitB) {
+				node->childMap = bitA;
+				node->children.push_back(pair_(a, hashA, b, hashB, shift + bitsPerLevel_));
+			}
+			else {
+				node->entryMap = bitA | bitB;
+				node->entries.push_back(bitA < bitB ? a : b);
+				node->entries.push_back(bitA < bitB ? b : a);
+			}
+			return node;
+		}
+
+		static NodePtr_ insert_(const Node_* node, const EntryType& entry, uint64_t hash, unsigned shift, bool& added)
+		{
+			auto result = node == nullptr ? std::make_shared<Node_>() : std::make_shared<Node_>(*node);
+			const KeyType& key = KeyOf::get(entry);
+
+			if (shift >= hashBits_) {
+				std::vector<EntryType> entries;
+				entries.reserve(result->entries.size() + 1);
+				for (const auto& existing : result->entries)
+					if (!(KeyOf::get(existing) == key))
+						entries.push_back(existing);
+				added = entries.size() == result->entries.size();
+				entries.push_back(entry);
+				result->entries = std::move(entries);
+				return result;
+			}
+
+			uint32_t bit = bitFor_(hash, shift);
+			if (result->entryMap & bit) {
+				size_t index = indexOf_(result->entryMap, bit);
+				const EntryType& existing = result->entries[index];
+				if (KeyOf::get(existing) == key) {
+					result->entries = replaced_(result->entries, index, entry);
+					return result;
+				}
+				// two different keys in the same slot, push both down into a child
+				NodePtr_ child = pair_(existing, hash_(KeyOf::get(existing)), entry, hash, shift + bitsPerLevel_);
+				result->entries = erased_(result->entries, index);
+				result->entryMap &= ~bit;
+				result->childMap |= bit;
+				result->children.insert(result->children.begin() + indexOf_(result->childMap, bit), child);
+				added = true;
+				return result;
+			}
+			if (result->childMap & bit) {
+				size_t index = indexOf_(result->childMap, bit);
+				result->children[index] = insert_(result->children[index].get(), entry, hash, shift + bitsPerLevel_, added);
+				return result;
+			}
+			result->entryMap |= bit;
+			result->entries = inserted_(result->entries, indexOf_(result->entryMap, bit), entry);
+			added = true;
+			return result;
+		}
+
+		// the key must be in the subtree
+		static NodePtr_ erase_(const Node_* node, const KeyType& key, uint64_t hash, unsigned shift)
+		{
+			auto result = std::make_shared<Node_>(*node);
+			if (shift >= hashBits_) {
+				for (size_t i = 0; i < result->entries.size(); ++i) {
+					if (KeyOf::get(result->entries[i]) == key) {
+						result->entries = erased_(result->entries, i);
+						break;
+					}
+				}
+				return result;
+			}
+
+			uint32_t bit = bitFor_(hash, shift);
+			if (result->entryMap & bit) {
+				result->entries = erased_(result->entries, indexOf_(result->entryMap, bit));
+				result->entryMap &= ~bit;
+				return result;
+			}
+
+			size_t index = indexOf_(result->childMap, bit);
+			NodePtr_ child = erase_(result->children[index].get(), key, hash, shift + bitsPerLevel_);
+			if (child->children.empty() && child->entries.size() == 1) {
+				// a child left with a single entry is inlined, so each version has one canonical shape
+				result->children.erase(result->children.begin() + index);
+				result->childMap &= ~bit;
+				result->entryMap |= bit;
+				result->entries = inserted_(result->entries, indexOf_(result->entryMap, bit), child->entries[0]);
+			}
+			else
+				result->children[index] = child;
+			return result;
+		}
+
+		// entries may not be assignable (e.g. pairs with a const key), so updated copies are built up
+		// one entry at a time. 'skip' is the index of an entry to leave out, 'insertAt' where to put 'entry'.
+		static std::vector<EntryType> rebuilt_(const std::vector<EntryType>& entries, size_t skip, size_t insertAt, const EntryType* entry)
+		{
+			std::vector<EntryType> result;
+			result.reserve(entries.size() + 1);
+			for (size_t i = 0; i <= entries.size(); ++i) {
+				if (i == insertAt && entry != nullptr)
+					result.push_back(*entry);
+				if (i < entries.size() && i != skip)
+					result.push_back(entries[i]);
+			}
+			return result;
+		}
+
+		static std::vector<EntryType> inserted_(const std::vector<EntryType>& entries, size_t index, const EntryType& entry)
+		{
+			return rebuilt_(entries, size_t(-1), index, &entry);
+		}
+
+		static std::vector<EntryType> erased_(const std::vector<EntryType>& entries, size_t index)
+		{
+			return rebuilt_(entries, index, size_t(-1), nullptr);
+		}
+
+		static std::vector<EntryType> replaced_(const std::vector<EntryType>& entries, size_t index, const EntryType& entry)
+		{
+			return rebuilt_(entries, index, index, &entry);
+		}
+
+		NodePtr_ root_;
+		size_t size_ = 0;
+	};
+
+	// internal, key extraction for Hamt_
+	struct HamtSetKey_
+	{
+		template<typename ItemType>
+		static const ItemType& get(const ItemType& item) { return item; }
+	};
+
+	struct HamtMapKey_
+	{
+		template<typename PairType>
+		static const auto& get(const PairType& pair) { return pair.first; }
+	};
+
+	/// A persistent (immutable) hash map, implemented as a hash array mapped trie.
+	/// Copying the map is O(1) and gives an independent snapshot: with() and without() return new versions
+	/// that share almost all of their structure with the old one, and insert()/erase() (used by add() and
+	/// remove()) replace this map with such a new version, leaving every copy untouched.
+	/// Each update allocates O(log32 n) nodes, lookups are O(log32 n).
+	template<typename KeyType, typename ValueType, typename Hash = FastHash<KeyType>>
+	class PersistentHashMap
+	{
+		using Trie_ = Hamt_<std::pair<const KeyType, ValueType>, KeyType, HamtMapKey_, Hash>;
+
+	public:
+		using key_type = KeyType;
+		using mapped_type = ValueType;
+		using value_type = std::pair<const KeyType, ValueType>;
+		using const_iterator = typename Trie_::const_iterator;
+		using iterator = const_iterator;
+
+		PersistentHashMap() = default;
+
+		PersistentHashMap(std::initializer_list<value_type> items)
+		{
+			for (const auto& item : items)
+				insert(item);
+		}
+
+		const_iterator begin() const { return trie_.begin(); }
+		const_iterator end() const { return trie_.end(); }
+		size_t size() const { return trie_.size(); }
+		bool empty() const { return trie_.size() == 0; }
+
+		/// Returns a pointer to the key-value pair, or nullptr if the key is not in the map.
+		const value_type* find(const KeyType& key) const { return trie_.find(key); }
+
+		size_t count(const KeyType& key) const { return find(key) == nullptr ? 0 : 1; }
+
+		/// Returns a new version of the map with the key set to the value.
+		PersistentHashMap with(const KeyType& key, const ValueType& value) const
+		{
+			return PersistentHashMap(trie_.with(value_type(key, value)));
+		}
+
+		/// Returns a new version of the map without the key.
+		PersistentHashMap without(const KeyType& key) const
+		{
+			return PersistentHashMap(trie_.without(key));
+		}
+
+		/// Makes this map a new version with the key-value pair added.
+		void insert(const value_type& item) { trie_ = trie_.with(item); }
+
+		/// Makes this map a new version without the key.
+		void erase(const KeyType& key) { trie_ = trie_.without(key); }
+
+	private:
+		explicit PersistentHashMap(Trie_ trie) : trie_(std::move(trie)) {}
+
+		Trie_ trie_;
+	};
+
+	/// A persistent (immutable) hash set, implemented as a hash array mapped trie.
+	/// See PersistentHashMap.
+	template<typename ItemType, typename Hash = FastHash<ItemType>>
+	class PersistentHashSet
+	{
+		using Trie_ = Hamt_<ItemType, ItemType, HamtSetKey_, Hash>;
+
+	public:
+		using value_type = ItemType;
+		using const_iterator = typename Trie_::const_iterator;
+		using iterator = const_iterator;
+
+		PersistentHashSet() = default;
+
+		PersistentHashSet(std::initializer_list<ItemType> items)
+		{
+			for (const auto& item : items)
+				insert(item);
+		}
+
+		const_iterator begin() const { return trie_.begin(); }
+		const_iterator end() const { return trie_.end(); }
+		size_t size() const { return trie_.size(); }
+		bool empty() const { return trie_.size() == 0; }
+
+		/// Returns a pointer to the item, or nullptr if it is not in the set.
+		const ItemType* find(const ItemType& item) const { return trie_.find(item); }
+
+		size_t count(const ItemType& item) const { return find(item) == nullptr ? 0 : 1; }
+
+		/// Returns a new version of the set with the item added.
+		PersistentHashSet with(const ItemType& item) const { return PersistentHashSet(trie_.with(item)); }
+
+		/// Returns a new version of the set without the item.
+		PersistentHashSet without(const ItemType& item) const { return PersistentHashSet(trie_.without(item)); }
+
+		/// Makes this set a new version with the item added.
+		void insert(const ItemType& item)
+		{
+			if (find(item) == nullptr)
+				trie_ = trie_.with(item);
+		}
+
+		/// Makes this set a new version without the item.
+		void erase(const ItemType& item) { trie_ = trie_.without(item); }
+
+	private:
+		explicit PersistentHashSet(Trie_ trie) : trie_(std::move(trie)) {}
+
+		Trie_ trie_;
+	};
+
+	/// @name PersistentHashMap and PersistentHashSet overloads
+	/// Overloads of the wrapper functions for the persistent containers.
+	/// add() and remove() make the container a new version; copies taken before are not affected.
+	///@{
+	///
+	/// find() overload for persistent hash map. Returns a pointer to the key-value pair if found, otherwise nullptr.
+	template<typename KeyType, typename ValueType, typename Hash>
+	auto find(const PersistentHashMap<KeyType, ValueType, Hash>& inContainer, const KeyType& item)
+	{
+		return inContainer.find(item);
+	}
+	///
+	/// find() overload for persistent hash set. Returns a pointer to the item if found, otherwise nullptr.
+	template<typename ItemType, typename Hash>
+	auto find(const PersistentHashSet<ItemType, Hash>& inContainer, const ItemType& item)
+	{
+		return inContainer.find(item);
+	}
+	///
+	/// contains() overload for persistent hash map.
+	template<typename KeyType, typename ValueType, typename Hash>
+	bool contains(const PersistentHashMap<KeyType, ValueType, Hash>& container, const KeyType& item)
+	{
+		return container.find(item) != nullptr;
+	}
+	///
+	/// contains() overload for persistent hash set.
+	template<typename ItemType, typename Hash>
+	bool contains(const PersistentHashSet<ItemType, Hash>& container, const ItemType& item)
+	{
+		return container.find(item) != nullptr;
+	}
+	///
+	/// count() overload for persistent hash map.
+	template<typename KeyType, typename ValueType, typename Hash>
+	size_t count(const PersistentHashMap<KeyType, ValueType, Hash>& inContainer, const KeyType& item)
+	{
+		return inContainer.count(item);
+	}
+	///
+	/// count() overload for persistent hash set.
+	template<typename ItemType, typename Hash>
+	size_t count(const PersistentHashSet<ItemType, Hash>& inContainer, const ItemType& item)
+	{
+		return inContainer.count(item);
+	}
+	///
+	/// add() overload for persistent hash set.
+	template<typename ItemType, typename Hash>
+	void add(PersistentHashSet<ItemType, Hash>& inContainer, const ItemType& item)
+	{
+		inContainer.insert(item);
+	}
+	///
+	/// add() overload for adding a key-value pair to a persistent hash map.
+	template<typename KeyType, typename ValueType, typename Hash, typename PairType>
+	void add(PersistentHashMap<KeyType, ValueType, Hash>& inContainer, const PairType& item)
+	{
+		inContainer.insert(typename PersistentHashMap<KeyType, ValueType, Hash>::value_type(item.first, item.second));
+	}
+	///
+	/// add() overload for adding a key and value to a persistent hash map.
+	template<typename KeyType, typename ValueType, typename Hash>
+	void add(PersistentHashMap<KeyType, ValueType, Hash>& inMap, const KeyType& key, const ValueType& value)
+	{
+		inMap = inMap.with(key, value);
+	}
+	///
+	/// remove() overload for persistent hash map.
+	template<typename KeyType, typename ValueType, typename Hash>
+	void remove(PersistentHashMap<KeyType, ValueType, Hash>& fromContainer, const KeyType& item)
+	{
+		fromContainer.erase(item);
+	}
+	///
+	/// remove() overload for persistent hash set.
+	template<typename ItemType, typename Hash>
+	void remove(PersistentHashSet<ItemType, Hash>& fromContainer, const ItemType& item)
+	{
+		fromContainer.erase(item);
+	}
+	///@}
+
+	/// A copy-on-write wrapper around a container.
+	/// Copies of a Cow share one (immutable) container with an atomic count of its owners, so passing a Cow
+	/// by value is O(1), also between threads. The container is cloned only when a shared Cow is first
+	/// modified (through add(), remove(), addAll() or mutate()); after that the modified Cow owns its own copy.
+	/// Searching (find(), contains(), count(), ...) goes straight to the shared container.
+	/// A default constructed or moved-from Cow is empty (and holds no container until it is modified).
+	template<typename ContainerType>
+	class Cow
+	{
+		struct Shared_
+		{
+			template<typename... Args>
+			explicit Shared_(Args&&... args) : container(std::forward<Args>(args)...) {}
+
+			ContainerType container;
+			std::atomic<size_t> owners{ 1 };
+		};
+
+	public:
+		using value_type = typename ContainerType::value_type;
+		using const_iterator = typename ContainerType::const_iterator;
+		using iterator = const_iterator;
+
+		Cow() = default;
+		Cow(ContainerType container) : data_(new Shared_(std::move(container))) {}
+		Cow(std::initializer_list<value_type> items) : data_(new Shared_(items)) {}
+
+		Cow(const Cow& other) : data_(other.data_)
+		{
+			if (data_ != nullptr)
+				data_->owners.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		Cow(Cow&& other) noexcept : data_(std::exchange(other.data_, nullptr)) {}
+
+		Cow& operator=(Cow other) noexcept
+		{
+			std::swap(data_, other.data_);
+			return *this;
+		}
+
+		~Cow() { release_(); }
+
+		/// Returns the (possibly shared) container, for reading.
+		const ContainerType& get() const { return data_ != nullptr ? data_->container : empty_(); }
+		const ContainerType& operator*() const { return get(); }
+		const ContainerType* operator->() const { return &get(); }
+
+		/// Returns the container for modification, cloning it first if it is shared with another Cow.
+		ContainerType& mutate()
+		{
+			if (data_ == nullptr)
+				data_ = new Shared_();
+			else if (data_->owners.load(std::memory_order_acquire) != 1) {
+				Shared_* copy = new Shared_(data_->container);
+				release_();
+				data_ = copy;
+			}
+			return data_->container;
+		}
+
+		/// Returns true if the container is currently shared with another Cow.
+		bool isShared() const { return data_ != nullptr && data_->owners.load(std::memory_order_acquire) != 1; }
+
+		const_iterator begin() const { return std::cbegin(get()); }
+		const_iterator end() const { return std::cend(get()); }
+		size_t size() const { return std::size(get()); }
+		bool empty() const { return std::size(get()) == 0; }
+
+	private:
+		// the acquire/release pair makes the reads of the other owners happen before a sole owner modifies
+		void release_()
+		{
+			if (data_ != nullptr && data_->owners.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				delete data_;
+		}
+
+		static const ContainerType& empty_()
+		{
+			static const ContainerType empty;
+			return empty;
+		}
+
+		Shared_* data_ = nullptr;
+	};
+
+	/// @name Cow overloads
+	/// Overloads of the wrapper functions for Cow, they forward to the overload for the wrapped container.
+	/// find(), contains() and count() never copy, add() and remove() copy the container only if it is shared.
+	///@{
+	///
+	/// find() overload for cow, returns what find() returns for the wrapped container.
+	template<typename ContainerType, typename ItemType>
+	auto find(const Cow<ContainerType>& inContainer, const ItemType& item)
+	{
+		return find(inContainer.get(), item);
+	}
+	///
+	/// contains() overload for cow.
+	template<typename ContainerType, typename ItemType>
+	bool contains(const Cow<ContainerType>& container, const ItemType& item)
+	{
+		return contains(container.get(), item);
+	}
+	///
+	/// count() overload for cow.
+	template<typename ContainerType, typename ItemType>
+	size_t count(const Cow<ContainerType>& inContainer, const ItemType& item)
+	{
+		return count(inContainer.get(), item);
+	}
+	///
+	/// add() overload for cow.
+	template<typename ContainerType, typename ItemType>
+	void add(Cow<ContainerType>& inContainer, const ItemType& item)
+	{
+		add(inContainer.mutate(), item);
+	}
+	///
+	/// add() overload for a cow wrapping a map.
+	template<typename ContainerType, typename KeyType, typename ValueType>
+	void add(Cow<ContainerType>& inMap, const KeyType& key, const ValueType& value)
+	{
+		add(inMap.mutate(), key, value);
+	}
+	///
+	/// remove() overload for cow.
+	template<typename ContainerType, typename ItemType>
+	void remove(Cow<ContainerType>& fromContainer, const ItemType& item)
+	{
+		remove(fromContainer.mutate(), item);
+	}
+	///@}
+
+	/// A map from strings to values, implemented as an adaptive radix tree (ART).
+	/// Keys are split into bytes and each node branches on one byte, so keys sharing a prefix share the
+	/// nodes (and storage) of that prefix. Runs of nodes with a single child are collapsed into the
+	/// prefix of one node (path compression). Nodes grow and shrink between four layouts depending on
+	/// their number of children (4, 16, 48 and 256 children), and 16-child nodes are searched with SIMD
+	/// where available.
+	/// find(), add() and remove() are O(k) where k is the key length, independent of the number of keys.
+	/// Iteration visits the keys in (byte wise) sorted order, and keys can be searched by prefix
+	/// (see containsPrefix() and findByPrefix()).
+	template<typename ValueType>
+	class RadixTreeMap
+	{
+		struct Node_
+		{
+			enum Kind_ : uint8_t { node4, node16, node48, node256 };
+
+			explicit Node_(Kind_ kind) : kind(kind) {}
+			virtual ~Node_() = default;
+
+			Kind_ kind;
+			uint16_t childCount = 0;
+			std::string prefix; // bytes matched by this node before branching on the next byte
+			std::optional<ValueType> value; // value of the key ending at this node (if any)
+		};
+
+		struct Node4_ : Node_
+		{
+			Node4_() : Node_(Node_::node4) {}
+			uint8_t keys[4] = {}; // sorted
+			std::unique_ptr<Node_> children[4];
+		};
+
+		struct Node16_ : Node_
+		{
+			Node16_() : Node_(Node_::node16) {}
+			uint8_t keys[16] = {}; // sorted
+			std::unique_ptr<Node_> children[16];
+		};
+
+		struct Node48_ : Node_
+		{
+			Node48_() : Node_(Node_::node48) {}
+			uint8_t slots[256] = {}; // slot of the child for each byte, plus 1 (0 means no child)
+			std::unique_ptr<Node_> children[48];
+		};
+
+		struct Node256_ : Node_
+		{
+			Node256_() : Node_(Node_::node256) {}
+			std::unique_ptr<Node_> children[256];
+		};
+
+	public:
+		using key_type = std::string;
+		using mapped_type = ValueType;
+		using value_type = std::pair<const std::string&, const ValueType&>;
+
+		/// Iterates over the key-value pairs in sorted key order.
+		/// Dereferencing gives a pair of references to the key and the value, valid until the iterator moves.
+		class const_iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::pair<const std::string&, const ValueType&>;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = value_type;
+
+			const_iterator() = default;
+
+			// iterates over the subtree of 'node', whose keys all start with 'key'
+			const_iterator(const Node_* node, std::string key) : key_(std::move(key))
+			{
+				if (node != nullptr) {
+					stack_.push_back(Frame_{ node, -1, key_.size() });
+					advance_();
+				}
+			}
+
+			/// Returns an iterator to the key in the tree rooted at 'root', or the end iterator if it isn't there.
+			static const_iterator seek_(const Node_* root, std::string_view key)
+			{
+				const_iterator result;
+				const Node_* node = root;
+				size_t depth = 0;
+				while (node != nullptr) {
+					const std::string& prefix = node->prefix;
+					if (key.size() - depth < prefix.size() || key.compare(depth, prefix.size(), prefix) != 0)
+						break;
+					depth += prefix.size();
+					if (depth == key.size()) {
+						if (!node->value)
+							break;
+						result.stack_.push_back(Frame_{ node, 0, depth });
+						result.key_ = std::string(key);
+						return result;
+					}
+					uint8_t byte = static_cast<uint8_t>(key[depth]);
+					const std::unique_ptr<Node_>* child = findChild_(node, byte);
+					if (child == nullptr)
+						break;
+					result.stack_.push_back(Frame_{ node, byte + 1, depth });
+					node = child->get();
+					++depth;
+				}
+				return const_iterator();
+			}
+
+			struct ArrowProxy_
+			{
+				value_type pair;
+				const value_type* operator->() const { return &pair; }
+			};
+
+			reference operator*() const { return reference(key_, *stack_.back().node->value); }
+			ArrowProxy_ operator->() const { return ArrowProxy_{ **this }; }
+			const std::string& key() const { return key_; }
+			const ValueType& value() const { return *stack_.back().node->value; }
+			const_iterator& operator++() { advance_(); return *this; }
+			const_iterator operator++(int) { const_iterator old = *this; advance_(); return old; }
+			bool operator==(const const_iterator& other) const
+			{
+				if (stack_.empty() || other.stack_.empty())
+					return stack_.empty() == other.stack_.empty();
+				return stack_.back().node == other.stack_.back().node;
+			}
+			bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+		private:
+			struct Frame_
+			{
+				const Node_* node;
+				int nextByte; // next child to visit, -1 if the node's own value hasn't been visited yet
+				size_t keyLength; // length of the key up to (and including) the node's prefix
+			};
+
+			// moves to the next node that holds a value (depth first, in byte order), or to the end
+			void advance_()
+			{
+				while (!stack_.empty()) {
+					Frame_& frame = stack_.back();
+					if (frame.nextByte < 0) {
+						frame.nextByte = 0;
+						if (frame.node->value)
+							return;
+					}
+					uint8_t byte = 0;
+					const Node_* child = nextChild_(frame.node, frame.nextByte, byte);
+					if (child == nullptr) {
+						stack_.pop_back();
+						if (!stack_.empty())
+							key_.resize(stack_.back().keyLength);
+						continue;
+					}
+					frame.nextByte = byte + 1;
+					key_.resize(frame.keyLength);
+					key_ += static_cast<char>(byte);
+					key_ += child->prefix;
+					stack_.push_back(Frame_{ child, -1, key_.size() });
+				}
+			}
+
+			std::vector<Frame_> stack_;
+			std::string key_;
+		};
+		using iterator = const_iterator;
+
+		RadixTreeMap() = default;
+
+		RadixTreeMap(std::initializer_list<std::pair<std::string_view, ValueType>> items)
+		{
+			for (const auto& item : items)
+				insert(item.first, item.second);
+		}
+
+		const_iterator begin() const { return const_iterator(root_.get(), root_ ? root_->prefix : std::string()); }
+		const_iterator end() const { return const_iterator(); }
+		size_t size() const { return size_; }
+		bool empty() const { return size_ == 0; }
+		void clear() { root_.reset(); size_ = 0; }
+
+		/// Returns an iterator to the key-value pair, or end() if the key is not in the map.
+		const_iterator find(std::string_view key) const { return const_iterator::seek_(root_.get(), key); }
+
+		size_t count(std::string_view key) const { return find(key) == end() ? 0 : 1; }
+
+		/// Adds the key with the value, unless the key is already in the map.
+		/// Returns a pointer to the value of the key and whether it was added.
+		std::pair<ValueType*, bool> insert(std::string_view key, const ValueType& value)
+		{
+			if (!root_) {
+				root_ = leaf_(key, value);
+				++size_;
+				return { &*root_->value, true };
+			}
+
+			std::unique_ptr<Node_>* slot = &root_;
+			size_t depth = 0;
+			while (true) {
+				Node_* node = slot->get();
+				const std::string& prefix = node->prefix;
+				size_t matched = 0;
+				while (matched < prefix.size() && depth + matched < key.size() && prefix[matched] == key[depth + matched])
+					++matched;
+
+				if (matched < prefix.size()) {
+					// the key leaves the compressed path part way through, split the path at that point
+					std::unique_ptr<Node_> split = std::make_unique<Node4_>();
+					split->prefix = prefix.substr(0, matched);
+					uint8_t oldByte = static_cast<uint8_t>(prefix[matched]);
+					std::unique_ptr<Node_> old = std::move(*slot);
+					old->prefix.erase(0, matched + 1);
+					insertChild_(split.get(), oldByte, std::move(old));
+					ValueType* result;
+					if (depth + matched == key.size()) {
+						split->value = value;
+						result = &*split->value;
+					}
+					else {
+						std::unique_ptr<Node_> leaf = leaf_(key.substr(depth + matched + 1), value);
+						result = &*leaf->value;
+						insertChild_(split.get(), static_cast<uint8_t>(key[depth + matched]), std::move(leaf));
+					}
+					*slot = std::move(split);
+					++size_;
+					return { result, true };
+				}
+
+				depth += prefix.size();
+				if (depth == key.size()) {
+					if (node->value)
+						return { &*node->value, false };
+					node->value = value;
+					++size_;
+					return { &*node->value, true };
+				}
+
+				uint8_t byte = static_cast<uint8_t>(key[depth]);
+				std::unique_ptr<Node_>* child = findChild_(node, byte);
+				if (child == nullptr) {
+					std::unique_ptr<Node_> leaf = leaf_(key.substr(depth + 1), value);
+					ValueType* result = &*leaf->value;
+					addChild_(*slot, byte, std::move(leaf));
+					++size_;
+					return { result, true };
+				}
+				slot = child;
+				++depth;
+			}
+		}
+
+		/// Sets the value of the key, adding the key if it is not in the map.
+		void insertOrAssign(std::string_view key, const ValueType& value)
+		{
+			auto result = insert(key, value);
+			if (!result.second)
+				*result.first = value;
+		}
+
+		/// Removes the key (if it is in the map). Returns true if it was removed.
+		bool erase(std::string_view key)
+		{
+			if (!root_ || !erase_(root_, key, 0))
+				return false;
+			--size_;
+			return true;
+		}
+
+		/// Returns true if any key in the map starts with the prefix.
+		bool containsPrefix(std::string_view prefix) const
+		{
+			std::string key;
+			return subtree_(prefix, key) != nullptr;
+		}
+
+		/// Returns the range [first, last) of the key-value pairs whose key starts with the prefix.
+		std::pair<const_iterator, const_iterator> prefixRange(std::string_view prefix) const
+		{
+			std::string key;
+			const Node_* node = subtree_(prefix, key);
+			return { const_iterator(node, std::move(key)), const_iterator() };
+		}
+
+	private:
+		static std::unique_ptr<Node_> leaf_(std::string_view suffix, const ValueType& value)
+		{
+			std::unique_ptr<Node_> leaf = std::make_unique<Node4_>();
+			leaf->prefix = std::string(suffix);
+			leaf->value = value;
+			return leaf;
+		}
+
+		static std::unique_ptr<Node_> make_(typename Node_::Kind_ kind)
+		{
+			switch (kind) {
+			case Node_::node4: return std::make_unique<Node4_>();
+			case Node_::node16: return std::make_unique<Node16_>();
+			case Node_::node48: return std::make_unique<Node48_>();
+			default: return std::make_unique<Node256_>();
+			}
+		}
+
+		static size_t capacity_(const Node_* node)
+		{
+			static const size_t capacities[] = { 4, 16, 48, 256 };
+			return capacities[node->kind];
+		}
+
+		// finds the position of the byte in a sorted key array (SIMD for 16 keys when available)
+		static int findKey_(const uint8_t* keys, size_t count, uint8_t byte)
+		{
+#if defined(STLWRAPPERS_SSE2_)
+			if (count > 4) {
+				__m128i matches = _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(byte)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys)));
+				uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(matches)) & ((uint32_t(1) << count) - 1);
+				return mask == 0 ? -1 : static_cast<int>(countTrailingZeros32_(mask));
+			}
+#endif
+			for (size_t i = 0; i < count; ++i)
+				if (keys[i] == byte)
+					return static_cast<int>(i);
+			return -1;
+		}
+
+		static std::unique_ptr<Node_>* findChild_(Node_* node, uint8_t byte)
+		{
+			switch (node->kind) {
+			case Node_::node4: {
+				auto n = static_cast<Node4_*>(node);
+				int i = findKey_(n->keys, n->childCount, byte);
+				return i < 0 ? nullptr : &n->children[i];
+			}
+			case Node_::node16: {
+				auto n = static_cast<Node16_*>(node);
+				int i = findKey_(n->keys, n->childCount, byte);
+				return i < 0 ? nullptr : &n->children[i];
+			}
+			case Node_::node48: {
+				auto n = static_cast<Node48_*>(node);
+				return n->slots[byte] == 0 ? nullptr : &n->children[n->slots[byte] - 1];
+			}
+			default: {
+				auto n = static_cast<Node256_*>(node);
+				return n->children[byte] ? &n->children[byte] : nullptr;
+			}
+			}
+		}
+
+		static const std::unique_ptr<Node_>* findChild_(const Node_* node, uint8_t byte)
+		{
+			return findChild_(const_cast<Node_*>(node), byte);
+		}
+
+		// returns the first child whose byte is >= 'fromByte' (and sets 'byte' to its byte), or nullptr
+		static const Node_* nextChild_(const Node_* node, int fromByte, uint8_t& byte)
+		{
+			switch (node->kind) {
+			case Node_::node4:
+			case Node_::node16: {
+				const uint8_t* keys = node->kind == Node_::node4 ? static_cast<const Node4_*>(node)->keys : static_cast<const Node16_*>(node)->keys;
+				const std::unique_ptr<Node_>* children = node->kind == Node_::node4 ? static_cast<const Node4_*>(node)->children : static_cast<const Node16_*>(node)->children;
+				for (size_t i = 0; i < node->childCount; ++i) {
+					if (keys[i] >= fromByte) {
+						byte = keys[i];
+						return children[i].get();
+					}
+				}
+				return nullptr;
+			}
+			case Node_::node48: {
+				auto n = static_cast<const Node48_*>(node);
+				for (int b = fromByte; b < 256; ++b) {
+					if (n->slots[b] != 0) {
+						byte = static_cast<uint8_t>(b);
+						return n->children[n->slots[b] - 1].get();
+					}
+				}
+				return nullptr;
+			}
+			default: {
+				auto n = static_cast<const Node256_*>(node);
+				for (int b = fromByte; b < 256; ++b) {
+					if (n->children[b]) {
+						byte = static_cast<uint8_t>(b);
+						return n->children[b].get();
+					}
+				}
+				return nullptr;
+			}
+			}
+		}
+
+		// adds a child to a node that has room for it
+		static void insertChild_(Node_* node, uint8_t byte, std::unique_ptr<Node_> child)
+		{
+			switch (node->kind) {
+			case Node_::node4:
+			case Node_::node16: {
+				uint8_t* keys = node->kind == Node_::node4 ? static_cast<Node4_*>(node)->keys : static_cast<Node16_*>(node)->keys;
+				std::unique_ptr<Node_>* children = node->kind == Node_::node4 ? static_cast<Node4_*>(node)->children : static_cast<Node16_*>(node)->children;
+				size_t position = 0;
+				while (position < node->childCount && keys[position] < byte)
+					++position;
+				for (size_t i = node->childCount; i > position; --i) {
+					keys[i] = keys[i - 1];
+					children[i] = std::move(children[i - 1]);
+				}
+				keys[position] = byte;
+				children[position] = std::move(child);
+				break;
+			}
+			case Node_::node48: {
+				auto n = static_cast<Node48_*>(node);
+				size_t slot = 0;
+				while (n->children[slot])
+					++slot;
+				n->children[slot] = std::move(child);
+				n->slots[byte] = static_cast<uint8_t>(slot + 1);
+				break;
+			}
+			default:
+				static_cast<Node256_*>(node)->children[byte] = std::move(child);
+				break;
+			}
+			++node->childCount;
+		}
+
+		// moves the node into a node of another kind
+		static std::unique_ptr<Node_> resized_(std::unique_ptr<Node_> node, typename Node_::Kind_ kind)
+		{
+			std::unique_ptr<Node_> result = make_(kind);
+			result->prefix = std::move(node->prefix);
+			result->value = std::move(node->value);
+			uint8_t byte = 0;
+			for (int from = 0; nextChild_(node.get(), from, byte) != nullptr; from = byte + 1)
+				insertChild_(result.get(), byte, std::move(*findChild_(node.get(), byte)));
+			return result;
+		}
+
+		// adds a child, growing the node into the next larger kind if it is full
+		static void addChild_(std::unique_ptr<Node_>& slot, uint8_t byte, std::unique_ptr<Node_> child)
+		{
+			if (slot->childCount == capacity_(slot.get()))
+				slot = resized_(std::move(slot), static_cast<typename Node_::Kind_>(slot->kind + 1));
+			insertChild_(slot.get(), byte, std::move(child));
+		}
+
+		// removes a child, shrinking the node into the next smaller kind if it has become sparse
+		static void removeChild_(std::unique_ptr<Node_>& slot, uint8_t byte)
+		{
+			Node_* node = slot.get();
+			switch (node->kind) {
+			case Node_::node4:
+			case Node_::node16: {
+				uint8_t* keys = node->kind == Node_::node4 ? static_cast<Node4_*>(node)->keys : static_cast<Node16_*>(node)->keys;
+				std::unique_ptr<Node_>* children = node->kind == Node_::node4 ? static_cast<Node4_*>(node)->children : static_cast<Node16_*>(node)->children;
+				size_t position = static_cast<size_t>(findKey_(keys, node->childCount, byte));
+				for (size_t i = position; i + 1 < node->childCount; ++i) {
+					keys[i] = keys[i + 1];
+					children[i] = std::move(children[i + 1]);
+				}
+				children[node->childCount - 1].reset();
+				break;
+			}
+			case Node_::node48: {
+				auto n = static_cast<Node48_*>(node);
+				n->children[n->slots[byte] - 1].reset();
+				n->slots[byte] = 0;
+				break;
+			}
+			default:
+				static_cast<Node256_*>(node)->children[byte].reset();
+				break;
+			}
+			--node->childCount;
+
+			// shrink with some slack, so a node at the boundary doesn't flip back and forth
+			static const size_t shrinkAt[] = { 0, 3, 12, 37 };
+			if (node->kind != Node_::node4 && node->childCount <= shrinkAt[node->kind])
+				slot = resized_(std::move(slot), static_cast<typename Node_::Kind_>(node->kind - 1));
+		}
+
+		// removes the key from the subtree in 'slot', returns false if it isn't there
+		static bool erase_(std::unique_ptr<Node_>& slot, std::string_view key, size_t depth)
+		{
+			Node_* node = slot.get();
+			const std::string& prefix = node->prefix;
+			if (key.size() - depth < prefix.size() || key.compare(depth, prefix.size(), prefix) != 0)
+				return false;
+			depth += prefix.size();
+
+			if (depth == key.size()) {
+				if (!node->value)
+					return false;
+				node->value.reset();
+			}
+			else {
+				uint8_t byte = static_cast<uint8_t>(key[depth]);
+				std::unique_ptr<Node_>* child = findChild_(node, byte);
+				if (child == nullptr || !erase_(*child, key, depth + 1))
+					return false;
+				if (!*child)
+					removeChild_(slot, byte);
+			}
+
+			// remove nodes that no longer lead anywhere, and collapse single child chains back into a prefix
+			node = slot.get();
+			if (!node->value && node->childCount == 0)
+				slot.reset();
+			else if (!node->value && node->childCount == 1) {
+				uint8_t byte = 0;
+				nextChild_(node, 0, byte);
+				std::unique_ptr<Node_> child = std::move(*findChild_(node, byte));
+				child->prefix = node->prefix + static_cast<char>(byte) + child->prefix;
+				slot = std::move(child);
+			}
+			return true;
+		}
+
+		// finds the highest node whose subtree holds exactly the keys starting with the prefix,
+		// and sets 'key' to the key bytes leading up to (and including the prefix of) that node
+		const Node_* subtree_(std::string_view prefix, std::string& key) const
+		{
+			const Node_* node = root_.get();
+			size_t depth = 0;
+			while (node != nullptr) {
+				const std::string& nodePrefix = node->prefix;
+				size_t remaining = prefix.size() - depth;
+				if (remaining <= nodePrefix.size()) {
+					if (nodePrefix.compare(0, remaining, prefix.substr(depth)) != 0)
+						return nullptr;
+					key += nodePrefix;
+					return node;
+				}
+				if (prefix.compare(depth, nodePrefix.size(), nodePrefix) != 0)
+					return nullptr;
+				key += nodePrefix;
+				depth += nodePrefix.size();
+				const std::unique_ptr<Node_>* child = findChild_(node, static_cast<uint8_t>(prefix[depth]));
+				if (child == nullptr)
+					return nullptr;
+				key += prefix[depth];
+				node = child->get();
+				++depth;
+			}
+			return nullptr;
+		}
+
+		std::unique_ptr<Node_> root_;
+		size_t size_ = 0;
+	};
+
+	/// A set of strings, implemented as an adaptive radix tree. See RadixTreeMap.
+	class RadixTreeSet
+	{
+		struct Empty_ {};
+		using Map_ = RadixTreeMap<Empty_>;
+
+	public:
+		using value_type = std::string;
+
+		/// Iterates over the strings in sorted order.
+		class const_iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::string;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const std::string*;
+			using reference = const std::string&;
+
+			const_iterator() = default;
+			explicit const_iterator(Map_::const_iterator position) : position_(std::move(position)) {}
+
+			reference operator*() const { return position_.key(); }
+			pointer operator->() const { return &position_.key(); }
+			const_iterator& operator++() { ++position_; return *this; }
+			const_iterator operator++(int) { const_iterator old = *this; ++position_; return old; }
+			bool operator==(const const_iterator& other) const { return position_ == other.position_; }
+			bool operator!=(const const_iterator& other) const { return position_ != other.position_; }
+
+		private:
+			Map_::const_iterator position_;
+		};
+		using iterator = const_iterator;
+
+		RadixTreeSet() = default;
+
+		RadixTreeSet(std::initializer_list<std::string_view> items)
+		{
+			for (const auto& item : items)
+				insert(item);
+		}
+
+		const_iterator begin() const { return const_iterator(map_.begin()); }
+		const_iterator end() const { return const_iterator(map_.end()); }
+		size_t size() const { return map_.size(); }
+		bool empty() const { return map_.empty(); }
+		void clear() { map_.clear(); }
+
+		/// Returns an iterator to the string, or end() if it is not in the set.
+		const_iterator find(std::string_view item) const { return const_iterator(map_.find(item)); }
+		size_t count(std::string_view item) const { return map_.count(item); }
+
+		/// Adds the string, returns true if it wasn't already in the set.
+		bool insert(std::string_view item) { return map_.insert(item, Empty_{}).second; }
+
+		/// Removes the string, returns true if it was in the set.
+		bool erase(std::string_view item) { return map_.erase(item); }
+
+		/// Returns true if any string in the set starts with the prefix.
+		bool containsPrefix(std::string_view prefix) const { return map_.containsPrefix(prefix); }
+
+		/// Returns the range [first, last) of the strings that start with the prefix.
+		std::pair<const_iterator, const_iterator> prefixRange(std::string_view prefix) const
+		{
+			auto range = map_.prefixRange(prefix);
+			return { const_iterator(range.first), const_iterator(range.second) };
+		}
+
+	private:
+		Map_ map_;
+	};
+
+	/// @name RadixTreeMap and RadixTreeSet overloads
+	/// Overloads of the wrapper functions for the radix tree containers.
+	/// Keys can be anything convertible to a std::string_view (std::string, const char*, ...).
+	/// Complexity of all of these is O(k) where k is the length of the key.
+	///@{
+	///
+	/// find() overload for radix tree map.
+	template<typename ValueType, typename KeyType>
+	auto find(const RadixTreeMap<ValueType>& inContainer, const KeyType& item)
+	{
+		return inContainer.find(std::string_view(item));
+	}
+	///
+	/// find() overload for radix tree set.
+	template<typename KeyType>
+	auto find(const RadixTreeSet& inContainer, const KeyType& item)
+	{
+		return inContainer.find(std::string_view(item));
+	}
+	///
+	/// count() overload for radix tree map.
+	template<typename ValueType, typename KeyType>
+	size_t count(const RadixTreeMap<ValueType>& inContainer, const KeyType& item)
+	{
+		return inContainer.count(std::string_view(item));
+	}
+	///
+	/// count() overload for radix tree set.
+	template<typename KeyType>
+	size_t count(const RadixTreeSet& inContainer, const KeyType& item)
+	{
+		return inContainer.count(std::string_view(item));
+	}
+	///
+	/// add() overload for radix tree set.
+	template<typename KeyType>
+	void add(RadixTreeSet& inContainer, const KeyType& item)
+	{
+		inContainer.insert(std::string_view(item));
+	}
+	///
+	/// add() overload for adding a key-value pair to a radix tree map.
+	template<typename ValueType, typename PairType>
+	void add(RadixTreeMap<ValueType>& inContainer, const PairType& item)
+	{
+		inContainer.insertOrAssign(std::string_view(item.first), item.second);
+	}
+	///
+	/// add() overload for adding a key and value to a radix tree map.
+	template<typename ValueType, typename KeyType>
+	void add(RadixTreeMap<ValueType>& inMap, const KeyType& key, const ValueType& value)
+	{
+		inMap.insertOrAssign(std::string_view(key), value);
+	}
+	///
+	/// remove() overload for radix tree map.
+	template<typename ValueType, typename KeyType>
+	void remove(RadixTreeMap<ValueType>& fromContainer, const KeyType& item)
+	{
+		fromContainer.erase(std::string_view(item));
+	}
+	///
+	/// remove() overload for radix tree set.
+	template<typename KeyType>
+	void remove(RadixTreeSet& fromContainer, const KeyType& item)
+	{
+		fromContainer.erase(std::string_view(item));
+	}
+	///@}
+
+	/// @name containsPrefix(container, prefix)
+	/// Returns true if any key in the radix tree container starts with the prefix. Complexity is O(k)
+	/// where k is the length of the prefix.
+	///@{
+	///
+	template<typename ValueType>
+	bool containsPrefix(const RadixTreeMap<ValueType>& container, std::string_view prefix)
+	{
+		return container.containsPrefix(prefix);
+	}
+	///
+	inline bool containsPrefix(const RadixTreeSet& container, std::string_view prefix)
+	{
+		return container.containsPrefix(prefix);
+	}
+	///@}
+
+	/// @name findByPrefix(inContainer, prefix)
+	/// Returns (in sorted order) all the keys in the radix tree container that start with the prefix.
+	/// Complexity is O(k + m) where k is the length of the prefix and m the total length of the keys found.
+	///@{
+	///
+	template<typename ValueType>
+	std::vector<std::string> findByPrefix(const RadixTreeMap<ValueType>& inContainer, std::string_view prefix)
+	{
+		std::vector<std::string> results;
+		auto range = inContainer.prefixRange(prefix);
+		for (auto itr = range.first; itr != range.second; ++itr)
+			results.push_back(itr.key());
+		return results;
+	}
+	///
+	inline std::vector<std::string> findByPrefix(const RadixTreeSet& inContainer, std::string_view prefix)
+	{
+		auto range = inContainer.prefixRange(prefix);
+		return std::vector<std::string>(range.first, range.second);
+	}
+	///@}
+
+	/// A position in a text where one of the patterns of a MultiPattern matched.
+	struct SubstringMatch
+	{
+		size_t position; ///< index in the text of the first character of the match
+		size_t pattern; ///< index of the pattern that matched
+
+		bool operator==(const SubstringMatch& other) const { return position == other.position && pattern == other.pattern; }
+		bool operator!=(const SubstringMatch& other) const { return !(*this == other); }
+	};
+
+	/// A set of patterns compiled into an Aho-Corasick automaton, to search a text for all of them at once.
+	/// The text is scanned exactly once, no matter how many patterns there are. While no partial match is in
+	/// progress, the scan skips ahead to the next byte that can start a pattern (comparing 16 bytes at a time
+	/// with SIMD when the patterns start with only a few distinct bytes).
+	/// Compile once and reuse it, building the automaton is O(total length of the patterns).
+	/// @note Empty patterns never match. If a pattern appears more than once, matches report its first index.
+	class MultiPattern
+	{
+		struct State_
+		{
+			uint32_t firstEdge = 0; // edges of a state are sorted by byte
+			uint32_t edgeCount = 0;
+			uint32_t fail = 0; // state of the longest proper suffix that is also a pattern prefix
+			uint32_t output = 0; // nearest state on the fail chain that ends a pattern (0 for none)
+			int32_t pattern = -1; // pattern ending at this state
+		};
+
+		struct Edge_
+		{
+			uint8_t byte;
+			uint32_t target;
+		};
+
+	public:
+		MultiPattern(std::initializer_list<std::string_view> patterns)
+		{
+			build_(patterns);
+		}
+
+		/// Compiles the patterns in a container (of std::string, std::string_view, const char*, ...).
+		template<typename ContainerType>
+		explicit MultiPattern(const ContainerType& patterns)
+		{
+			build_(patterns);
+		}
+
+		size_t patternCount() const { return patterns_.size(); }
+		const std::string& pattern(size_t index) const { return patterns_[index]; }
+
+		/// Calls 'function(match)' for every match in the text, in order of the end of the match.
+		/// Stops early if 'function' returns true.
+		template<typename Function>
+		void scan(std::string_view text, Function function) const
+		{
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(text.data());
+			size_t size = text.size();
+			uint32_t state = 0;
+			for (size_t i = 0; i < size; ++i) {
+				if (state == 0) {
+					i = nextCandidate_(bytes, i, size);
+					if (i == size)
+						return;
+				}
+				state = next_(state, bytes[i]);
+				uint32_t found = states_[state].pattern >= 0 ? state : states_[state].output;
+				while (found != 0) {
+					size_t pattern = static_cast<size_t>(states_[found].pattern);
+					if (function(SubstringMatch{ i + 1 - patterns_[pattern].size(), pattern }))
+						return;
+					found = states_[found].output;
+				}
+			}
+		}
+
+		/// Returns true if any of the patterns occurs in the text.
+		bool matchesAny(std::string_view text) const
+		{
+			bool found = false;
+			scan(text, [&found](const SubstringMatch&) { return found = true; });
+			return found;
+		}
+
+	private:
+		template<typename ContainerType>
+		void build_(const ContainerType& patterns)
+		{
+			// build the trie of the patterns
+			std::vector<std::vector<Edge_>> edges(1);
+			states_.assign(1, State_{});
+			for (const auto& pattern : patterns) {
+				std::string_view text(pattern);
+				patterns_.emplace_back(text);
+				if (text.empty())
+					continue;
+				uint32_t state = 0;
+				for (char c : text) {
+					uint8_t byte = static_cast<uint8_t>(c);
+					auto& out = edges[state];
+					auto edge = std::find_if(out.begin(), out.end(), [byte](const Edge_& e) { return e.byte == byte; });
+					if (edge != out.end()) {
+						state = edge->target;
+						continue;
+					}
+					uint32_t target = static_cast<uint32_t>(states_.size());
+					out.push_back(Edge_{ byte, target });
+					states_.push_back(State_{});
+					edges.emplace_back();
+					state = target;
+				}
+				if (states_[state].pattern < 0)
+					states_[state].pattern = static_cast<int32_t>(patterns_.size() - 1);
+			}
+
+			// flatten the edges, sorted by byte
+			for (size_t state = 0; state < edges.size(); ++state) {
+				std::sort(edges[state].begin(), edges[state].end(), [](const Edge_& a, const Edge_& b) { return a.byte < b.byte; });
+				states_[state].firstEdge = static_cast<uint32_t>(edges_.size());
+				states_[state].edgeCount = static_cast<uint32_t>(edges[state].size());
+				edges_.insert(edges_.end(), edges[state].begin(), edges[state].end());
+			}
+			for (size_t byte = 0; byte < 256; ++byte)
+				rootNext_[byte] = 0;
+			for (const auto& edge : edges[0])
+				rootNext_[edge.byte] = edge.target;
+
+			// breadth first, so the fail state of a state's parent is done before the state itself
+			std::vector<uint32_t> queue;
+			for (const auto& edge : edges[0])
+				queue.push_back(edge.target);
+			for (size_t head = 0; head < queue.size(); ++head) {
+				uint32_t state = queue[head];
+				for (const auto& edge : edges[state]) {
+					State_& child = states_[edge.target];
+					child.fail = state == 0 ? 0 : next_(states_[state].fail, edge.byte);
+					const State_& fail = states_[child.fail];
+					child.output = fail.pattern >= 0 ? child.fail : fail.output;
+					queue.push_back(edge.target);
+				}
+			}
+
+			// bytes that can start a match, for skipping ahead while at the root
+			for (const auto& edge : edges[0])
+				firstBytes_.push_back(edge.byte);
+		}
+
+		// goto function of the automaton, following fail links for missing edges
+		uint32_t next_(uint32_t state, uint8_t byte) const
+		{
+			while (state != 0) {
+				const State_& current = states_[state];
+				const Edge_* first = edges_.data() + current.firstEdge;
+				const Edge_* last = first + current.edgeCount;
+				const Edge_* edge = std::lower_bound(first, last, byte, [](const Edge_& e, uint8_t b) { return e.byte < b; });
+				if (edge != last && edge->byte == byte)
+					return edge->target;
+				state = current.fail;
+			}
+			return rootNext_[byte];
+		}
+
+		// returns the index of the first byte at or after 'from' that can start a pattern (or 'size')
+		size_t nextCandidate_(const uint8_t* bytes, size_t from, size_t size) const
+		{
+			if (firstBytes_.size() == 1) {
+				const void* found = std::memchr(bytes + from, firstBytes_[0], size - from);
+				return found == nullptr ? size : static_cast<size_t>(static_cast<const uint8_t*>(found) - bytes);
+			}
+#if defined(STLWRAPPERS_SSE2_)
+			if (firstBytes_.size() <= 8) {
+				for (; from + 16 <= size; from += 16) {
+					__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + from));
+					__m128i hits = _mm_setzero_si128();
+					for (uint8_t byte : firstBytes_)
+						hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, _mm_set1_epi8(static_cast<char>(byte))));
+					uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+					if (mask != 0)
+						return from + countTrailingZeros32_(mask);
+				}
+			}
+#endif
+			for (; from < size; ++from)
+				if (rootNext_[bytes[from]] != 0)
+					return from;
+			return size;
+		}
+
+		std::vector<std::string> patterns_;
+		std::vector<State_> states_; // state 0 is the root
+		std::vector<Edge_> edges_;
+		uint32_t rootNext_[256];
+		std::vector<uint8_t> firstBytes_;
+	};
+
+	/// @name containsAnySubstring(text, patterns)
+	/// Returns true if the text contains *any* of the patterns as a substring.
+	/// `patterns` can be a compiled MultiPattern, or an initializer list or container of strings (which is
+	/// compiled for the call, so compile a MultiPattern yourself if you search for the same patterns often).
+	/// Complexity is linear in the length of the text, no matter how many patterns there are.
+	///@{
+	///
+	inline bool containsAnySubstring(std::string_view text, const MultiPattern& patterns)
+	{
+		return patterns.matchesAny(text);
+	}
+	///
+	template<typename ContainerOfPatterns>
+	bool containsAnySubstring(std::string_view text, const ContainerOfPatterns& patterns)
+	{
+		return MultiPattern(patterns).matchesAny(text);
+	}
+	///
+	inline bool containsAnySubstring(std::string_view text, std::initializer_list<std::string_view> patterns)
+	{
+		return MultiPattern(patterns).matchesAny(text);
+	}
+	///@}
+
+	/// @name findAllSubstrings(text, patterns)
+	/// Returns every occurrence of any of the patterns in the text (overlapping ones included), in order of
+	/// where each occurrence ends. `patterns` can be anything containsAnySubstring() takes.
+	/// Complexity is linear in the length of the text plus the number of matches.
+	///@{
+	///
+	inline std::vector<SubstringMatch> findAllSubstrings(std::string_view text, const MultiPattern& patterns)
+	{
+		std::vector<SubstringMatch> results;
+		patterns.scan(text, [&results](const SubstringMatch& match) {
+			results.push_back(match);
+			return false;
+		});
+		return results;
+	}
+	///
+	template<typename ContainerOfPatterns>
+	std::vector<SubstringMatch> findAllSubstrings(std::string_view text, const ContainerOfPatterns& patterns)
+	{
+		return findAllSubstrings(text, MultiPattern(patterns));
+	}
+	///
+	inline std::vector<SubstringMatch> findAllSubstrings(std::string_view text, std::initializer_list<std::string_view> patterns)
+	{
+		return findAllSubstrings(text, MultiPattern(patterns));
+	}
+	///@}
+
+	// internal, bump allocator. Allocation just advances a pointer within a large block, and everything
+	// is freed at once (when the arena is cleared or destroyed).
+	class Arena_
+	{
+	public:
+		explicit Arena_(size_t blockSize = 64 * 1024) : blockSize_(blockSize) {}
+
+		// a moved-from arena is empty, so it never hands out memory from a block it no longer owns
+		Arena_(Arena_&& other) noexcept
+			: blocks_(std::move(other.blocks_)), next_(std::exchange(other.next_, nullptr)), remaining_(std::exchange(other.remaining_, 0)),
+			blockSize_(other.blockSize_), bytes_(std::exchange(other.bytes_, 0))
+		{
+			other.blocks_.clear();
+		}
+
+		Arena_& operator=(Arena_&& other) noexcept
+		{
+			if (this != &other) {
+				blocks_ = std::move(other.blocks_);
+				other.blocks_.clear();
+				next_ = std::exchange(other.next_, nullptr);
+				remaining_ = std::exchange(other.remaining_, 0);
+				blockSize_ = other.blockSize_;
+				bytes_ = std::exchange(other.bytes_, 0);
+			}
+			return *this;
+		}
+
+		char* allocate(size_t size)
+		{
+			if (size > blockSize_ / 4) {
+				// big allocations get a block of their own, so they don't waste the rest of the current block
+				blocks_.emplace_back(new char[size]);
+				bytes_ += size;
+				return blocks_.back().get();
+			}
+			if (remaining_ < size) {
+				blocks_.emplace_back(new char[blockSize_]);
+				next_ = blocks_.back().get();
+				remaining_ = blockSize_;
+				bytes_ += blockSize_;
+			}
+			char* result = next_;
+			next_ += size;
+			remaining_ -= size;
+			return result;
+		}
+
+		/// Copies the string into the arena and returns a view of the copy.
+		std::string_view copy(std::string_view text)
+		{
+			char* data = allocate(text.size());
+			if (!text.empty())
+				std::memcpy(data, text.data(), text.size());
+			return std::string_view(data, text.size());
+		}
+
+		void clear()
+		{
+			blocks_.clear();
+			next_ = nullptr;
+			remaining_ = 0;
+			bytes_ = 0;
+		}
+
+		/// Returns the number of bytes allocated from the system.
+		size_t bytes() const { return bytes_; }
+
+	private:
+		std::vector<std::unique_ptr<char[]>> blocks_;
+		char* next_ = nullptr;
+		size_t remaining_ = 0;
+		size_t blockSize_;
+		size_t bytes_ = 0;
+	};
+
+	/// Compact identifier of a string interned in a StringPool.
+	struct StringId
+	{
+		uint32_t value;
+
+		bool operator==(const StringId& other) const { return value == other.value; }
+		bool operator!=(const StringId& other) const { return value != other.value; }
+		bool operator<(const StringId& other) const { return value < other.value; }
+
+		/// Hash function for StringId (ids are dense, so the id itself is a perfect hash).
+		struct Hash
+		{
+			size_t operator()(const StringId& id) const { return id.value; }
+		};
+	};
+
+	/// Stores each distinct string once (in an arena) and gives it a compact StringId.
+	/// Interning the same string twice gives the same id, so strings can be compared by comparing their ids.
+	/// The hash of every string is computed once and cached.
+	/// Views and ids stay valid until the pool is cleared or destroyed.
+	class StringPool
+	{
+		struct Entry_
+		{
+			std::string_view text;
+			size_t hash;
+		};
+
+	public:
+		StringPool() { slots_.assign(16, 0); }
+
+		// the ids and views of the strings move with the pool, and the moved-from pool is left empty
+		StringPool(StringPool&& other) : arena_(std::move(other.arena_)), entries_(std::move(other.entries_)), slots_(std::move(other.slots_))
+		{
+			other.clear();
+		}
+
+		StringPool& operator=(StringPool&& other)
+		{
+			if (this != &other) {
+				arena_ = std::move(other.arena_);
+				entries_ = std::move(other.entries_);
+				slots_ = std::move(other.slots_);
+				other.clear();
+			}
+			return *this;
+		}
+
+		/// Returns the id of the string, adding it to the pool if it isn't already there.
+		StringId intern(std::string_view text)
+		{
+			size_t hash = hash_(text);
+			size_t slot = probe_(text, hash);
+			if (slots_[slot] != 0)
+				return StringId{ slots_[slot] - 1 };
+
+			uint32_t id = static_cast<uint32_t>(entries_.size());
+			entries_.push_back(Entry_{ arena_.copy(text), hash });
+			slots_[slot] = id + 1;
+			if (entries_.size() * 4 > slots_.size() * 3)
+				grow_();
+			return StringId{ id };
+		}
+
+		/// Returns the id of the string if it is in the pool (without adding it).
+		std::optional<StringId> lookup(std::string_view text) const
+		{
+			size_t slot = probe_(text, hash_(text));
+			if (slots_[slot] == 0)
+				return std::nullopt;
+			return StringId{ slots_[slot] - 1 };
+		}
+
+		/// Returns the string with the id.
+		std::string_view view(StringId id) const { return entries_[id.value].text; }
+
+		/// Returns the (cached) hash of the string with the id.
+		size_t hash(StringId id) const { return entries_[id.value].hash; }
+
+		/// Returns the number of distinct strings in the pool.
+		size_t size() const { return entries_.size(); }
+
+		void clear()
+		{
+			entries_.clear();
+			slots_.assign(16, 0);
+			arena_.clear();
+		}
+
+	private:
+		static size_t hash_(std::string_view text)
+		{
+			return FastHash<std::string_view>{}(text);
+		}
+
+		// linear probing, returns the slot holding the string or the empty slot where it would go
+		size_t probe_(std::string_view text, size_t hash) const
+		{
+			size_t mask = slots_.size() - 1;
+			for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+				uint32_t id = slots_[slot];
+				if (id == 0)
+					return slot;
+				const Entry_& entry = entries_[id - 1];
+				if (entry.hash == hash && entry.text == text)
+					return slot;
+			}
+		}
+
+		void grow_()
+		{
+			slots_.assign(slots_.size() * 2, 0);
+			size_t mask = slots_.size() - 1;
+			for (size_t id = 0; id < entries_.size(); ++id) {
+				size_t slot = entries_[id].hash & mask;
+				while (slots_[slot] != 0)
+					slot = (slot + 1) & mask;
+				slots_[slot] = static_cast<uint32_t>(id + 1);
+			}
+		}
+
+		Arena_ arena_;
+		std::vector<Entry_> entries_; // indexed by id
+		std::vector<uint32_t> slots_; // hash index of the entries, id + 1 (0 means empty)
+	};
+
+	/// A set of strings interned in a StringPool.
+	/// The set only stores the (integer) ids of its strings, so strings shared by several sets are stored
+	/// once, and searching by id is an integer hash lookup. Searching by string looks the string up in the
+	/// pool once (one hash, using the pool's cached hashes) and then searches by id.
+	/// Items can be given as strings (anything convertible to std::string_view) or as StringIds.
+	/// @note The pool must outlive the set.
+	class InternedSet
+	{
+		using Set_ = std::unordered_set<StringId, StringId::Hash>;
+
+	public:
+		using value_type = std::string_view;
+
+		/// Iterates over the strings of the set (in no particular order).
+		class const_iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::string_view;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = std::string_view;
+
+			const_iterator() = default;
+			const_iterator(Set_::const_iterator position, const StringPool* pool) : position_(position), pool_(pool) {}
+
+			reference operator*() const { return pool_->view(*position_); }
+			StringId id() const { return *position_; }
+			const_iterator& operator++() { ++position_; return *this; }
+			const_iterator operator++(int) { const_iterator old = *this; ++position_; return old; }
+			bool operator==(const const_iterator& other) const { return position_ == other.position_; }
+			bool operator!=(const const_iterator& other) const { return position_ != other.position_; }
+
+		private:
+			Set_::const_iterator position_;
+			const StringPool* pool_ = nullptr;
+		};
+		using iterator = const_iterator;
+
+		explicit InternedSet(StringPool& pool) : pool_(&pool) {}
+
+		InternedSet(StringPool& pool, std::initializer_list<std::string_view> items) : pool_(&pool)
+		{
+			for (const auto& item : items)
+				insert(item);
+		}
+
+		const_iterator begin() const { return const_iterator(ids_.begin(), pool_); }
+		const_iterator end() const { return const_iterator(ids_.end(), pool_); }
+		size_t size() const { return ids_.size(); }
+		bool empty() const { return ids_.empty(); }
+		void clear() { ids_.clear(); }
+		StringPool& pool() const { return *pool_; }
+
+		const_iterator find(StringId id) const { return const_iterator(ids_.find(id), pool_); }
+
+		const_iterator find(std::string_view item) const
+		{
+			auto id = pool_->lookup(item);
+			return id ? find(*id) : end();
+		}
+
+		size_t count(StringId id) const { return ids_.count(id); }
+		size_t count(std::string_view item) const { return find(item) == end() ? 0 : 1; }
+
+		void insert(StringId id) { ids_.insert(id); }
+		void insert(std::string_view item) { ids_.insert(pool_->intern(item)); }
+
+		void erase(StringId id) { ids_.erase(id); }
+
+		void erase(std::string_view item)
+		{
+			auto id = pool_->lookup(item);
+			if (id)
+				ids_.erase(*id);
+		}
+
+	private:
+		StringPool* pool_;
+		Set_ ids_;
+	};
+
+	/// A map from strings interned in a StringPool to values. See InternedSet.
+	template<typename ValueType>
+	class InternedMap
+	{
+		using Map_ = std::unordered_map<StringId, ValueType, StringId::Hash>;
+
+	public:
+		using key_type = std::string_view;
+		using mapped_type = ValueType;
+		using value_type = std::pair<std::string_view, const ValueType&>;
+
+		/// Iterates over the key-value pairs (in no particular order).
+		/// Dereferencing gives a pair of the key and a reference to the value.
+		class const_iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::pair<std::string_view, const ValueType&>;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = value_type;
+
+			struct ArrowProxy_
+			{
+				value_type pair;
+				const value_type* operator->() const { return &pair; }
+			};
+
+			const_iterator() = default;
+			const_iterator(typename Map_::const_iterator position, const StringPool* pool) : position_(position), pool_(pool) {}
+
+			reference operator*() const { return reference(pool_->view(position_->first), position_->second); }
+			ArrowProxy_ operator->() const { return ArrowProxy_{ **this }; }
+			StringId id() const { return position_->first; }
+			const_iterator& operator++() { ++position_; return *this; }
+			const_iterator operator++(int) { const_iterator old = *this; ++position_; return old; }
+			bool operator==(const const_iterator& other) const { return position_ == other.position_; }
+			bool operator!=(const const_iterator& other) const { return position_ != other.position_; }
+
+		private:
+			typename Map_::const_iterator position_;
+			const StringPool* pool_ = nullptr;
+		};
+		using iterator = const_iterator;
+
+		explicit InternedMap(StringPool& pool) : pool_(&pool) {}
+
+		const_iterator begin() const { return const_iterator(map_.begin(), pool_); }
+		const_iterator end() const { return const_iterator(map_.end(), pool_); }
+		size_t size() const { return map_.size(); }
+		bool empty() const { return map_.empty(); }
+		void clear() { map_.clear(); }
+		StringPool& pool() const { return *pool_; }
+
+		const_iterator find(StringId id) const { return const_iterator(map_.find(id), pool_); }
+
+		const_iterator find(std::string_view key) const
+		{
+			auto id = pool_->lookup(key);
+			return id ? find(*id) : end();
+		}
+
+		size_t count(StringId id) const { return map_.count(id); }
+		size_t count(std::string_view key) const { return find(key) == end() ? 0 : 1; }
+
+		/// Returns the value of the key, adding the key (with a default constructed value) if needed.
+		ValueType& operator[](StringId id) { return map_[id]; }
+		ValueType& operator[](std::string_view key) { return map_[pool_->intern(key)]; }
+
+		void erase(StringId id) { map_.erase(id); }
+
+		void erase(std::string_view key)
+		{
+			auto id = pool_->lookup(key);
+			if (id)
+				map_.erase(*id);
+		}
+
+	private:
+		StringPool* pool_;
+		Map_ map_;
+	};
+
+	// internal, turns the item given to one of the interned container overloads into what the container takes
+	inline StringId internedKey_(StringId id) { return id; }
+	inline std::string_view internedKey_(std::string_view item) { return item; }
+
+	/// @name InternedSet and InternedMap overloads
+	/// Overloads of the wrapper functions for the interned containers.
+	/// Items (or keys) can be strings (anything convertible to std::string_view) or StringIds.
+	/// All of them are constant complexity (searching by id doesn't even hash a string).
+	///@{
+	///
+	/// find() overload for interned set.
+	template<typename ItemType>
+	auto find(const InternedSet& inContainer, const ItemType& item)
+	{
+		return inContainer.find(internedKey_(item));
+	}
+	///
+	/// find() overload for interned map.
+	template<typename ValueType, typename KeyType>
+	auto find(const InternedMap<ValueType>& inContainer, const KeyType& item)
+	{
+		return inContainer.find(internedKey_(item));
+	}
+	///
+	/// count() overload for interned set.
+	template<typename ItemType>
+	size_t count(const InternedSet& inContainer, const ItemType& item)
+	{
+		return inContainer.count(internedKey_(item));
+	}
+	///
+	/// count() overload for interned map.
+	template<typename ValueType, typename KeyType>
+	size_t count(const InternedMap<ValueType>& inContainer, const KeyType& item)
+	{
+		return inContainer.count(internedKey_(item));
+	}
+	///
+	/// add() overload for interned set.
+	template<typename ItemType>
+	void add(InternedSet& inContainer, const ItemType& item)
+	{
+		inContainer.insert(internedKey_(item));
+	}
+	///
+	/// add() overload for adding a key-value pair to an interned map.
+	template<typename ValueType, typename PairType>
+	void add(InternedMap<ValueType>& inContainer, const PairType& item)
+	{
+		inContainer[internedKey_(item.first)] = item.second;
+	}
+	///
+	/// add() overload for adding a key and value to an interned map.
+	template<typename ValueType, typename KeyType>
+	void add(InternedMap<ValueType>& inMap, const KeyType& key, const ValueType& value)
+	{
+		inMap[internedKey_(key)] = value;
+	}
+	///
+	/// remove() overload for interned set.
+	template<typename ItemType>
+	void remove(InternedSet& fromContainer, const ItemType& item)
+	{
+		fromContainer.erase(internedKey_(item));
+	}
+	///
+	/// remove() overload for interned map.
+	template<typename ValueType, typename KeyType>
+	void remove(InternedMap<ValueType>& fromContainer, const KeyType& item)
+	{
+		fromContainer.erase(internedKey_(item));
+	}
+	///@}
+
+	/// A hash map with string keys, where the keys are copied into an arena instead of being allocated one by one.
+	/// Entries (a std::string_view of the key, its cached hash and the value) are stored in one flat open
+	/// addressing table (linear probing), so a lookup usually touches a single cache line plus the key bytes,
+	/// growing the table never rehashes a key, and clear() (or destruction) frees all the keys at once.
+	/// Keys can be searched with anything convertible to std::string_view (std::string, const char*, ...)
+	/// without building a std::string.
+	/// @note The bytes of removed keys stay in the arena until clear() is called.
+	template<typename ValueType>
+	class ArenaStringMap
+	{
+		// the key is const in the entry (changing it would break the table), so entries are emplaced rather than assigned
+		struct Slot_
+		{
+			std::optional<std::pair<const std::string_view, ValueType>> entry; // empty for unused slots
+			size_t hash = 0;
+		};
+
+		template<bool Const>
+		class Iterator_
+		{
+			using SlotPointer_ = std::conditional_t<Const, const Slot_*, Slot_*>;
+
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::pair<const std::string_view, ValueType>;
+			using difference_type = std::ptrdiff_t;
+			using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+			using reference = std::conditional_t<Const, const value_type&, value_type&>;
+
+			Iterator_() = default;
+			Iterator_(SlotPointer_ slot, SlotPointer_ last) : slot_(slot), last_(last) { skipEmpty_(); }
+			operator Iterator_<true>() const { return Iterator_<true>(slot_, last_); }
+
+			reference operator*() const { return *slot_->entry; }
+			pointer operator->() const { return &*slot_->entry; }
+			Iterator_& operator++() { ++slot_; skipEmpty_(); return *this; }
+			Iterator_ operator++(int) { Iterator_ old = *this; ++(*this); return old; }
+			bool operator==(const Iterator_& other) const { return slot_ == other.slot_; }
+			bool operator!=(const Iterator_& other) const { return slot_ != other.slot_; }
+
+		private:
+			void skipEmpty_()
+			{
+				while (slot_ != last_ && !slot_->entry)
+					++slot_;
+			}
+
+			SlotPointer_ slot_ = nullptr;
+			SlotPointer_ last_ = nullptr;
+		};
+
+	public:
+		using key_type = std::string_view;
+		using mapped_type = ValueType;
+		using value_type = std::pair<const std::string_view, ValueType>;
+		using iterator = Iterator_<false>;
+		using const_iterator = Iterator_<true>;
+
+		ArenaStringMap() = default;
+
+		ArenaStringMap(std::initializer_list<std::pair<std::string_view, ValueType>> items)
+		{
+			for (const auto& item : items)
+				insert(item.first, item.second);
+		}
+
+		// the entries point into the arena, so copying would need to copy the keys too
+		ArenaStringMap(const ArenaStringMap&) = delete;
+		ArenaStringMap& operator=(const ArenaStringMap&) = delete;
+
+		// the moved-from map is left empty (no table and no arena blocks), like a default constructed one
+		ArenaStringMap(ArenaStringMap&& other) noexcept
+			: arena_(std::move(other.arena_)), slots_(std::move(other.slots_)), size_(std::exchange(other.size_, 0))
+		{
+			other.slots_.clear();
+		}
+
+		ArenaStringMap& operator=(ArenaStringMap&& other) noexcept
+		{
+			if (this != &other) {
+				arena_ = std::move(other.arena_);
+				slots_ = std::move(other.slots_);
+				other.slots_.clear();
+				size_ = std::exchange(other.size_, 0);
+			}
+			return *this;
+		}
+
+		iterator begin() { return iterator(slots_.data(), slots_.data() + slots_.size()); }
+		iterator end() { return iterator(slots_.data() + slots_.size(), slots_.data() + slots_.size()); }
+		const_iterator begin() const { return const_iterator(slots_.data(), slots_.data() + slots_.size()); }
+		const_iterator end() const { return const_iterator(slots_.data() + slots_.size(), slots_.data() + slots_.size()); }
+		size_t size() const { return size_; }
+		bool empty() const { return size_ == 0; }
+
+		/// Removes all the entries and frees all the keys at once.
+		void clear()
+		{
+			slots_.clear();
+			size_ = 0;
+			arena_.clear();
+		}
+
+		/// Makes room for 'count' entries without growing the table.
+		void reserve(size_t count)
+		{
+			size_t capacity = 16;
+			while (capacity * 3 < count * 4)
+				capacity *= 2;
+			if (capacity > slots_.size())
+				rehash_(capacity);
+		}
+
+		const_iterator find(std::string_view key) const
+		{
+			if (size_ == 0)
+				return end();
+			size_t slot = probe_(key, hash_(key));
+			return slots_[slot].entry ? const_iterator(&slots_[slot], slots_.data() + slots_.size()) : end();
+		}
+
+		iterator find(std::string_view key)
+		{
+			if (size_ == 0)
+				return end();
+			size_t slot = probe_(key, hash_(key));
+			return slots_[slot].entry ? iterator(&slots_[slot], slots_.data() + slots_.size()) : end();
+		}
+
+		size_t count(std::string_view key) const { return find(key) == end() ? 0 : 1; }
+
+		/// Adds the key with the value, unless the key is already in the map.
+		/// Returns an iterator to the entry of the key and whether it was added.
+		/// The table only grows (invalidating iterators) when the key is added.
+		std::pair<iterator, bool> insert(std::string_view key, const ValueType& value)
+		{
+			size_t hash = hash_(key);
+			size_t slot = slots_.empty() ? 0 : probe_(key, hash);
+			if (!slots_.empty() && slots_[slot].entry)
+				return { iterator(&slots_[slot], slots_.data() + slots_.size()), false };
+			if ((size_ + 1) * 4 > slots_.size() * 3) {
+				rehash_(slots_.empty() ? 16 : slots_.size() * 2);
+				slot = probe_(key, hash);
+			}
+			slots_[slot].entry.emplace(arena_.copy(key), value);
+			slots_[slot].hash = hash;
+			++size_;
+			return { iterator(&slots_[slot], slots_.data() + slots_.size()), true };
+		}
+
+		/// Returns the value of the key, adding the key (with a default constructed value) if needed.
+		ValueType& operator[](std::string_view key)
+		{
+			return insert(key, ValueType{}).first->second;
+		}
+
+		/// Removes the key (if it is in the map). Returns true if it was removed.
+		bool erase(std::string_view key)
+		{
+			if (size_ == 0)
+				return false;
+			size_t slot = probe_(key, hash_(key));
+			if (!slots_[slot].entry)
+				return false;
+
+			// backward shift deletion: move later entries of the probe sequence into the hole, so there are no tombstones
+			size_t mask = slots_.size() - 1;
+			size_t hole = slot;
+			for (size_t next = (hole + 1) & mask; slots_[next].entry; next = (next + 1) & mask) {
+				size_t home = slots_[next].hash & mask;
+				// the entry can move into the hole only if the hole lies between its home slot and its current slot
+				if (((next - home) & mask) >= ((next - hole) & mask)) {
+					move_(slots_[next], slots_[hole]);
+					hole = next;
+				}
+			}
+			slots_[hole].entry.reset();
+			--size_;
+			return true;
+		}
+
+	private:
+		static size_t hash_(std::string_view key)
+		{
+			return FastHash<std::string_view>{}(key);
+		}
+
+		// returns the slot holding the key or the empty slot where it would go (the table must not be empty)
+		size_t probe_(std::string_view key, size_t hash) const
+		{
+			size_t mask = slots_.size() - 1;
+			for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+				const Slot_& current = slots_[slot];
+				if (!current.entry || (current.hash == hash && current.entry->first == key))
+					return slot;
+			}
+		}
+
+		// moves the entry of a slot into another (replacing its entry, if any)
+		static void move_(Slot_& from, Slot_& to)
+		{
+			to.entry.emplace(from.entry->first, std::move(from.entry->second));
+			to.hash = from.hash;
+		}
+
+		// moves the entries into a table with the capacity (reusing the cached hashes)
+		void rehash_(size_t capacity)
+		{
+			std::vector<Slot_> old(capacity);
+			old.swap(slots_);
+			size_t mask = capacity - 1;
+			for (auto& entry : old) {
+				if (!entry.entry)
+					continue;
+				size_t slot = entry.hash & mask;
+				while (slots_[slot].entry)
+					slot = (slot + 1) & mask;
+				move_(entry, slots_[slot]);
+			}
+		}
+
+		Arena_ arena_;
+		std::vector<Slot_> slots_;
+		size_t size_ = 0;
+	};
+
+	/// A hash set of strings that are copied into an arena. See ArenaStringMap.
+	class ArenaStringSet
+	{
+		struct Empty_ {};
+		using Map_ = ArenaStringMap<Empty_>;
+
+	public:
+		using value_type = std::string_view;
+
+		/// Iterates over the strings (in no particular order).
+		class const_iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::string_view;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const std::string_view*;
+			using reference = const std::string_view&;
+
+			const_iterator() = default;
+			explicit const_iterator(Map_::const_iterator position) : position_(position) {}
+
+			reference operator*() const { return position_->first; }
+			pointer operator->() const { return &position_->first; }
+			const_iterator& operator++() { ++position_; return *this; }
+			const_iterator operator++(int) { const_iterator old = *this; ++position_; return old; }
+			bool operator==(const const_iterator& other) const { return position_ == other.position_; }
+			bool operator!=(const const_iterator& other) const { return position_ != other.position_; }
+
+		private:
+			Map_::const_iterator position_;
+		};
+		using iterator = const_iterator;
+
+		ArenaStringSet() = default;
+
+		ArenaStringSet(std::initializer_list<std::string_view> items)
+		{
+			for (const auto& item : items)
+				insert(item);
+		}
+
+		const_iterator begin() const { return const_iterator(map_.begin()); }
+		const_iterator end() const { return const_iterator(map_.end()); }
+		size_t size() const { return map_.size(); }
+		bool empty() const { return map_.empty(); }
+		void clear() { map_.clear(); }
+		void reserve(size_t count) { map_.reserve(count); }
+
+		const_iterator find(std::string_view item) const { return const_iterator(map_.find(item)); }
+		size_t count(std::string_view item) const { return map_.count(item); }
+		bool insert(std::string_view item) { return map_.insert(item, Empty_{}).second; }
+		bool erase(std::string_view item) { return map_.erase(item); }
+
+	private:
+		Map_ map_;
+	};
+
+	/// @name ArenaStringMap and ArenaStringSet overloads
+	/// Overloads of the wrapper functions for the arena string containers.
+	/// Keys can be anything convertible to a std::string_view. All of them are constant complexity.
+	///@{
+	///
+	/// find() overload for arena string map.
+	template<typename ValueType, typename KeyType>
+	auto find(const ArenaStringMap<ValueType>& inContainer, const KeyType& item)
+	{
+		return inContainer.find(std::string_view(item));
+	}
+	///
+	/// find() overload for arena string set.
+	template<typename KeyType>
+	auto find(const ArenaStringSet& inContainer, const KeyType& item)
+	{
+		return inContainer.find(std::string_view(item));
+	}
+	///
+	/// count() overload for arena string map.
+	template<typename ValueType, typename KeyType>
+	size_t count(const ArenaStringMap<ValueType>& inContainer, const KeyType& item)
+	{
+		return inContainer.count(std::string_view(item));
+	}
+	///
+	/// count() overload for arena string set.
+	template<typename KeyType>
+	size_t count(const ArenaStringSet& inContainer, const KeyType& item)
+	{
+		return inContainer.count(std::string_view(item));
+	}
+	///
+	/// add() overload for arena string set.
+	template<typename KeyType>
+	void add(ArenaStringSet& inContainer, const KeyType& item)
+	{
+		inContainer.insert(std::string_view(item));
+	}
+	///
+	/// add() overload for adding a key-value pair to an arena string map.
+	template<typename ValueType, typename PairType>
+	void add(ArenaStringMap<ValueType>& inContainer, const PairType& item)
+	{
+		inContainer[std::string_view(item.first)] = item.second;
+	}
+	///
+	/// add() overload for adding a key and value to an arena string map.
+	template<typename ValueType, typename KeyType>
+	void add(ArenaStringMap<ValueType>& inMap, const KeyType& key, const ValueType& value)
+	{
+		inMap[std::string_view(key)] = value;
+	}
+	///
+	/// remove() overload for arena string map.
+	template<typename ValueType, typename KeyType>
+	void remove(ArenaStringMap<ValueType>& fromContainer, const KeyType& item)
+	{
+		fromContainer.erase(std::string_view(item));
+	}
+	///
+	/// remove() overload for arena string set.
+	template<typename KeyType>
+	void remove(ArenaStringSet& fromContainer, const KeyType& item)
+	{
+		fromContainer.erase(std::string_view(item));
+	}
+	///@}
+
+	/// A key together with its hash, computed once when the HashedKey is made.
+	/// Use it as the key type of an unordered set/map (see HashedSet and HashedMap) so that rehashing
+	/// never calls the (possibly expensive) hash function again, and comparing two keys compares their
+	/// hashes first, so mismatches are usually rejected without comparing the keys themselves.
+	/// The same HashedKey (see prehash()) can be used to search several containers while hashing only once.
+	template<typename KeyType, typename Hash = FastHash<KeyType>>
+	struct HashedKey
+	{
+		HashedKey(const KeyType& key) : key(key), hash(Hash{}(this->key)) {}
+		HashedKey(KeyType&& key) : key(std::move(key)), hash(Hash{}(this->key)) {}
+
+		bool operator==(const HashedKey& other) const { return hash == other.hash && key == other.key; }
+		bool operator!=(const HashedKey& other) const { return !(*this == other); }
+		bool operator<(const HashedKey& other) const { return key < other.key; }
+
+		/// Hash function for HashedKey, simply returns the cached hash.
+		struct Hasher
+		{
+			size_t operator()(const HashedKey& hashedKey) const { return hashedKey.hash; }
+		};
+
+		KeyType key;
+		size_t hash;
+	};
+
+	/// An unordered set whose items cache their hash (see HashedKey).
+	template<typename KeyType, typename Hash = FastHash<KeyType>>
+	using HashedSet = std::unordered_set<HashedKey<KeyType, Hash>, typename HashedKey<KeyType, Hash>::Hasher>;
+
+	/// An unordered map whose keys cache their hash (see HashedKey).
+	template<typename KeyType, typename ValueType, typename Hash = FastHash<KeyType>>
+	using HashedMap = std::unordered_map<HashedKey<KeyType, Hash>, ValueType, typename HashedKey<KeyType, Hash>::Hasher>;
+
+	/// Hashes the key once, the result can be given as the item to any of the wrapper functions for a
+	/// HashedSet or HashedMap (with the same Hash) without hashing the key again.
+	template<typename KeyType, typename Hash = FastHash<KeyType>>
+	HashedKey<KeyType, Hash> prehash(const KeyType& key)
+	{
+		return HashedKey<KeyType, Hash>(key);
+	}
+
+	/// @name HashedSet and HashedMap overloads
+	/// Overloads of the wrapper functions that let a HashedSet or HashedMap be searched (or removed from)
+	/// with a plain key, which is hashed for the call. Searching with a HashedKey uses the unordered set/map
+	/// overloads and doesn't hash at all. All of them are constant complexity.
+	///@{
+	///
+	/// find() overload for searching a hashed set with a plain key.
+	template<typename KeyType, typename Hash, typename Hasher, typename KeyEqual, typename Allocator>
+	auto find(const std::unordered_set<HashedKey<KeyType, Hash>, Hasher, KeyEqual, Allocator>& inContainer, const KeyType& item)
+	{
+		return inContainer.find(HashedKey<KeyType, Hash>(item));
+	}
+	///
+	/// find() overload for searching a hashed map with a plain key.
+	template<typename KeyType, typename Hash, typename ValueType, typename Hasher, typename KeyEqual, typename Allocator>
+	auto find(const std::unordered_map<HashedKey<KeyType, Hash>, ValueType, Hasher, KeyEqual, Allocator>& inContainer, const KeyType& item)
+	{
+		return inContainer.find(HashedKey<KeyType, Hash>(item));
+	}
+	///
+	/// count() overload for searching a hashed set with a plain key.
+	template<typename KeyType, typename Hash, typename Hasher, typename KeyEqual, typename Allocator>
+	size_t count(const std::unordered_set<HashedKey<KeyType, Hash>, Hasher, KeyEqual, Allocator>& inContainer, const KeyType& item)
+	{
+		return inContainer.count(HashedKey<KeyType, Hash>(item));
+	}
+	///
+	/// count() overload for searching a hashed map with a plain key.
+	template<typename KeyType, typename Hash, typename ValueType, typename Hasher, typename KeyEqual, typename Allocator>
+	size_t count(const std::unordered_map<HashedKey<KeyType, Hash>, ValueType, Hasher, KeyEqual, Allocator>& inContainer, const KeyType& item)
+	{
+		return inContainer.count(HashedKey<KeyType, Hash>(item));
+	}
+	///
+	/// remove() overload for removing a plain key from a hashed set.
+	template<typename KeyType, typename Hash, typename Hasher, typename KeyEqual, typename Allocator>
+	void remove(std::unordered_set<HashedKey<KeyType, Hash>, Hasher, KeyEqual, Allocator>& fromContainer, const KeyType& item)
+	{
+		fromContainer.erase(HashedKey<KeyType, Hash>(item));
+	}
+	///
+	/// remove() overload for removing a plain key from a hashed map.
+	template<typename KeyType, typename Hash, typename ValueType, typename Hasher, typename KeyEqual, typename Allocator>
+	void remove(std::unordered_map<HashedKey<KeyType, Hash>, ValueType, Hasher, KeyEqual, Allocator>& fromContainer, const KeyType& item)
+	{
+		fromContainer.erase(HashedKey<KeyType, Hash>(item));
+	}
+	///@}
+
+	/// A map whose keys are small non-negative integers (0 to MaxKey), stored in an array indexed by the key,
+	/// plus an occupancy bitmap of the keys that are present.
+	/// find(), add() and remove() are a single array access (no hashing, no tree descent). Iteration is in
+	/// key order and walks the set bits of the bitmap, skipping 64 absent keys per word.
+	/// Good for tables of opcodes, enum values, ports, etc. Keys can be any integer or enum type.
+	/// @note ValueType must be default constructible (absent keys hold default constructed values).
+	/// The map always holds MaxKey + 1 values (inline, like a std::array), so allocate large ones on the heap.
+	template<typename ValueType, size_t MaxKey>
+	class ArrayMap
+	{
+		static constexpr size_t wordCount_ = MaxKey / 64 + 1;
+
+		template<bool Const>
+		class Iterator_
+		{
+			using MapPointer_ = std::conditional_t<Const, const ArrayMap*, ArrayMap*>;
+
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::pair<size_t, std::conditional_t<Const, const ValueType&, ValueType&>>;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = value_type;
+
+			struct ArrowProxy_
+			{
+				value_type pair;
+				const value_type* operator->() const { return &pair; }
+			};
+
+			Iterator_() = default;
+			Iterator_(MapPointer_ map, size_t key) : map_(map), key_(key) {}
+			operator Iterator_<true>() const { return Iterator_<true>(map_, key_); }
+
+			reference operator*() const { return reference(key_, map_->values_[key_]); }
+			ArrowProxy_ operator->() const { return ArrowProxy_{ **this }; }
+			size_t key() const { return key_; }
+			Iterator_& operator++() { key_ = map_->nextKey_(key_ + 1); return *this; }
+			Iterator_ operator++(int) { Iterator_ old = *this; ++(*this); return old; }
+			bool operator==(const Iterator_& other) const { return key_ == other.key_; }
+			bool operator!=(const Iterator_& other) const { return key_ != other.key_; }
+
+		private:
+			MapPointer_ map_ = nullptr;
+			size_t key_ = MaxKey + 1;
+		};
+
+	public:
+		using key_type = size_t;
+		using mapped_type = ValueType;
+		using value_type = std::pair<size_t, ValueType&>;
+		using iterator = Iterator_<false>;
+		using const_iterator = Iterator_<true>;
+
+		ArrayMap() = default;
+
+		ArrayMap(std::initializer_list<std::pair<size_t, ValueType>> items)
+		{
+			for (const auto& item : items)
+				insert(item.first, item.second);
+		}
+
+		/// The largest key the map can hold.
+		static constexpr size_t maxKey() { return MaxKey; }
+
+		iterator begin() { return iterator(this, nextKey_(0)); }
+		iterator end() { return iterator(this, MaxKey + 1); }
+		const_iterator begin() const { return const_iterator(this, nextKey_(0)); }
+		const_iterator end() const { return const_iterator(this, MaxKey + 1); }
+		size_t size() const { return size_; }
+		bool empty() const { return size_ == 0; }
+
+		void clear()
+		{
+			for (auto& value : values_)
+				value = ValueType{};
+			words_.fill(0);
+			size_ = 0;
+		}
+
+		/// Returns true if the key is in the map (keys greater than MaxKey never are).
+		bool contains(size_t key) const
+		{
+			return key <= MaxKey && (words_[key / 64] & (uint64_t(1) << (key % 64))) != 0;
+		}
+
+		const_iterator find(size_t key) const { return contains(key) ? const_iterator(this, key) : end(); }
+		iterator find(size_t key) { return contains(key) ? iterator(this, key) : end(); }
+		size_t count(size_t key) const { return contains(key) ? 1 : 0; }
+
+		/// Sets the value of the key, adding the key if needed. Returns true if the key was added.
+		/// Keys greater than MaxKey (including negative keys converted to size_t) are rejected: nothing is
+		/// stored and false is returned.
+		bool insert(size_t key, const ValueType& value)
+		{
+			if (key > MaxKey)
+				return false;
+			values_[key] = value;
+			uint64_t& word = words_[key / 64];
+			uint64_t bit = uint64_t(1) << (key % 64);
+			bool added = (word & bit) == 0;
+			word |= bit;
+			size_ += added ? 1 : 0;
+			return added;
+		}
+
+		/// Returns the value of the key, adding the key (with a default constructed value) if needed.
+		/// The key must not be greater than MaxKey (there is no value to return for it).
+		ValueType& operator[](size_t key)
+		{
+			assert(key <= MaxKey);
+			uint64_t& word = words_[key / 64];
+			uint64_t bit = uint64_t(1) << (key % 64);
+			size_ += (word & bit) == 0 ? 1 : 0;
+			word |= bit;
+			return values_[key];
+		}
+
+		/// Removes the key (if it is in the map). Returns true if it was removed.
+		bool erase(size_t key)
+		{
+			if (!contains(key))
+				return false;
+			words_[key / 64] &= ~(uint64_t(1) << (key % 64));
+			values_[key] = ValueType{};
+			--size_;
+			return true;
+		}
+
+	private:
+		// returns the first key at or after 'from' that is in the map, or MaxKey + 1
+		size_t nextKey_(size_t from) const
+		{
+			if (from > MaxKey)
+				return MaxKey + 1;
+			size_t index = from / 64;
+			uint64_t word = words_[index] & (~uint64_t(0) << (from % 64));
+			while (word == 0) {
+				if (++index == wordCount_)
+					return MaxKey + 1;
+				word = words_[index];
+			}
+			return index * 64 + countTrailingZeros64_(word);
+		}
+
+		std::array<ValueType, MaxKey + 1> values_{};
+		std::array<uint64_t, wordCount_> words_{};
+		size_t size_ = 0;
+	};
+
+	/// @name ArrayMap overloads
+	/// Overloads of the wrapper functions for ArrayMap. Keys can be any integer or enum type; add() ignores
+	/// keys outside 0 to MaxKey.
+	/// contains(), containsAll(), containsAny() and addAll() work through these. All of them are constant complexity.
+	///@{
+	///
+	/// find() overload for array map.
+	template<typename ValueType, size_t MaxKey, typename KeyType>
+	auto find(const ArrayMap<ValueType, MaxKey>& inContainer, const KeyType& item)
+	{
+		return inContainer.find(static_cast<size_t>(item));
+	}
+	///
+	/// count() overload for array map.
+	template<typename ValueType, size_t MaxKey, typename KeyType>
+	size_t count(const ArrayMap<ValueType, MaxKey>& inContainer, const KeyType& item)
+	{
+		return inContainer.count(static_cast<size_t>(item));
+	}
+	///
+	/// add() overload for adding a key-value pair to an array map.
+	template<typename ValueType, size_t MaxKey, typename PairType>
+	void add(ArrayMap<ValueType, MaxKey>& inContainer, const PairType& item)
+	{
+		inContainer.insert(static_cast<size_t>(item.first), item.second);
+	}
+	///
+	/// add() overload for adding a key and value to an array map.
+	template<typename ValueType, size_t MaxKey, typename KeyType>
+	void add(ArrayMap<ValueType, MaxKey>& inMap, const KeyType& key, const ValueType& value)
+	{
+		inMap.insert(static_cast<size_t>(key), value);
+	}
+	///
+	/// remove() overload for array map.
+	template<typename ValueType, size_t MaxKey, typename KeyType>
+	void remove(ArrayMap<ValueType, MaxKey>& fromContainer, const KeyType& item)
+	{
+		fromContainer.erase(static_cast<size_t>(item));
+	}
+	///@}
+
+	/// A view of items stored contiguously (like C++20's std::span), returned by containers that keep their
+	/// items in arrays. Works with all the wrapper functions that take a container (e.g. containsAll(),
+	/// inFirstButNotInSecond()). The view is invalidated by anything that modifies the container.
+	template<typename ItemType>
+	class Span
+	{
+	public:
+		using value_type = std::remove_cv_t<ItemType>;
+		using iterator = ItemType*;
+		using const_iterator = ItemType*;
+		using reference = ItemType&;
+
+		Span() = default;
+		Span(ItemType* data, size_t size) : data_(data), size_(size) {}
+
+		ItemType* begin() const { return data_; }
+		ItemType* end() const { return data_ + size_; }
+		ItemType* data() const { return data_; }
+		size_t size() const { return size_; }
+		bool empty() const { return size_ == 0; }
+		ItemType& operator[](size_t index) const { return data_[index]; }
+
+	private:
+		ItemType* data_ = nullptr;
+		size_t size_ = 0;
+	};
+
+	/// A sorted map that keeps its keys and its values in two separate arrays (structure of arrays).
+	/// Searching only touches the key array, so many more keys fit in each cache line than with pair sized
+	/// nodes (std::map) or pair sized array entries. Small maps are searched linearly (4 keys per SSE2
+	/// compare for 32 bit integer keys), larger ones with a branchless binary search that prefetches the
+	/// keys of both possible next steps.
+	/// find() is O(log n), add() and remove() are O(n) (they shift the arrays), iteration is in key order.
+	/// keys() and values() give the arrays themselves as a Span.
+	template<typename KeyType, typename ValueType>
+	class SoaFlatMap
+	{
+		static constexpr size_t linearSearchLimit_ = 64;
+
+		template<bool Const>
+		class Iterator_
+		{
+			using MapPointer_ = std::conditional_t<Const, const SoaFlatMap*, SoaFlatMap*>;
+
+		public:
+			using iterator_category = std::random_access_iterator_tag;
+			using value_type = std::pair<const KeyType&, std::conditional_t<Const, const ValueType&, ValueType&>>;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = value_type;
+
+			struct ArrowProxy_
+			{
+				value_type pair;
+				const value_type* operator->() const { return &pair; }
+			};
+
+			Iterator_() = default;
+			Iterator_(MapPointer_ map, size_t index) : map_(map), index_(index) {}
+			operator Iterator_<true>() const { return Iterator_<true>(map_, index_); }
+
+			reference operator*() const { return reference(map_->keys_[index_], map_->values_[index_]); }
+			ArrowProxy_ operator->() const { return ArrowProxy_{ **this }; }
+			reference operator[](difference_type offset) const { return *(*this + offset); }
+			size_t index() const { return index_; }
+			Iterator_& operator++() { ++index_; return *this; }
+			Iterator_ operator++(int) { Iterator_ old = *this; ++index_; return old; }
+			Iterator_& operator--() { --index_; return *this; }
+			Iterator_ operator--(int) { Iterator_ old = *this; --index_; return old; }
+			Iterator_& operator+=(difference_type offset) { index_ += offset; return *this; }
+			Iterator_& operator-=(difference_type offset) { index_ -= offset; return *this; }
+			Iterator_ operator+(difference_type offset) const { return Iterator_(map_, index_ + offset); }
+			Iterator_ operator-(difference_type offset) const { return Iterator_(map_, index_ - offset); }
+			difference_type operator-(const Iterator_& other) const { return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_); }
+			bool operator==(const Iterator_& other) const { return index_ == other.index_; }
+			bool operator!=(const Iterator_& other) const { return index_ != other.index_; }
+			bool operator<(const Iterator_& other) const { return index_ < other.index_; }
+			bool operator>(const Iterator_& other) const { return index_ > other.index_; }
+			bool operator<=(const Iterator_& other) const { return index_ <= other.index_; }
+			bool operator>=(const Iterator_& other) const { return index_ >= other.index_; }
+
+		private:
+			MapPointer_ map_ = nullptr;
+			size_t index_ = 0;
+		};
+
+	public:
+		using key_type = KeyType;
+		using mapped_type = ValueType;
+		using value_type = std::pair<const KeyType&, ValueType&>;
+		using iterator = Iterator_<false>;
+		using const_iterator = Iterator_<true>;
+
+		SoaFlatMap() = default;
+
+		/// If a key appears more than once, the first value is kept (like std::map).
+		SoaFlatMap(std::initializer_list<std::pair<KeyType, ValueType>> items)
+		{
+			std::vector<std::pair<KeyType, ValueType>> sorted(items);
+			std::stable_sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+			keys_.reserve(sorted.size());
+			values_.reserve(sorted.size());
+			for (auto& item : sorted) {
+				if (!keys_.empty() && !(keys_.back() < item.first))
+					continue;
+				keys_.push_back(std::move(item.first));
+				values_.push_back(std::move(item.second));
+			}
+		}
+
+		iterator begin() { return iterator(this, 0); }
+		iterator end() { return iterator(this, keys_.size()); }
+		const_iterator begin() const { return const_iterator(this, 0); }
+		const_iterator end() const { return const_iterator(this, keys_.size()); }
+		size_t size() const { return keys_.size(); }
+		bool empty() const { return keys_.empty(); }
+		void clear() { keys_.clear(); values_.clear(); }
+		void reserve(size_t count) { keys_.reserve(count); values_.reserve(count); }
+
+		/// The sorted keys.
+		Span<const KeyType> keys() const { return Span<const KeyType>(keys_.data(), keys_.size()); }
+
+		/// The values, in the order of their keys.
+		Span<const ValueType> values() const { return Span<const ValueType>(values_.data(), values_.size()); }
+
+		/// Returns an iterator to the first entry whose key is not less than the key.
+		const_iterator lower_bound(const KeyType& key) const { return const_iterator(this, lowerBound_(key)); }
+		iterator lower_bound(const KeyType& key) { return iterator(this, lowerBound_(key)); }
+
+		const_iterator find(const KeyType& key) const { return const_iterator(this, findIndex_(key)); }
+		iterator find(const KeyType& key) { return iterator(this, findIndex_(key)); }
+		size_t count(const KeyType& key) const { return findIndex_(key) == keys_.size() ? 0 : 1; }
+
+		/// Adds the key with the value, unless the key is already in the map.
+		/// Returns an iterator to the entry of the key and whether it was added.
+		std::pair<iterator, bool> insert(const KeyType& key, const ValueType& value)
+		{
+			size_t index = lowerBound_(key);
+			if (index != keys_.size() && !(key < keys_[index]))
+				return { iterator(this, index), false };
+			keys_.insert(keys_.begin() + index, key);
+			values_.insert(values_.begin() + index, value);
+			return { iterator(this, index), true };
+		}
+
+		/// Returns the value of the key, adding the key (with a default constructed value) if needed.
+		ValueType& operator[](const KeyType& key)
+		{
+			return values_[insert(key, ValueType{}).first.index()];
+		}
+
+		/// Removes the key (if it is in the map). Returns true if it was removed.
+		bool erase(const KeyType& key)
+		{
+			size_t index = findIndex_(key);
+			if (index == keys_.size())
+				return false;
+			keys_.erase(keys_.begin() + index);
+			values_.erase(values_.begin() + index);
+			return true;
+		}
+
+	private:
+		size_t findIndex_(const KeyType& key) const
+		{
+			size_t index = lowerBound_(key);
+			return index != keys_.size() && !(key < keys_[index]) ? index : keys_.size();
+		}
+
+		// index of the first key that is not less than the key
+		size_t lowerBound_(const KeyType& key) const
+		{
+			const KeyType* keys = keys_.data();
+			size_t size = keys_.size();
+			if (size <= linearSearchLimit_)
+				return countLess_(keys, size, key);
+
+			// branchless binary search: the range halves every step whatever the comparison says, and the
+			// middles of both halves are prefetched so the next key is (usually) already on its way
+			const KeyType* base = keys;
+			while (size > 1) {
+				size_t half = size / 2;
+				prefetch_(base + half / 2);
+				prefetch_(base + half + half / 2);
+				base = base[half] < key ? base + half : base;
+				size -= half;
+			}
+			return static_cast<size_t>(base - keys) + (*base < key ? 1 : 0);
+		}
+
+		// number of keys less than the key (the keys are sorted, so this is the lower bound)
+		static size_t countLess_(const KeyType* keys, size_t size, const KeyType& key)
+		{
+			size_t result = 0;
+			size_t i = 0;
+#if defined(STLWRAPPERS_SSE2_)
+			if constexpr (std::is_integral_v<KeyType> && std::is_signed_v<KeyType> && sizeof(KeyType) == 4) {
+				__m128i wanted = _mm_set1_epi32(static_cast<int32_t>(key));
+				for (; i + 4 <= size; i += 4) {
+					__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+					int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(wanted, block)));
+					result += popcount32_(static_cast<uint32_t>(mask));
+				}
+			}
+#endif
+			for (; i < size; ++i)
+				result += keys[i] < key ? 1 : 0;
+			return result;
+		}
+
+		std::vector<KeyType> keys_;
+		std::vector<ValueType> values_;
+	};
+
+	/// @name SoaFlatMap overloads
+	/// Overloads of the wrapper functions for SoaFlatMap.
+	/// contains(), containsAll(), containsAny() and addAll() work through these.
+	///@{
+	///
+	/// find() overload for structure of arrays flat map, complexity is logarithmic.
+	template<typename KeyType, typename ValueType, typename ItemType>
+	auto find(const SoaFlatMap<KeyType, ValueType>& inContainer, const ItemType& item)
+	{
+		return inContainer.find(item);
+	}
+	///
+	/// count() overload for structure of arrays flat map, complexity is logarithmic.
+	template<typename KeyType, typename ValueType, typename ItemType>
+	size_t count(const SoaFlatMap<KeyType, ValueType>& inContainer, const ItemType& item)
+	{
+		return inContainer.count(item);
+	}
+	///
+	/// add() overload for adding a key-value pair to a structure of arrays flat map, complexity is linear.
+	template<typename KeyType, typename ValueType, typename PairType>
+	void add(SoaFlatMap<KeyType, ValueType>& inContainer, const PairType& item)
+	{
+		inContainer[item.first] = item.second;
+	}
+	///
+	/// remove() overload for structure of arrays flat map, complexity is linear.
+	template<typename KeyType, typename ValueType, typename ItemType>
+	void remove(SoaFlatMap<KeyType, ValueType>& fromContainer, const ItemType& item)
+	{
+		fromContainer.erase(item);
+	}
+	///@}
+
+	template<typename KeyType, typename ValueType>
+	class GroupedMapBuilder;
+
+	/// An immutable one-to-many map (a replacement for std::map<K, std::vector<V>> or
+	/// std::unordered_map<K, std::vector<V>>), stored in compressed sparse row form: the sorted keys, one
+	/// array holding the values of all the keys group after group, and the offset of each key's group in it.
+	/// That is three allocations in total instead of one per key, and the values of a key are contiguous.
+	/// find() returns the values of a key as a Span (empty if the key isn't there), in the order they were added.
+	/// Iterating gives each key with its values, in key order.
+	/// Build one from a container of key-value pairs or of key-group pairs, or append to a Builder and call build().
+	template<typename KeyType, typename ValueType>
+	class GroupedMap
+	{
+	public:
+		using key_type = KeyType;
+		using mapped_type = Span<const ValueType>;
+		using value_type = std::pair<const KeyType&, Span<const ValueType>>;
+
+		/// Iterates over the keys and their groups of values (in key order).
+		class const_iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::pair<const KeyType&, Span<const ValueType>>;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = value_type;
+
+			struct ArrowProxy_
+			{
+				value_type pair;
+				const value_type* operator->() const { return &pair; }
+			};
+
+			const_iterator() = default;
+			const_iterator(const GroupedMap* map, size_t index) : map_(map), index_(index) {}
+
+			reference operator*() const { return reference(map_->keys_[index_], map_->group_(index_)); }
+			ArrowProxy_ operator->() const { return ArrowProxy_{ **this }; }
+			const_iterator& operator++() { ++index_; return *this; }
+			const_iterator operator++(int) { const_iterator old = *this; ++index_; return old; }
+			bool operator==(const const_iterator& other) const { return index_ == other.index_; }
+			bool operator!=(const const_iterator& other) const { return index_ != other.index_; }
+
+		private:
+			const GroupedMap* map_ = nullptr;
+			size_t index_ = 0;
+		};
+		using iterator = const_iterator;
+
+		/// Collects key-value pairs and builds a GroupedMap from them (see GroupedMapBuilder).
+		using Builder = GroupedMapBuilder<KeyType, ValueType>;
+
+		GroupedMap() : offsets_(1, 0) {}
+
+		GroupedMap(std::initializer_list<std::pair<KeyType, ValueType>> pairs)
+		{
+			std::vector<std::pair<KeyType, ValueType>> copy(pairs);
+			assign_(copy);
+		}
+
+		/// Builds the map from a container of key-value pairs (a key may appear any number of times), or
+		/// from a container of key-group pairs such as a std::map<K, std::vector<V>>.
+		template<typename ContainerType>
+		explicit GroupedMap(const ContainerType& items)
+		{
+			std::vector<std::pair<KeyType, ValueType>> pairs;
+			for (const auto& item : items) {
+				if constexpr (std::is_convertible_v<decltype(item.second), const ValueType&>) {
+					pairs.emplace_back(item.first, item.second);
+				}
+				else {
+					for (const auto& value : item.second)
+						pairs.emplace_back(item.first, value);
+				}
+			}
+			assign_(pairs);
+		}
+
+		const_iterator begin() const { return const_iterator(this, 0); }
+		const_iterator end() const { return const_iterator(this, keys_.size()); }
+
+		/// Number of keys.
+		size_t size() const { return keys_.size(); }
+		bool empty() const { return keys_.empty(); }
+
+		/// Number of values, over all the keys.
+		size_t valueCount() const { return values_.size(); }
+
+		/// The values of the key (empty if the key isn't in the map). O(log n).
+		Span<const ValueType> find(const KeyType& key) const
+		{
+			size_t index = indexOf_(key);
+			return index == keys_.size() ? Span<const ValueType>() : group_(index);
+		}
+
+		/// Number of values of the key. O(log n).
+		size_t count(const KeyType& key) const
+		{
+			return find(key).size();
+		}
+
+		bool contains(const KeyType& key) const
+		{
+			return indexOf_(key) != keys_.size();
+		}
+
+	private:
+		friend class GroupedMapBuilder<KeyType, ValueType>;
+
+		// sorts the pairs by key (keeping the order of each key's values) and lays them out
+		void assign_(std::vector<std::pair<KeyType, ValueType>>& pairs)
+		{
+			std::stable_sort(pairs.begin(), pairs.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+			keys_.clear();
+			offsets_.assign(1, 0);
+			values_.clear();
+			values_.reserve(pairs.size());
+			for (auto& pair : pairs) {
+				if (keys_.empty() || keys_.back() < pair.first) {
+					if (!keys_.empty())
+						offsets_.push_back(values_.size());
+					keys_.push_back(std::move(pair.first));
+				}
+				values_.push_back(std::move(pair.second));
+			}
+			if (!keys_.empty())
+				offsets_.push_back(values_.size());
+		}
+
+		size_t indexOf_(const KeyType& key) const
+		{
+			auto position = std::lower_bound(keys_.begin(), keys_.end(), key);
+			return position != keys_.end() && !(key < *position) ? static_cast<size_t>(position - keys_.begin()) : keys_.size();
+		}
+
+		Span<const ValueType> group_(size_t index) const
+		{
+			return Span<const ValueType>(values_.data() + offsets_[index], offsets_[index + 1] - offsets_[index]);
+		}
+
+		std::vector<KeyType> keys_;
+		std::vector<size_t> offsets_; // group i is values_[offsets_[i], offsets_[i + 1])
+		std::vector<ValueType> values_;
+	};
+
+	/// Collects key-value pairs one at a time (amortized O(1) each) for append heavy workloads, then builds
+	/// a GroupedMap from them in O(n log n). Values of the same key keep the order they were added in.
+	template<typename KeyType, typename ValueType>
+	class GroupedMapBuilder
+	{
+	public:
+		void reserve(size_t count) { pairs_.reserve(count); }
+		size_t size() const { return pairs_.size(); }
+
+		void add(const KeyType& key, const ValueType& value)
+		{
+			pairs_.emplace_back(key, value);
+		}
+
+		/// Builds the map and empties the builder.
+		GroupedMap<KeyType, ValueType> build()
+		{
+			GroupedMap<KeyType, ValueType> result;
+			result.assign_(pairs_);
+			pairs_.clear();
+			return result;
+		}
+
+	private:
+		std::vector<std::pair<KeyType, ValueType>> pairs_;
+	};
+
+	/// @name GroupedMap overloads
+	/// Overloads of the wrapper functions for GroupedMap (and adding to its Builder).
+	/// find() returns the values of the key as a Span (empty if the key isn't there) and count() the number
+	/// of values of the key. Both are O(log n).
+	///@{
+	///
+	/// find() overload for grouped map.
+	template<typename KeyType, typename ValueType, typename ItemType>
+	Span<const ValueType> find(const GroupedMap<KeyType, ValueType>& inContainer, const ItemType& item)
+	{
+		return inContainer.find(item);
+	}
+	///
+	/// count() overload for grouped map.
+	template<typename KeyType, typename ValueType, typename ItemType>
+	size_t count(const GroupedMap<KeyType, ValueType>& inContainer, const ItemType& item)
+	{
+		return inContainer.count(item);
+	}
+	///
+	/// contains() overload for grouped map, true if the key has any values.
+	template<typename KeyType, typename ValueType, typename ItemType>
+	bool contains(const GroupedMap<KeyType, ValueType>& container, const ItemType& item)
+	{
+		return container.contains(item);
+	}
+	///
+	/// containsAll() overload for checking that the group of a key contains all the items.
+	template<typename KeyType, typename ValueType, typename GroupKeyType, typename ContainerOfItemsType>
+	bool containsAll(const GroupedMap<KeyType, ValueType>& container, const GroupKeyType& key, const ContainerOfItemsType& items)
+	{
+		return containsAll(container.find(key), items);
+	}
+	///
+	/// containsAll() overload for checking that the group of a key contains all the items of an initializer list.
+	template<typename KeyType, typename ValueType, typename GroupKeyType, typename ItemType>
+	bool containsAll(const GroupedMap<KeyType, ValueType>& container, const GroupKeyType& key, const std::initializer_list<ItemType>& items)
+	{
+		return containsAll(container.find(key), items);
+	}
+	///
+	/// add() overload for adding a key-value pair to a grouped map builder.
+	template<typename KeyType, typename ValueType, typename PairType>
+	void add(GroupedMapBuilder<KeyType, ValueType>& inContainer, const PairType& item)
+	{
+		inContainer.add(item.first, item.second);
+	}
+	///
+	/// add() overload for adding a key and value to a grouped map builder.
+	template<typename KeyType, typename ValueType, typename GroupKeyType, typename ItemType>
+	void add(GroupedMapBuilder<KeyType, ValueType>& inMap, const GroupKeyType& key, const ItemType& value)
+	{
+		inMap.add(key, value);
+	}
+	///@}
+
+	/// The default tag of the intrusive hooks. Give hooks your own tags (any type) to put one object in
+	/// several intrusive containers of the same kind at once, one hook (and one tag) per container.
+	struct DefaultHookTag {};
+
+	template<typename ItemType, typename Tag>
+	class IntrusiveList;
+
+	template<typename ItemType, typename Compare, typename Tag>
+	class IntrusiveSet;
+
+	/// Derive from this to let objects be linked into an IntrusiveList (with the same Tag).
+	/// Copying an object doesn't copy its membership.
+	template<typename Tag = DefaultHookTag>
+	class IntrusiveListHook
+	{
+	public:
+		IntrusiveListHook() = default;
+		IntrusiveListHook(const IntrusiveListHook&) {}
+		IntrusiveListHook& operator=(const IntrusiveListHook&) { return *this; }
+
+		/// True if the object is in a list.
+		bool isLinked() const { return owner_ != nullptr; }
+
+	private:
+		template<typename, typename> friend class IntrusiveList;
+
+		IntrusiveListHook* previous_ = nullptr;
+		IntrusiveListHook* next_ = nullptr;
+		const void* owner_ = nullptr;
+	};
+
+	/// Derive from this to let objects be linked into an IntrusiveSet (with the same Tag).
+	/// Copying an object doesn't copy its membership.
+	template<typename Tag = DefaultHookTag>
+	class IntrusiveSetHook
+	{
+	public:
+		IntrusiveSetHook() = default;
+		IntrusiveSetHook(const IntrusiveSetHook&) {}
+		IntrusiveSetHook& operator=(const IntrusiveSetHook&) { return *this; }
+
+		/// True if the object is in a set.
+		bool isLinked() const { return owner_ != nullptr; }
+
+	private:
+		template<typename, typename, typename> friend class IntrusiveSet;
+
+		IntrusiveSetHook* parent_ = nullptr;
+		IntrusiveSetHook* left_ = nullptr;
+		IntrusiveSetHook* right_ = nullptr;
+		int height_ = 0;
+		const void* owner_ = nullptr;
+	};
+
+	/// A doubly linked list of objects that carry their own links (by deriving from IntrusiveListHook<Tag>).
+	/// The list never allocates, never copies the objects and adding or removing an object is O(1),
+	/// including finding out whether an object is in the list. The objects stay wherever they live (a
+	/// pool, an array, the stack), and one object can be in several lists through hooks with different tags.
+	/// @note An object can be in only one list per hook, and it must be removed from its lists before it is
+	/// destroyed. Destroying (or clearing) the list unlinks all its objects.
+	template<typename ItemType, typename Tag = DefaultHookTag>
+	class IntrusiveList
+	{
+		using Hook_ = IntrusiveListHook<Tag>;
+
+		template<bool Const>
+		class Iterator_
+		{
+			using HookPointer_ = std::conditional_t<Const, const Hook_*, Hook_*>;
+
+		public:
+			using iterator_category = std::bidirectional_iterator_tag;
+			using value_type = ItemType;
+			using difference_type = std::ptrdiff_t;
+			using pointer = std::conditional_t<Const, const ItemType*, ItemType*>;
+			using reference = std::conditional_t<Const, const ItemType&, ItemType&>;
+
+			Iterator_() = default;
+			explicit Iterator_(HookPointer_ hook) : hook_(hook) {}
+			operator Iterator_<true>() const { return Iterator_<true>(hook_); }
+
+			reference operator*() const { return static_cast<reference>(*hook_); }
+			pointer operator->() const { return &**this; }
+			Iterator_& operator++() { hook_ = hook_->next_; return *this; }
+			Iterator_ operator++(int) { Iterator_ old = *this; hook_ = hook_->next_; return old; }
+			Iterator_& operator--() { hook_ = hook_->previous_; return *this; }
+			Iterator_ operator--(int) { Iterator_ old = *this; hook_ = hook_->previous_; return old; }
+			bool operator==(const Iterator_& other) const { return hook_ == other.hook_; }
+			bool operator!=(const Iterator_& other) const { return hook_ != other.hook_; }
+
+		private:
+			friend class IntrusiveList;
+
+			HookPointer_ hook_ = nullptr;
+		};
+
+	public:
+		using value_type = ItemType;
+		using iterator = Iterator_<false>;
+		using const_iterator = Iterator_<true>;
+
+		IntrusiveList()
+		{
+			sentinel_.previous_ = sentinel_.next_ = &sentinel_;
+		}
+
+		// the objects point back at the list
+		IntrusiveList(const IntrusiveList&) = delete;
+		IntrusiveList& operator=(const IntrusiveList&) = delete;
+
+		~IntrusiveList()
+		{
+			clear();
+		}
+
+		iterator begin() { return iterator(sentinel_.next_); }
+		iterator end() { return iterator(&sentinel_); }
+		const_iterator begin() const { return const_iterator(sentinel_.next_); }
+		const_iterator end() const { return const_iterator(&sentinel_); }
+		size_t size() const { return size_; }
+		bool empty() const { return size_ == 0; }
+		ItemType& front() { return *begin(); }
+		ItemType& back() { return *iterator(sentinel_.previous_); }
+
+		/// True if the object is in this list. O(1).
+		bool contains(const ItemType& item) const { return hook_(item).owner_ == this; }
+
+		/// Returns an iterator to the object if it is in this list, otherwise the end iterator. O(1).
+		const_iterator find(const ItemType& item) const { return contains(item) ? const_iterator(&hook_(item)) : end(); }
+		iterator find(ItemType& item) { return contains(item) ? iterator(&hook_(item)) : end(); }
+
+		/// Links the object in before 'position'. An object that is already in a list (with the same tag) is
+		/// left where it is: the result is an iterator to it if it is in this list, otherwise the end iterator.
+		iterator insert(const_iterator position, ItemType& item)
+		{
+			Hook_& hook = hook_(item);
+			if (hook.isLinked())
+				return hook.owner_ == this ? iterator(&hook) : end();
+			Hook_* next = const_cast<Hook_*>(position.hook_);
+			hook.previous_ = next->previous_;
+			hook.next_ = next;
+			hook.owner_ = this;
+			next->previous_->next_ = &hook;
+			next->previous_ = &hook;
+			++size_;
+			return iterator(&hook);
+		}
+
+		void push_back(ItemType& item) { insert(end(), item); }
+		void push_front(ItemType& item) { insert(begin(), item); }
+
+		/// Unlinks the object at the position, returns an iterator to the next one.
+		iterator erase(const_iterator position)
+		{
+			Hook_* hook = const_cast<Hook_*>(position.hook_);
+			Hook_* next = hook->next_;
+			hook->previous_->next_ = next;
+			next->previous_ = hook->previous_;
+			hook->previous_ = hook->next_ = nullptr;
+			hook->owner_ = nullptr;
+			--size_;
+			return iterator(next);
+		}
+
+		/// Unlinks the object if it is in this list. Returns true if it was.
+		bool erase(ItemType& item)
+		{
+			if (!contains(item))
+				return false;
+			erase(const_iterator(&hook_(item)));
+			return true;
+		}
+
+		void pop_front() { erase(begin()); }
+		void pop_back() { erase(const_iterator(sentinel_.previous_)); }
+
+		/// Unlinks all the objects. O(n).
+		void clear()
+		{
+			while (size_ != 0)
+				pop_front();
+		}
+
+	private:
+		static Hook_& hook_(ItemType& item) { return static_cast<Hook_&>(item); }
+		static const Hook_& hook_(const ItemType& item) { return static_cast<const Hook_&>(item); }
+
+		Hook_ sentinel_;
+		size_t size_ = 0;
+	};
+
+	/// A sorted set of objects that carry their own tree links (by deriving from IntrusiveSetHook<Tag>),
+	/// kept balanced as an AVL tree. Like IntrusiveList, adding and removing never allocates or copies,
+	/// and one object can be in several sets (and lists) through hooks with different tags.
+	/// find(), add() and remove() are O(log n). Items are searched by value with Compare, which may also
+	/// compare items with other key types (e.g. a struct with an `id` against a plain id).
+	/// @note Don't change the part of a linked object that Compare looks at. An object must be removed
+	/// from its sets before it is destroyed. Destroying (or clearing) the set unlinks all its objects.
+	template<typename ItemType, typename Compare = std::less<ItemType>, typename Tag = DefaultHookTag>
+	class IntrusiveSet
+	{
+		using Hook_ = IntrusiveSetHook<Tag>;
+
+		template<bool Const>
+		class Iterator_
+		{
+			using HookPointer_ = std::conditional_t<Const, const Hook_*, Hook_*>;
+
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = ItemType;
+			using difference_type = std::ptrdiff_t;
+			using pointer = std::conditional_t<Const, const ItemType*, ItemType*>;
+			using reference = std::conditional_t<Const, const ItemType&, ItemType&>;
+
+			Iterator_() = default;
+			explicit Iterator_(HookPointer_ hook) : hook_(hook) {}
+			operator Iterator_<true>() const { return Iterator_<true>(hook_); }
+
+			reference operator*() const { return static_cast<reference>(*hook_); }
+			pointer operator->() const { return &**this; }
+			Iterator_& operator++() { hook_ = IntrusiveSet::next_(hook_); return *this; }
+			Iterator_ operator++(int) { Iterator_ old = *this; ++(*this); return old; }
+			bool operator==(const Iterator_& other) const { return hook_ == other.hook_; }
+			bool operator!=(const Iterator_& other) const { return hook_ != other.hook_; }
+
+		private:
+			friend class IntrusiveSet;
+
+			HookPointer_ hook_ = nullptr;
+		};
+
+	public:
+		using value_type = ItemType;
+		using iterator = Iterator_<false>;
+		using const_iterator = Iterator_<true>;
+
+		IntrusiveSet() = default;
+
+		// the objects point back at the set
+		IntrusiveSet(const IntrusiveSet&) = delete;
+		IntrusiveSet& operator=(const IntrusiveSet&) = delete;
+
+		~IntrusiveSet()
+		{
+			clear();
+		}
+
+		iterator begin() { return iterator(leftmost_(root_)); }
+		iterator end() { return iterator(); }
+		const_iterator begin() const { return const_iterator(leftmost_(root_)); }
+		const_iterator end() const { return const_iterator(); }
+		size_t size() const { return size_; }
+		bool empty() const { return size_ == 0; }
+
+		/// True if this object (not just an equal one) is in this set. O(1).
+		bool isLinkedHere(const ItemType& item) const { return static_cast<const Hook_&>(item).owner_ == this; }
+
+		/// Returns an iterator to the object equal to the key, or the end iterator.
+		template<typename KeyType>
+		const_iterator find(const KeyType& key) const { return const_iterator(findHook_(key)); }
+		template<typename KeyType>
+		iterator find(const KeyType& key) { return iterator(const_cast<Hook_*>(findHook_(key))); }
+
+		template<typename KeyType>
+		size_t count(const KeyType& key) const { return findHook_(key) == nullptr ? 0 : 1; }
+
+		/// Links the object in, unless an equal object is already in the set. Returns an iterator to the object
+		/// equal to it and whether it was linked in. An object that is already in a set (with the same tag) is
+		/// left where it is and isn't linked in: the iterator is to it if it is in this set, otherwise the end iterator.
+		std::pair<iterator, bool> insert(ItemType& item)
+		{
+			Hook_& linked = static_cast<Hook_&>(item);
+			if (linked.isLinked())
+				return { linked.owner_ == this ? iterator(&linked) : end(), false };
+			Hook_* parent = nullptr;
+			Hook_** link = &root_;
+			while (*link != nullptr) {
+				parent = *link;
+				if (compare_(item, item_(parent)))
+					link = &parent->left_;
+				else if (compare_(item_(parent), item))
+					link = &parent->right_;
+				else
+					return { iterator(parent), false };
+			}
+			Hook_& hook = static_cast<Hook_&>(item);
+			hook.parent_ = parent;
+			hook.left_ = hook.right_ = nullptr;
+			hook.height_ = 1;
+			hook.owner_ = this;
+			*link = &hook;
+			++size_;
+			rebalance_(parent);
+			return { iterator(&hook), true };
+		}
+
+		/// Unlinks the object at the position.
+		void erase(const_iterator position) { unlink_(const_cast<Hook_*>(position.hook_)); }
+		void erase(iterator position) { unlink_(position.hook_); }
+
+		/// Unlinks the object equal to the key (if there is one). Returns true if one was unlinked.
+		template<typename KeyType>
+		bool erase(const KeyType& key)
+		{
+			Hook_* hook = const_cast<Hook_*>(findHook_(key));
+			if (hook == nullptr)
+				return false;
+			unlink_(hook);
+			return true;
+		}
+
+		/// Unlinks all the objects. O(n).
+		void clear()
+		{
+			clear_(root_);
+			root_ = nullptr;
+			size_ = 0;
+		}
+
+	private:
+		static ItemType& item_(Hook_* hook) { return static_cast<ItemType&>(*hook); }
+		static const ItemType& item_(const Hook_* hook) { return static_cast<const ItemType&>(*hook); }
+		static int height_(const Hook_* hook) { return hook == nullptr ? 0 : hook->height_; }
+
+		template<typename HookPointer>
+		static HookPointer leftmost_(HookPointer hook)
+		{
+			if (hook != nullptr)
+				while (hook->left_ != nullptr)
+					hook = hook->left_;
+			return hook;
+		}
+
+		// in order successor, nullptr after the last one
+		template<typename HookPointer>
+		static HookPointer next_(HookPointer hook)
+		{
+			if (hook->right_ != nullptr)
+				return leftmost_(static_cast<HookPointer>(hook->right_));
+			HookPointer parent = hook->parent_;
+			while (parent != nullptr && hook == parent->right_) {
+				hook = parent;
+				parent = parent->parent_;
+			}
+			return parent;
+		}
+
+		template<typename KeyType>
+		const Hook_* findHook_(const KeyType& key) const
+		{
+			const Hook_* hook = root_;
+			while (hook != nullptr) {
+				if (compare_(key, item_(hook)))
+					hook = hook->left_;
+				else if (compare_(item_(hook), key))
+					hook = hook->right_;
+				else
+					return hook;
+			}
+			return nullptr;
+		}
+
+		void replaceChild_(Hook_* parent, Hook_* oldChild, Hook_* newChild)
+		{
+			if (parent == nullptr)
+				root_ = newChild;
+			else if (parent->left_ == oldChild)
+				parent->left_ = newChild;
+			else
+				parent->right_ = newChild;
+		}
+
+		static void updateHeight_(Hook_* hook)
+		{
+			hook->height_ = 1 + std::max(height_(hook->left_), height_(hook->right_));
+		}
+
+		Hook_* rotateLeft_(Hook_* hook)
+		{
+			Hook_* pivot = hook->right_;
+			hook->right_ = pivot->left_;
+			if (pivot->left_ != nullptr)
+				pivot->left_->parent_ = hook;
+			pivot->parent_ = hook->parent_;
+			replaceChild_(hook->parent_, hook, pivot);
+			pivot->left_ = hook;
+			hook->parent_ = pivot;
+			updateHeight_(hook);
+			updateHeight_(pivot);
+			return pivot;
+		}
+
+		Hook_* rotateRight_(Hook_* hook)
+		{
+			Hook_* pivot = hook->left_;
+			hook->left_ = pivot->right_;
+			if (pivot->right_ != nullptr)
+				pivot->right_->parent_ = hook;
+			pivot->parent_ = hook->parent_;
+			replaceChild_(hook->parent_, hook, pivot);
+			pivot->right_ = hook;
+			hook->parent_ = pivot;
+			updateHeight_(hook);
+			updateHeight_(pivot);
+			return pivot;
+		}
+
+		// restores the heights and the AVL balance from the hook up to the root
+		void rebalance_(Hook_* hook)
+		{
+			while (hook != nullptr) {
+				updateHeight_(hook);
+				int balance = height_(hook->left_) - height_(hook->right_);
+				if (balance > 1) {
+					if (height_(hook->left_->left_) < height_(hook->left_->right_))
+						rotateLeft_(hook->left_);
+					hook = rotateRight_(hook);
+				}
+				else if (balance < -1) {
+					if (height_(hook->right_->right_) < height_(hook->right_->left_))
+						rotateRight_(hook->right_);
+					hook = rotateLeft_(hook);
+				}
+				hook = hook->parent_;
+			}
+		}
+
+		void unlink_(Hook_* hook)
+		{
+			Hook_* rebalanceFrom;
+			if (hook->left_ != nullptr && hook->right_ != nullptr) {
+				// move the successor (which has no left child) into the hook's place in the tree
+				Hook_* successor = leftmost_(hook->right_);
+				if (successor->parent_ == hook) {
+					rebalanceFrom = successor;
+				}
+				else {
+					rebalanceFrom = successor->parent_;
+					rebalanceFrom->left_ = successor->right_;
+					if (successor->right_ != nullptr)
+						successor->right_->parent_ = rebalanceFrom;
+					successor->right_ = hook->right_;
+					hook->right_->parent_ = successor;
+				}
+				successor->left_ = hook->left_;
+				hook->left_->parent_ = successor;
+				successor->parent_ = hook->parent_;
+				replaceChild_(hook->parent_, hook, successor);
+				successor->height_ = hook->height_;
+			}
+			else {
+				Hook_* child = hook->left_ != nullptr ? hook->left_ : hook->right_;
+				if (child != nullptr)
+					child->parent_ = hook->parent_;
+				replaceChild_(hook->parent_, hook, child);
+				rebalanceFrom = hook->parent_;
+			}
+			hook->parent_ = hook->left_ = hook->right_ = nullptr;
+			hook->height_ = 0;
+			hook->owner_ = nullptr;
+			--size_;
+			rebalance_(rebalanceFrom);
+		}
+
+		static void clear_(Hook_* hook)
+		{
+			while (hook != nullptr) {
+				clear_(hook->right_);
+				Hook_* left = hook->left_;
+				hook->parent_ = hook->left_ = hook->right_ = nullptr;
+				hook->height_ = 0;
+				hook->owner_ = nullptr;
+				hook = left;
+			}
+		}
+
+		Hook_* root_ = nullptr;
+		size_t size_ = 0;
+		Compare compare_;
+	};
+
+	/// @name IntrusiveList and IntrusiveSet overloads
+	/// Overloads of the wrapper functions for the intrusive containers. add() and remove() take the
+	/// object itself (not a copy) and never allocate.
+	/// For an IntrusiveList, find() and count() look for that very object and everything is O(1).
+	/// For an IntrusiveSet, find(), count() and remove() look for an equal object and are O(log n).
+	///@{
+	///
+	/// find() overload for intrusive list.
+	template<typename ItemType, typename Tag>
+	auto find(const IntrusiveList<ItemType, Tag>& inContainer, const ItemType& item)
+	{
+		return inContainer.find(item);
+	}
+	///
+	/// find() overload for intrusive set.
+	template<typename ItemType, typename Compare, typename Tag, typename KeyType>
+	auto find(const IntrusiveSet<ItemType, Compare, Tag>& inContainer, const KeyType& item)
+	{
+		return inContainer.find(item);
+	}
+	///
+	/// count() overload for intrusive list.
+	template<typename ItemType, typename Tag>
+	size_t count(const IntrusiveList<ItemType, Tag>& inContainer, const ItemType& item)
+	{
+		return inContainer.contains(item) ? 1 : 0;
+	}
+	///
+	/// count() overload for intrusive set.
+	template<typename ItemType, typename Compare, typename Tag, typename KeyType>
+	size_t count(const IntrusiveSet<ItemType, Compare, Tag>& inContainer, const KeyType& item)
+	{
+		return inContainer.count(item);
+	}
+	///
+	/// add() overload for intrusive list, links the object in at the end (unless it is already in a list with the same tag).
+	template<typename ItemType, typename Tag>
+	void add(IntrusiveList<ItemType, Tag>& inContainer, ItemType& item)
+	{
+		inContainer.push_back(item);
+	}
+	///
+	/// add() overload for intrusive set, links the object in unless an equal one is there (or it is already in a set with the same tag).
+	template<typename ItemType, typename Compare, typename Tag>
+	void add(IntrusiveSet<ItemType, Compare, Tag>& inContainer, ItemType& item)
+	{
+		inContainer.insert(item);
+	}
+	///
+	/// addAll() overload that links every object of a container (e.g. a pool) into an intrusive list.
+	template<typename ItemType, typename Tag, typename FromContainerType>
+	void addAll(IntrusiveList<ItemType, Tag>& inContainer, FromContainerType& items)
+	{
+		for (auto& item : items)
+			inContainer.push_back(item);
+	}
+	///
+	/// addAll() overload that links every object of a container (e.g. a pool) into an intrusive set.
+	template<typename ItemType, typename Compare, typename Tag, typename FromContainerType>
+	void addAll(IntrusiveSet<ItemType, Compare, Tag>& inContainer, FromContainerType& items)
+	{
+		for (auto& item : items)
+			inContainer.insert(item);
+	}
+	///
+	/// remove() overload for intrusive list, unlinks the object if it is in the list.
+	template<typename ItemType, typename Tag>
+	void remove(IntrusiveList<ItemType, Tag>& fromContainer, ItemType& item)
+	{
+		fromContainer.erase(item);
+	}
+	///
+	/// remove() overload for intrusive set, unlinks the object equal to the item.
+	template<typename ItemType, typename Compare, typename Tag, typename KeyType>
+	void remove(IntrusiveSet<ItemType, Compare, Tag>& fromContainer, const KeyType& item)
+	{
+		fromContainer.erase(item);
+	}
+	///@}
+
+	// internal, a read only memory mapping of a whole file
+	class MappedFile_
+	{
+	public:
+		MappedFile_() = default;
+		MappedFile_(const MappedFile_&) = delete;
+		MappedFile_& operator=(const MappedFile_&) = delete;
+		MappedFile_(MappedFile_&& other) noexcept { swap_(other); }
+		MappedFile_& operator=(MappedFile_&& other) noexcept { close(); swap_(other); return *this; }
+		~MappedFile_() { close(); }
+
+		bool open(const std::string& path)
+		{
+			close();
+#if defined(_WIN32)
+			HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+				return false;
+			LARGE_INTEGER size;
+			HANDLE mapping = nullptr;
+			if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+				mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			CloseHandle(file);
+			if (mapping == nullptr)
+				return false;
+			void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			CloseHandle(mapping);
+			if (data == nullptr)
+				return false;
+			data_ = static_cast<const uint8_t*>(data);
+			size_ = static_cast<size_t>(size.QuadPart);
+#else
+			int file = ::open(path.c_str(), O_RDONLY);
+			if (file < 0)
+				return false;
+			struct stat status;
+			void* data = MAP_FAILED;
+			if (fstat(file, &status) == 0 && status.st_size > 0)
+				data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, file, 0);
+			::close(file);
+			if (data == MAP_FAILED)
+				return false;
+			data_ = static_cast<const uint8_t*>(data);
+			size_ = static_cast<size_t>(status.st_size);
+#endif
+			return true;
+		}
+
+		void close()
+		{
+			if (data_ == nullptr)
+				return;
+#if defined(_WIN32)
+			UnmapViewOfFile(data_);
+#else
+			munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+			data_ = nullptr;
+			size_ = 0;
+		}
+
+		const uint8_t* data() const { return data_; }
+		size_t size() const { return size_; }
+
+	private:
+		void swap_(MappedFile_& other)
+		{
+			std::swap(data_, other.data_);
+			std::swap(size_, other.size_);
+		}
+
+		const uint8_t* data_ = nullptr;
+		size_t size_ = 0;
+	};
+
+	// internal, the id of the running process (to name temporary files)
+	inline unsigned long processId_()
+	{
+#if defined(_WIN32)
+		return static_cast<unsigned long>(GetCurrentProcessId());
+#else
+		return static_cast<unsigned long>(getpid());
+#endif
+	}
+
+	// internal, writes a file under a temporary name next to the target, then commit() renames it over the
+	// target. Processes that have the old file mapped keep reading it whole (it isn't truncated under them),
+	// and a write that fails leaves the target as it was. The temporary file is deleted if commit() isn't reached.
+	class ReplacingFile_
+	{
+	public:
+		explicit ReplacingFile_(const std::string& path) : path_(path)
+		{
+			static std::atomic<uint64_t> counter{ 0 };
+			tempPath_ = path + "." + std::to_string(processId_()) + "_" + std::to_string(counter++) + ".tmp";
+			file_ = std::fopen(tempPath_.c_str(), "wb");
+		}
+
+		ReplacingFile_(const ReplacingFile_&) = delete;
+		ReplacingFile_& operator=(const ReplacingFile_&) = delete;
+
+		~ReplacingFile_()
+		{
+			if (file_ != nullptr) {
+				std::fclose(file_);
+				std::remove(tempPath_.c_str());
+			}
+		}
+
+		std::FILE* file() const { return file_; }
+
+		// flushes the file to disk and renames it over the target. Returns false (leaving the target as it was) on failure.
+		bool commit()
+		{
+			if (file_ == nullptr)
+				return false;
+			bool ok = std::fflush(file_) == 0;
+#if defined(_WIN32)
+			ok = ok && _commit(_fileno(file_)) == 0;
+#else
+			ok = ok && fsync(fileno(file_)) == 0;
+#endif
+			ok = std::fclose(file_) == 0 && ok;
+			file_ = nullptr;
+#if defined(_WIN32)
+			ok = ok && MoveFileExA(tempPath_.c_str(), path_.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+			ok = ok && std::rename(tempPath_.c_str(), path_.c_str()) == 0;
+#endif
+			if (!ok)
+				std::remove(tempPath_.c_str());
+			return ok;
+		}
+
+	private:
+		std::string path_;
+		std::string tempPath_;
+		std::FILE* file_ = nullptr;
+	};
+
+	/// How the entries of a mapped set/map file are laid out.
+	enum class MappedLayout : uint32_t
+	{
+		Sorted = 0, ///< entries sorted by key, found by binary search, iterated in key order
+		Hashed = 1 ///< entries in the order they were written, found through an open addressing table of entry indices
+	};
+
+	// internal, header of the mapped set/map file format. Integers are in native byte order. The file is:
+	// header | keys (count fixed width entries) | values (count fixed width entries, maps only) |
+	// slots (slotCount uint32 entry index + 1, 0 for empty, hashed layout only) | heap (bytes of the strings)
+	// Every section starts at a multiple of 8 bytes. String keys/values are stored as fixed width
+	// (offset, length) entries pointing into the heap.
+	struct MappedHeader_
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t layout;
+		uint32_t keyKind;
+		uint32_t keySize;
+		uint32_t valueKind;
+		uint32_t valueSize;
+		uint64_t count;
+		uint64_t slotCount;
+		uint64_t keysOffset;
+		uint64_t valuesOffset;
+		uint64_t slotsOffset;
+		uint64_t heapOffset;
+		uint64_t fileSize;
+		uint64_t bodyChecksum; // hashBytes() of everything after the header
+		uint64_t headerChecksum; // hashBytes() of the header up to this field
+
+		static constexpr char magic_[8] = { 'S', 'T', 'L', 'W', 'M', 'A', 'P', '\0' };
+		static constexpr uint32_t version_ = 1;
+	};
+
+	// internal, the value type of mapped sets
+	struct MappedNone_ {};
+
+	// internal, how a type is stored in the mapped file format. Trivially copyable types are stored as
+	// their bytes (so they must not have padding), strings as an (offset, length) entry into the heap.
+	template<typename T, typename Enable = void>
+	struct MappedCodec_
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "mapped sets/maps can only hold trivially copyable types and strings");
+		static_assert(!std::is_pointer_v<T>, "mapped sets/maps can't hold pointers (the addresses would be written to the file)");
+		using View = T;
+		static constexpr uint32_t kind = 0;
+		static constexpr uint32_t size = sizeof(T);
+
+		static View view(const T& value) { return value; }
+		static void write(uint8_t* entry, const T& value, std::string&) { std::memcpy(entry, &value, sizeof(T)); }
+		static View read(const uint8_t* entry, const uint8_t*, uint64_t) { T value; std::memcpy(&value, entry, sizeof(T)); return value; }
+		static uint64_t hash(const T& value) { return hashBytes(&value, sizeof(T)); }
+	};
+
+	template<typename T>
+	struct MappedCodec_<T, std::enable_if_t<std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>>>
+	{
+		using View = std::string_view;
+		static constexpr uint32_t kind = 1;
+		static constexpr uint32_t size = 16;
+
+		static View view(const T& value) { return View(value); }
+		static void write(uint8_t* entry, View value, std::string& heap)
+		{
+			uint64_t offset = heap.size(), length = value.size();
+			heap.append(value.data(), value.size());
+			std::memcpy(entry, &offset, 8);
+			std::memcpy(entry + 8, &length, 8);
+		}
+		static View read(const uint8_t* entry, const uint8_t* heap, uint64_t heapSize)
+		{
+			uint64_t offset = read64_(entry), length = read64_(entry + 8);
+			if (offset > heapSize || length > heapSize - offset)
+				return View(); // corrupt entry, never read outside the file
+			return View(reinterpret_cast<const char*>(heap + offset), static_cast<size_t>(length));
+		}
+		static uint64_t hash(View value) { return hashBytes(value.data(), value.size()); }
+	};
+
+	template<>
+	struct MappedCodec_<MappedNone_>
+	{
+		using View = MappedNone_;
+		static constexpr uint32_t kind = 2;
+		static constexpr uint32_t size = 0;
+
+		static View view(const MappedNone_&) { return View(); }
+		static void write(uint8_t*, const MappedNone_&, std::string&) {}
+		static View read(const uint8_t*, const uint8_t*, uint64_t) { return View(); }
+	};
+
+	// internal, writes entries (key, value pairs) in the mapped file format. Returns false if the file couldn't be written.
+	template<typename KeyType, typename ValueType>
+	bool writeMapped_(const std::string& path, std::vector<std::pair<KeyType, ValueType>>& entries, MappedLayout layout)
+	{
+		using KeyCodec = MappedCodec_<KeyType>;
+		using ValueCodec = MappedCodec_<ValueType>;
+		auto align8 = [](uint64_t offset) { return (offset + 7) & ~uint64_t(7); };
+
+		// drop duplicate keys (keeping the first), and order the entries for the layout
+		std::vector<uint32_t> slots;
+		if (layout == MappedLayout::Hashed && entries.size() >= 0xffffffffULL)
+			layout = MappedLayout::Sorted; // entry indices in the slots are 32 bits
+		if (layout == MappedLayout::Sorted) {
+			auto less = [](const auto& a, const auto& b) { return KeyCodec::view(a.first) < KeyCodec::view(b.first); };
+			std::stable_sort(entries.begin(), entries.end(), less);
+			entries.erase(std::unique(entries.begin(), entries.end(), [&less](const auto& a, const auto& b) { return !less(a, b) && !less(b, a); }), entries.end());
+		}
+		else {
+			size_t slotCount = 8;
+			while (slotCount < entries.size() * 2)
+				slotCount *= 2;
+			slots.assign(slotCount, 0);
+			size_t kept = 0;
+			for (size_t i = 0; i < entries.size(); ++i) {
+				auto key = KeyCodec::view(entries[i].first);
+				size_t slot = static_cast<size_t>(KeyCodec::hash(key)) & (slotCount - 1);
+				bool duplicate = false;
+				for (; slots[slot] != 0; slot = (slot + 1) & (slotCount - 1)) {
+					if (KeyCodec::view(entries[slots[slot] - 1].first) == key) {
+						duplicate = true;
+						break;
+					}
+				}
+				if (duplicate)
+					continue;
+				if (kept != i)
+					entries[kept] = std::move(entries[i]);
+				slots[slot] = static_cast<uint32_t>(++kept);
+			}
+			entries.resize(kept);
+		}
+
+		MappedHeader_ header{};
+		std::memcpy(header.magic, MappedHeader_::magic_, 8);
+		header.version = MappedHeader_::version_;
+		header.layout = static_cast<uint32_t>(layout);
+		header.keyKind = KeyCodec::kind;
+		header.keySize = KeyCodec::size;
+		header.valueKind = ValueCodec::kind;
+		header.valueSize = ValueCodec::size;
+		header.count = entries.size();
+		header.slotCount = slots.size();
+		header.keysOffset = align8(sizeof(MappedHeader_));
+		header.valuesOffset = align8(header.keysOffset + header.count * KeyCodec::size);
+		header.slotsOffset = align8(header.valuesOffset + header.count * ValueCodec::size);
+		header.heapOffset = align8(header.slotsOffset + header.slotCount * 4);
+
+		std::string heap;
+		std::vector<uint8_t> body(static_cast<size_t>(header.heapOffset - sizeof(MappedHeader_)), 0);
+		uint8_t* base = body.data() - sizeof(MappedHeader_); // so that file offsets can be used as indices
+		for (size_t i = 0; i < entries.size(); ++i) {
+			KeyCodec::write(base + header.keysOffset + i * KeyCodec::size, entries[i].first, heap);
+			ValueCodec::write(base + header.valuesOffset + i * ValueCodec::size, entries[i].second, heap);
+		}
+		if (!slots.empty())
+			std::memcpy(base + header.slotsOffset, slots.data(), slots.size() * 4);
+		body.insert(body.end(), heap.begin(), heap.end());
+		header.fileSize = sizeof(MappedHeader_) + body.size();
+		header.bodyChecksum = hashBytes(body.data(), body.size());
+		header.headerChecksum = hashBytes(&header, offsetof(MappedHeader_, headerChecksum));
+
+		// written next to the file and renamed over it, so processes that have the old file mapped aren't disturbed
+		ReplacingFile_ file(path);
+		if (file.file() == nullptr)
+			return false;
+		bool written = std::fwrite(&header, sizeof(header), 1, file.file()) == 1 &&
+			(body.empty() || std::fwrite(body.data(), body.size(), 1, file.file()) == 1);
+		return written && file.commit();
+	}
+
+	// internal, the reading side of the mapped file format, shared by MappedSet and MappedMap
+	template<typename KeyType, typename ValueType>
+	class MappedTable_
+	{
+		using KeyCodec_ = MappedCodec_<KeyType>;
+		using ValueCodec_ = MappedCodec_<ValueType>;
+
+	public:
+		using KeyView = typename KeyCodec_::View;
+		using ValueView = typename ValueCodec_::View;
+
+		// maps the file and checks that its header is valid and matches the key and value types
+		bool open(const std::string& path, bool verifyChecksum)
+		{
+			close();
+			if (!file_.open(path))
+				return false;
+			if (file_.size() < sizeof(MappedHeader_)) {
+				close();
+				return false;
+			}
+			std::memcpy(&header_, file_.data(), sizeof(MappedHeader_));
+			const MappedHeader_& h = header_;
+			bool valid = std::memcmp(h.magic, MappedHeader_::magic_, 8) == 0 && h.version == MappedHeader_::version_ &&
+				h.headerChecksum == hashBytes(&h, offsetof(MappedHeader_, headerChecksum)) &&
+				h.fileSize == file_.size() && h.layout <= 1 && h.count <= h.fileSize && h.slotCount <= h.fileSize &&
+				h.keyKind == KeyCodec_::kind && h.keySize == KeyCodec_::size &&
+				h.valueKind == ValueCodec_::kind && h.valueSize == ValueCodec_::size &&
+				h.keysOffset >= sizeof(MappedHeader_) && fits_(h.keysOffset, h.count, h.keySize, h.valuesOffset) &&
+				fits_(h.valuesOffset, h.count, h.valueSize, h.slotsOffset) &&
+				fits_(h.slotsOffset, h.slotCount, 4, h.heapOffset) && h.heapOffset <= h.fileSize &&
+				(h.layout == static_cast<uint32_t>(MappedLayout::Sorted) || (h.slotCount > h.count && (h.slotCount & (h.slotCount - 1)) == 0));
+			if (valid && verifyChecksum)
+				valid = this->verifyChecksum();
+			if (!valid)
+				close();
+			return valid;
+		}
+
+		void close()
+		{
+			file_.close();
+			header_ = MappedHeader_{};
+		}
+
+		/// Checks the checksum of the whole file (this reads every page of it).
+		bool verifyChecksum() const
+		{
+			return file_.data() != nullptr && header_.bodyChecksum == hashBytes(file_.data() + sizeof(MappedHeader_), file_.size() - sizeof(MappedHeader_));
+		}
+
+		bool isOpen() const { return file_.data() != nullptr; }
+		size_t size() const { return static_cast<size_t>(header_.count); }
+		MappedLayout layout() const { return static_cast<MappedLayout>(header_.layout); }
+
+		KeyView key(size_t index) const { return KeyCodec_::read(keyEntry_(index), file_.data() + header_.heapOffset, header_.fileSize - header_.heapOffset); }
+		ValueView value(size_t index) const { return ValueCodec_::read(valueEntry_(index), file_.data() + header_.heapOffset, header_.fileSize - header_.heapOffset); }
+
+		// index of the entry with the key, or size()
+		size_t indexOf(KeyView key) const
+		{
+			size_t count = size();
+			if (count == 0)
+				return count;
+			if (header_.layout == static_cast<uint32_t>(MappedLayout::Sorted)) {
+				size_t first = 0, length = count;
+				while (length > 0) {
+					size_t half = length / 2;
+					if (this->key(first + half) < key) {
+						first += half + 1;
+						length -= half + 1;
+					}
+					else {
+						length = half;
+					}
+				}
+				return first < count && this->key(first) == key ? first : count;
+			}
+			size_t mask = static_cast<size_t>(header_.slotCount) - 1;
+			const uint8_t* slots = file_.data() + header_.slotsOffset;
+			size_t slot = static_cast<size_t>(KeyCodec_::hash(key)) & mask;
+			for (size_t probes = 0; probes <= mask; ++probes, slot = (slot + 1) & mask) {
+				uint32_t entry;
+				std::memcpy(&entry, slots + slot * 4, 4);
+				if (entry == 0 || entry > count)
+					return count;
+				if (this->key(entry - 1) == key)
+					return entry - 1;
+			}
+			return count; // only a corrupt table has no empty slot
+		}
+
+	private:
+		// true if count entries of entrySize bytes starting at offset end at or before end (without overflowing)
+		static bool fits_(uint64_t offset, uint64_t count, uint64_t entrySize, uint64_t end)
+		{
+			return offset <= end && (entrySize == 0 || count <= (end - offset) / entrySize);
+		}
+
+		const uint8_t* keyEntry_(size_t index) const { return file_.data() + header_.keysOffset + index * KeyCodec_::size; }
+		const uint8_t* valueEntry_(size_t index) const { return file_.data() + header_.valuesOffset + index * ValueCodec_::size; }
+
+		MappedFile_ file_;
+		MappedHeader_ header_{};
+	};
+
+	/// A read only set stored in a file (written by writeMappedSet()) that is memory mapped, not loaded:
+	/// opening it only maps the file and checks its header, lookups read the file's pages in place, and
+	/// the pages are shared (through the OS page cache) by all the processes that open the same file.
+	/// Keys can be strings, viewed in place as std::string_view, or trivially copyable types without padding
+	/// (integers, enums, plain structs with == and <), stored as their bytes (so files move between machines
+	/// with the same endianness).
+	/// The file format is versioned and has checksums; see MappedLayout for the two layouts.
+	/// find() is O(1) for files written with the hashed layout and O(log n) for the sorted layout.
+	template<typename KeyType>
+	class MappedSet
+	{
+		using Table_ = MappedTable_<KeyType, MappedNone_>;
+
+	public:
+		using value_type = typename Table_::KeyView;
+
+		/// Iterates over the keys (in key order for the sorted layout, in written order for the hashed one).
+		class const_iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = typename Table_::KeyView;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = value_type;
+
+			const_iterator() = default;
+			const_iterator(const Table_* table, size_t index) : table_(table), index_(index) {}
+
+			reference operator*() const { return table_->key(index_); }
+			const_iterator& operator++() { ++index_; return *this; }
+			const_iterator operator++(int) { const_iterator old = *this; ++index_; return old; }
+			bool operator==(const const_iterator& other) const { return index_ == other.index_; }
+			bool operator!=(const const_iterator& other) const { return index_ != other.index_; }
+
+		private:
+			const Table_* table_ = nullptr;
+			size_t index_ = 0;
+		};
+		using iterator = const_iterator;
+
+		MappedSet() = default;
+
+		/// Opens the file, see open().
+		explicit MappedSet(const std::string& path, bool verifyChecksum = false)
+		{
+			open(path, verifyChecksum);
+		}
+
+		/// Maps the file. Returns false (and leaves the set closed and empty) if the file can't be mapped, isn't
+		/// a mapped set of this key type, or is corrupt. The checksum of the whole file is only checked if
+		/// 'verifyChecksum' is true, since that reads all of it.
+		bool open(const std::string& path, bool verifyChecksum = false) { return table_.open(path, verifyChecksum); }
+		void close() { table_.close(); }
+		bool isOpen() const { return table_.isOpen(); }
+		bool verifyChecksum() const { return table_.verifyChecksum(); }
+		MappedLayout layout() const { return table_.layout(); }
+
+		const_iterator begin() const { return const_iterator(&table_, 0); }
+		const_iterator end() const { return const_iterator(&table_, table_.size()); }
+		size_t size() const { return table_.size(); }
+		bool empty() const { return table_.size() == 0; }
+
+		template<typename ItemType>
+		const_iterator find(const ItemType& item) const { return const_iterator(&table_, table_.indexOf(value_type(item))); }
+
+		template<typename ItemType>
+		size_t count(const ItemType& item) const { return table_.indexOf(value_type(item)) == table_.size() ? 0 : 1; }
+
+	private:
+		Table_ table_;
+	};
+
+	/// A read only map stored in a file (written by writeMappedMap()) that is memory mapped, not loaded.
+	/// See MappedSet; values can be trivially copyable types or strings too.
+	template<typename KeyType, typename ValueType>
+	class MappedMap
+	{
+		using Table_ = MappedTable_<KeyType, ValueType>;
+
+	public:
+		using key_type = typename Table_::KeyView;
+		using mapped_type = typename Table_::ValueView;
+		using value_type = std::pair<key_type, mapped_type>;
+
+		/// Iterates over the key-value pairs (in key order for the sorted layout, in written order for the hashed one).
+		class const_iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::pair<key_type, mapped_type>;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = value_type;
+
+			struct ArrowProxy_
+			{
+				value_type pair;
+				const value_type* operator->() const { return &pair; }
+			};
+
+			const_iterator() = default;
+			const_iterator(const Table_* table, size_t index) : table_(table), index_(index) {}
+
+			reference operator*() const { return reference(table_->key(index_), table_->value(index_)); }
+			ArrowProxy_ operator->() const { return ArrowProxy_{ **this }; }
+			const_iterator& operator++() { ++index_; return *this; }
+			const_iterator operator++(int) { const_iterator old = *this; ++index_; return old; }
+			bool operator==(const const_iterator& other) const { return index_ == other.index_; }
+			bool operator!=(const const_iterator& other) const { return index_ != other.index_; }
+
+		private:
+			const Table_* table_ = nullptr;
+			size_t index_ = 0;
+		};
+		using iterator = const_iterator;
+
+		MappedMap() = default;
+
+		/// Opens the file, see open().
+		explicit MappedMap(const std::string& path, bool verifyChecksum = false)
+		{
+			open(path, verifyChecksum);
+		}
+
+		/// Maps the file, see MappedSet::open().
+		bool open(const std::string& path, bool verifyChecksum = false) { return table_.open(path, verifyChecksum); }
+		void close() { table_.close(); }
+		bool isOpen() const { return table_.isOpen(); }
+		bool verifyChecksum() const { return table_.verifyChecksum(); }
+		MappedLayout layout() const { return table_.layout(); }
+
+		const_iterator begin() const { return const_iterator(&table_, 0); }
+		const_iterator end() const { return const_iterator(&table_, table_.size()); }
+		size_t size() const { return table_.size(); }
+		bool empty() const { return table_.size() == 0; }
+
+		template<typename ItemType>
+		const_iterator find(const ItemType& key) const { return const_iterator(&table_, table_.indexOf(key_type(key))); }
+
+		template<typename ItemType>
+		size_t count(const ItemType& key) const { return table_.indexOf(key_type(key)) == table_.size() ? 0 : 1; }
+
+	private:
+		Table_ table_;
+	};
+
+	/// Writes the items of a container (any container of trivially copyable items or strings) as a file
+	/// that MappedSet<ItemType> can open. Duplicate items are written once. An existing file is replaced
+	/// atomically (the new file is written under a temporary name, then renamed over it), so processes that
+	/// have the old file open keep reading it unchanged. Returns false if the file couldn't be written.
+	template<typename ContainerType>
+	bool writeMappedSet(const std::string& path, const ContainerType& items, MappedLayout layout = MappedLayout::Hashed)
+	{
+		using ItemType = std::decay_t<decltype(*std::begin(items))>;
+		std::vector<std::pair<ItemType, MappedNone_>> entries;
+		for (const auto& item : items)
+			entries.emplace_back(item, MappedNone_());
+		return writeMapped_(path, entries, layout);
+	}
+
+	/// Writes the key-value pairs of a map (or any container of pairs) as a file that MappedMap<KeyType, ValueType>
+	/// can open. If a key appears more than once, its first value is written. An existing file is replaced
+	/// atomically, as by writeMappedSet(). Returns false if the file couldn't be written.
+	template<typename MapType>
+	bool writeMappedMap(const std::string& path, const MapType& map, MappedLayout layout = MappedLayout::Hashed)
+	{
+		using PairType = decltype(*std::begin(map));
+		using KeyType = std::decay_t<decltype(std::declval<PairType>().first)>;
+		using ValueType = std::decay_t<decltype(std::declval<PairType>().second)>;
+		std::vector<std::pair<KeyType, ValueType>> entries;
+		for (const auto& item : map)
+			entries.emplace_back(item.first, item.second);
+		return writeMapped_(path, entries, layout);
+	}
+
+	/// @name MappedSet and MappedMap overloads
+	/// Overloads of the wrapper functions for the memory mapped containers (which are read only).
+	/// String keys can be searched with anything convertible to std::string_view.
+	/// Complexity is constant for the hashed layout and logarithmic for the sorted layout.
+	///@{
+	///
+	/// find() overload for mapped set.
+	template<typename KeyType, typename ItemType>
+	auto find(const MappedSet<KeyType>& inContainer, const ItemType& item)
+	{
+		return inContainer.find(item);
+	}
+	///
+	/// find() overload for mapped map.
+	template<typename KeyType, typename ValueType, typename ItemType>
+	auto find(const MappedMap<KeyType, ValueType>& inContainer, const ItemType& item)
+	{
+		return inContainer.find(item);
+	}
+	///
+	/// count() overload for mapped set.
+	template<typename KeyType, typename ItemType>
+	size_t count(const MappedSet<KeyType>& inContainer, const ItemType& item)
+	{
+		return inContainer.count(item);
+	}
+	///
+	/// count() overload for mapped map.
+	template<typename KeyType, typename ValueType, typename ItemType>
+	size_t count(const MappedMap<KeyType, ValueType>& inContainer, const ItemType& item)
+	{
+		return inContainer.count(item);
+	}
+	///@}
+
+	/// A sink that serialize() can write to, appending the bytes to a vector in memory.
+	class MemorySink
+	{
+	public:
+		bool write(const void* data, size_t size)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			bytes_.insert(bytes_.end(), bytes, bytes + size);
+			return true;
+		}
+
+		bool flush() { return true; }
+
+		const std::vector<uint8_t>& bytes() const { return bytes_; }
+		std::vector<uint8_t>& bytes() { return bytes_; }
+
+	private:
+		std::vector<uint8_t> bytes_;
+	};
+
+	/// A source that deserialize() can read from, reading bytes from memory (which must outlive the source).
+	class MemorySource
+	{
+	public:
+		MemorySource(const void* data, size_t size) : data_(static_cast<const uint8_t*>(data)), size_(size) {}
+		explicit MemorySource(const std::vector<uint8_t>& bytes) : MemorySource(bytes.data(), bytes.size()) {}
+
+		/// Reads up to 'size' bytes, returns how many were read (less only at the end of the data).
+		size_t read(void* data, size_t size)
+		{
+			size_t count = std::min(size, size_ - position_);
+			if (count != 0)
+				std::memcpy(data, data_ + position_, count);
+			position_ += count;
+			return count;
+		}
+
+		/// The number of bytes left to read.
+		std::optional<uint64_t> remaining() const { return size_ - position_; }
+
+	private:
+		const uint8_t* data_;
+		size_t size_;
+		size_t position_ = 0;
+	};
+
+	/// A sink that writes to a C file (which stays open, and is buffered by the C library).
+	class FileSink
+	{
+	public:
+		explicit FileSink(std::FILE* file) : file_(file) {}
+
+		bool write(const void* data, size_t size) { return size == 0 || std::fwrite(data, 1, size, file_) == size; }
+		bool flush() { return std::fflush(file_) == 0; }
+
+	private:
+		std::FILE* file_;
+	};
+
+	/// A source that reads from a C file (which stays open).
+	class FileSource
+	{
+	public:
+		explicit FileSource(std::FILE* file) : file_(file) {}
+
+		size_t read(void* data, size_t size) { return std::fread(data, 1, size, file_); }
+
+		/// The number of bytes left to read, if the file is a regular file.
+		std::optional<uint64_t> remaining() const
+		{
+#if defined(_WIN32)
+			struct _stat64 status;
+			int64_t position = _ftelli64(file_);
+			if (_fstat64(_fileno(file_), &status) != 0 || (status.st_mode & _S_IFREG) == 0 || position < 0 || position > status.st_size)
+				return std::nullopt;
+#else
+			struct stat status;
+			off_t position = ftello(file_);
+			if (fstat(fileno(file_), &status) != 0 || !S_ISREG(status.st_mode) || position < 0 || position > status.st_size)
+				return std::nullopt;
+#endif
+			return static_cast<uint64_t>(status.st_size - position);
+		}
+
+	private:
+		std::FILE* file_;
+	};
+
+	/// A sink that writes to a file descriptor (which stays open). serialize() writes in large blocks,
+	/// so there is no need for buffering on top.
+	class FdSink
+	{
+	public:
+		explicit FdSink(int fd) : fd_(fd) {}
+
+		bool write(const void* data, size_t size)
+		{
+			const char* bytes = static_cast<const char*>(data);
+			while (size != 0) {
+#if defined(_WIN32)
+				int written = _write(fd_, bytes, static_cast<unsigned>(std::min<size_t>(size, 1u << 30)));
+#else
+				ssize_t written = ::write(fd_, bytes, size);
+#endif
+				if (written <= 0)
+					return false;
+				bytes += written;
+				size -= static_cast<size_t>(written);
+			}
+			return true;
+		}
+
+		bool flush() { return true; }
+
+	private:
+		int fd_;
+	};
+
+	/// A source that reads from a file descriptor (which stays open).
+	class FdSource
+	{
+	public:
+		explicit FdSource(int fd) : fd_(fd) {}
+
+		size_t read(void* data, size_t size)
+		{
+			char* bytes = static_cast<char*>(data);
+			size_t total = 0;
+			while (total < size) {
+#if defined(_WIN32)
+				int count = _read(fd_, bytes + total, static_cast<unsigned>(std::min<size_t>(size - total, 1u << 30)));
+#else
+				ssize_t count = ::read(fd_, bytes + total, size - total);
+#endif
+				if (count <= 0)
+					break;
+				total += static_cast<size_t>(count);
+			}
+			return total;
+		}
+
+		/// The number of bytes left to read, if the file descriptor is of a regular file.
+		std::optional<uint64_t> remaining() const
+		{
+#if defined(_WIN32)
+			struct _stat64 status;
+			int64_t position = _lseeki64(fd_, 0, SEEK_CUR);
+			if (_fstat64(fd_, &status) != 0 || (status.st_mode & _S_IFREG) == 0 || position < 0 || position > status.st_size)
+				return std::nullopt;
+#else
+			struct stat status;
+			off_t position = lseek(fd_, 0, SEEK_CUR);
+			if (fstat(fd_, &status) != 0 || !S_ISREG(status.st_mode) || position < 0 || position > status.st_size)
+				return std::nullopt;
+#endif
+			return static_cast<uint64_t>(status.st_size - position);
+		}
+
+	private:
+		int fd_;
+	};
+
+	/// Compression of the blocks written by serialize().
+	enum class Compression
+	{
+		None, ///< blocks are stored as they are
+		Lz ///< blocks are compressed with a fast LZ77 compressor (in the style of LZ4), stored as they are if that doesn't make them smaller
+	};
+
+	// internal, largest possible size of lzCompress_() output for 'size' bytes of input
+	inline size_t lzBound_(size_t size)
+	{
+		return size + size / 255 + 16;
+	}
+
+	// internal, LZ77 compression with a 64 KB window. The output is a series of sequences, each a token
+	// byte (literal count in the high nibble, match length - 4 in the low nibble, 15 meaning more length
+	// bytes follow, each adding up to 255), the literals, then a 2 byte offset and the extra match length
+	// bytes. The last sequence has only literals. Returns the size of the output.
+	inline size_t lzCompress_(const uint8_t* input, size_t size, uint8_t* output)
+	{
+		const int hashBits = 12;
+		uint32_t table[1 << hashBits] = {};
+		uint8_t* out = output;
+		auto writeLength = [&out](size_t length) {
+			for (; length >= 255; length -= 255)
+				*out++ = 255;
+			*out++ = static_cast<uint8_t>(length);
+		};
+		auto writeSequence = [&](const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength) {
+			uint8_t* token = out++;
+			*token = static_cast<uint8_t>(std::min<size_t>(literalCount, 15) << 4);
+			if (literalCount >= 15)
+				writeLength(literalCount - 15);
+			if (literalCount != 0)
+				std::memcpy(out, literals, literalCount);
+			out += literalCount;
+			if (matchLength == 0)
+				return;
+			*out++ = static_cast<uint8_t>(offset);
+			*out++ = static_cast<uint8_t>(offset >> 8);
+			*token |= static_cast<uint8_t>(std::min<size_t>(matchLength - 4, 15));
+			if (matchLength - 4 >= 15)
+				writeLength(matchLength - 4 - 15);
+		};
+
+		size_t anchor = 0;
+		size_t limit = size > 5 ? size - 5 : 0; // the last bytes are always literals
+		size_t i = 0;
+		while (i + 4 <= limit) {
+			uint32_t word = static_cast<uint32_t>(read32_(input + i));
+			uint32_t slot = (word * 2654435761u) >> (32 - hashBits);
+			size_t candidate = table[slot];
+			table[slot] = static_cast<uint32_t>(i);
+			if (candidate < i && i - candidate <= 65535 && static_cast<uint32_t>(read32_(input + candidate)) == word) {
+				size_t length = 4;
+				while (i + length < limit && input[candidate + length] == input[i + length])
+					++length;
+				writeSequence(input + anchor, i - anchor, i - candidate, length);
+				i += length;
+				anchor = i;
+			}
+			else {
+				++i;
+			}
+		}
+		writeSequence(input + anchor, size - anchor, 0, 0);
+		return static_cast<size_t>(out - output);
+	}
+
+	// internal, decompresses lzCompress_() output into exactly 'size' bytes. Returns false if the input is corrupt.
+	inline bool lzDecompress_(const uint8_t* input, size_t inputSize, uint8_t* output, size_t size)
+	{
+		const uint8_t* in = input;
+		const uint8_t* inEnd = input + inputSize;
+		size_t position = 0;
+		auto readLength = [&in, inEnd](size_t& length) {
+			uint8_t byte;
+			do {
+				if (in == inEnd)
+					return false;
+				byte = *in++;
+				length += byte;
+			} while (byte == 255);
+			return true;
+		};
+		while (true) {
+			if (in == inEnd)
+				return false;
+			uint8_t token = *in++;
+			size_t literalCount = token >> 4;
+			if (literalCount == 15 && !readLength(literalCount))
+				return false;
+			if (literalCount > static_cast<size_t>(inEnd - in) || literalCount > size - position)
+				return false;
+			if (literalCount != 0)
+				std::memcpy(output + position, in, literalCount);
+			in += literalCount;
+			position += literalCount;
+			if (in == inEnd)
+				return position == size;
+
+			if (inEnd - in < 2)
+				return false;
+			size_t offset = in[0] | (size_t(in[1]) << 8);
+			in += 2;
+			size_t matchLength = token & 15;
+			if (matchLength == 15 && !readLength(matchLength))
+				return false;
+			matchLength += 4;
+			if (offset == 0 || offset > position || matchLength > size - position)
+				return false;
+			uint8_t* target = output + position;
+			const uint8_t* match = target - offset;
+			if (offset >= matchLength) {
+				std::memcpy(target, match, matchLength);
+			}
+			else {
+				for (size_t j = 0; j < matchLength; ++j) // overlapping, repeats the last 'offset' bytes
+					target[j] = match[j];
+			}
+			position += matchLength;
+		}
+	}
+
+	// internal, the serialize() stream is a header followed by blocks of at most blockSize_ bytes, each
+	// prefixed with its size and its stored size (equal when it is stored as it is, smaller when compressed),
+	// and an empty block at the end
+	constexpr size_t serializeBlockSize_ = 64 * 1024;
+	constexpr char serializeMagic_[8] = { 'S', 'T', 'L', 'W', 'S', 'E', 'R', '1' };
+
+	// internal, splits what serialize() writes into (possibly compressed) blocks
+	template<typename SinkType>
+	class BlockWriter_
+	{
+	public:
+		BlockWriter_(SinkType& sink, Compression compression) : sink_(sink), compression_(compression)
+		{
+			block_.reserve(serializeBlockSize_);
+			ok_ = sink_.write(serializeMagic_, sizeof(serializeMagic_));
+		}
+
+		void write(const void* data, size_t size)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			while (size != 0) {
+				size_t count = std::min(size, serializeBlockSize_ - block_.size());
+				block_.insert(block_.end(), bytes, bytes + count);
+				bytes += count;
+				size -= count;
+				if (block_.size() == serializeBlockSize_)
+					flushBlock_();
+			}
+		}
+
+		void writeVarint(uint64_t value)
+		{
+			uint8_t bytes[10];
+			size_t count = 0;
+			for (; value >= 0x80; value >>= 7)
+				bytes[count++] = static_cast<uint8_t>(value | 0x80);
+			bytes[count++] = static_cast<uint8_t>(value);
+			write(bytes, count);
+		}
+
+		// writes the last block and the end marker, returns false if anything failed to be written
+		bool finish()
+		{
+			flushBlock_();
+			uint32_t end[2] = { 0, 0 };
+			ok_ = ok_ && sink_.write(end, sizeof(end)) && sink_.flush();
+			return ok_;
+		}
+
+	private:
+		void flushBlock_()
+		{
+			if (block_.empty() || !ok_)
+				return;
+			uint32_t sizes[2] = { static_cast<uint32_t>(block_.size()), static_cast<uint32_t>(block_.size()) };
+			const uint8_t* stored = block_.data();
+			if (compression_ == Compression::Lz) {
+				compressed_.resize(lzBound_(block_.size()));
+				size_t compressedSize = lzCompress_(block_.data(), block_.size(), compressed_.data());
+				if (compressedSize < block_.size()) {
+					sizes[1] = static_cast<uint32_t>(compressedSize);
+					stored = compressed_.data();
+				}
+			}
+			ok_ = sink_.write(sizes, sizeof(sizes)) && sink_.write(stored, sizes[1]);
+			block_.clear();
+		}
+
+		SinkType& sink_;
+		Compression compression_;
+		std::vector<uint8_t> block_;
+		std::vector<uint8_t> compressed_;
+		bool ok_;
+	};
+
+	// internal, true for sources that know how many bytes they have left (remaining())
+	template<typename SourceType, typename = void>
+	struct HasRemaining_ : std::false_type {};
+	template<typename SourceType>
+	struct HasRemaining_<SourceType, std::void_t<decltype(std::declval<const SourceType&>().remaining())>> : std::true_type {};
+
+	// internal, the most bytes one byte of lzCompress_() output decompresses to (a match length byte of 255)
+	constexpr uint64_t lzMaxExpansion_ = 255;
+
+	// internal, reads the blocks written by BlockWriter_
+	template<typename SourceType>
+	class BlockReader_
+	{
+	public:
+		explicit BlockReader_(SourceType& source) : source_(source)
+		{
+			char magic[sizeof(serializeMagic_)];
+			ok_ = source_.read(magic, sizeof(magic)) == sizeof(magic) && std::memcmp(magic, serializeMagic_, sizeof(magic)) == 0;
+		}
+
+		bool ok() const { return ok_; }
+
+		bool read(void* data, size_t size)
+		{
+			uint8_t* bytes = static_cast<uint8_t*>(data);
+			while (size != 0) {
+				if (position_ == block_.size() && !nextBlock_())
+					return false;
+				size_t count = std::min(size, block_.size() - position_);
+				std::memcpy(bytes, block_.data() + position_, count);
+				position_ += count;
+				bytes += count;
+				size -= count;
+			}
+			return true;
+		}
+
+		bool readVarint(uint64_t& value)
+		{
+			value = 0;
+			for (unsigned shift = 0; shift < 64; shift += 7) {
+				uint8_t byte;
+				if (!read(&byte, 1))
+					return false;
+				value |= uint64_t(byte & 0x7f) << shift;
+				if ((byte & 0x80) == 0)
+					return true;
+			}
+			return ok_ = false;
+		}
+
+		// an upper bound of the bytes left to read: the rest of the block, plus the rest of the source if it
+		// were all compressed as much as possible. Nothing if the source doesn't know its size.
+		std::optional<uint64_t> maxBytesLeft() const
+		{
+			if constexpr (HasRemaining_<SourceType>::value) {
+				std::optional<uint64_t> stored = source_.remaining();
+				if (stored && *stored <= (~uint64_t(0) - serializeBlockSize_) / lzMaxExpansion_)
+					return (block_.size() - position_) + *stored * lzMaxExpansion_;
+			}
+			return std::nullopt;
+		}
+
+		// true if everything was read, up to and including the end marker
+		bool finish()
+		{
+			return ok_ && position_ == block_.size() && !nextBlock_() && ended_;
+		}
+
+	private:
+		bool nextBlock_()
+		{
+			uint32_t sizes[2];
+			if (!ok_ || ended_ || source_.read(sizes, sizeof(sizes)) != sizeof(sizes))
+				return ok_ = false;
+			if (sizes[0] == 0) {
+				ended_ = true;
+				return false;
+			}
+			if (sizes[0] > serializeBlockSize_ || sizes[1] > sizes[0])
+				return ok_ = false;
+			block_.resize(sizes[0]);
+			position_ = 0;
+			if (sizes[1] == sizes[0])
+				return ok_ = source_.read(block_.data(), sizes[0]) == sizes[0];
+			compressed_.resize(sizes[1]);
+			ok_ = source_.read(compressed_.data(), sizes[1]) == sizes[1] &&
+				lzDecompress_(compressed_.data(), sizes[1], block_.data(), block_.size());
+			return ok_;
+		}
+
+		SourceType& source_;
+		std::vector<uint8_t> block_;
+		std::vector<uint8_t> compressed_;
+		size_t position_ = 0;
+		bool ok_;
+		bool ended_ = false;
+	};
+
+	// internal, type traits for serialization
+	template<typename T>
+	struct IsPair_ : std::false_type {};
+	template<typename First, typename Second>
+	struct IsPair_<std::pair<First, Second>> : std::true_type {};
+
+	template<typename T>
+	constexpr bool isString_ = std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>;
+
+	template<typename T, typename = void>
+	struct IsRange_ : std::false_type {};
+	template<typename T>
+	struct IsRange_<T, std::void_t<decltype(std::begin(std::declval<const T&>())), decltype(std::end(std::declval<const T&>()))>> : std::true_type {};
+
+	template<typename T, typename = void>
+	struct IsContiguous_ : std::false_type {};
+	template<typename T>
+	struct IsContiguous_<T, std::void_t<decltype(std::declval<const T&>().data()), decltype(std::declval<const T&>().size())>>
+		: std::is_same<std::remove_cv_t<std::remove_pointer_t<decltype(std::declval<const T&>().data())>>, std::decay_t<decltype(*std::begin(std::declval<const T&>()))>> {};
+
+	template<typename T, typename = void>
+	struct HasReserve_ : std::false_type {};
+	template<typename T>
+	struct HasReserve_<T, std::void_t<decltype(std::declval<T&>().reserve(size_t()))>> : std::true_type {};
+
+	// internal, the type a serialized item is read back into (strings for string views, no const/references in pairs)
+	template<typename T>
+	struct Owned_ { using Type = std::remove_cv_t<T>; };
+	template<>
+	struct Owned_<std::string_view> { using Type = std::string; };
+	template<typename First, typename Second>
+	struct Owned_<std::pair<First, Second>> { using Type = std::pair<typename Owned_<std::decay_t<First>>::Type, typename Owned_<std::decay_t<Second>>::Type>; };
+
+	template<typename Writer, typename T>
+	void encode_(Writer& writer, const T& value);
+
+	// internal, writes the item count and the items of a container (all at once if they are contiguous trivially copyable items)
+	template<typename Writer, typename ContainerType>
+	void encodeRange_(Writer& writer, const ContainerType& container)
+	{
+		using ItemType = std::decay_t<decltype(*std::begin(container))>;
+		if constexpr (IsContiguous_<ContainerType>::value && std::is_trivially_copyable_v<ItemType> && !IsPair_<ItemType>::value) {
+			writer.writeVarint(container.size());
+			writer.write(container.data(), container.size() * sizeof(ItemType));
+		}
+		else {
+			writer.writeVarint(static_cast<uint64_t>(std::distance(std::begin(container), std::end(container))));
+			for (const auto& item : container)
+				encode_(writer, item);
+		}
+	}
+
+	template<typename Writer, typename T>
+	void encode_(Writer& writer, const T& value)
+	{
+		if constexpr (isString_<T>) {
+			writer.writeVarint(value.size());
+			writer.write(value.data(), value.size());
+		}
+		else if constexpr (IsPair_<T>::value) {
+			encode_(writer, value.first);
+			encode_(writer, value.second);
+		}
+		else if constexpr (std::is_trivially_copyable_v<T>) {
+			writer.write(&value, sizeof(T));
+		}
+		else {
+			static_assert(IsRange_<T>::value, "serialize() supports trivially copyable types, strings, pairs and containers of those");
+			encodeRange_(writer, value);
+		}
+	}
+
+	template<typename Reader, typename T>
+	bool decode_(Reader& reader, T& value);
+
+	// internal, the fewest bytes an item takes in the stream (to check item counts against the size of the input)
+	template<typename T>
+	constexpr uint64_t minEncodedSize_()
+	{
+		if constexpr (isString_<T>)
+			return 1;
+		else if constexpr (IsPair_<T>::value)
+			return minEncodedSize_<typename T::first_type>() + minEncodedSize_<typename T::second_type>();
+		else if constexpr (std::is_trivially_copyable_v<T>)
+			return sizeof(T) == 0 ? 1 : sizeof(T);
+		else
+			return 1; // the item count of a nested container
+	}
+
+	// internal, reads the items of a container back, adding them with add() (so sorted containers are built
+	// with end() hints, and hashed containers are reserved first)
+	template<typename Reader, typename ContainerType>
+	bool decodeRange_(Reader& reader, ContainerType& container)
+	{
+		using ItemType = typename Owned_<std::decay_t<decltype(*std::begin(container))>>::Type;
+		uint64_t count;
+		if (!reader.readVarint(count))
+			return false;
+		// the count comes from the input, so it is only trusted if the rest of the input could hold that many
+		// items; then the container is reserved once, otherwise memory is allocated as the items arrive
+		const uint64_t chunk = 1 << 16;
+		std::optional<uint64_t> bytesLeft = reader.maxBytesLeft();
+		bool plausible = bytesLeft && count <= *bytesLeft / minEncodedSize_<ItemType>() && count <= size_t(-1);
+		if constexpr (HasReserve_<ContainerType>::value)
+			container.reserve(static_cast<size_t>(plausible ? count : std::min(count, chunk)));
+
+		if constexpr (std::is_trivially_copyable_v<ItemType> && !IsPair_<ItemType>::value) {
+			if constexpr (std::is_same_v<ContainerType, std::vector<ItemType>>) {
+				for (uint64_t done = 0; done < count;) {
+					size_t now = static_cast<size_t>(std::min(count - done, chunk));
+					container.resize(container.size() + now);
+					if (!reader.read(container.data() + container.size() - now, now * sizeof(ItemType)))
+						return false;
+					done += now;
+				}
+				return true;
+			}
+			else {
+				std::vector<ItemType> items;
+				for (uint64_t done = 0; done < count;) {
+					size_t now = static_cast<size_t>(std::min(count - done, chunk));
+					items.resize(now);
+					if (!reader.read(items.data(), now * sizeof(ItemType)))
+						return false;
+					for (const auto& item : items)
+						add(container, item);
+					done += now;
+				}
+				return true;
+			}
+		}
+		else {
+			for (uint64_t i = 0; i < count; ++i) {
+				ItemType item{};
+				if (!decode_(reader, item))
+					return false;
+				add(container, item);
+			}
+			return true;
+		}
+	}
+
+	template<typename Reader, typename T>
+	bool decode_(Reader& reader, T& value)
+	{
+		if constexpr (std::is_same_v<T, std::string>) {
+			uint64_t size;
+			if (!reader.readVarint(size))
+				return false;
+			value.clear();
+			for (uint64_t done = 0; done < size;) {
+				size_t now = static_cast<size_t>(std::min<uint64_t>(size - done, 1 << 16));
+				value.resize(value.size() + now);
+				if (!reader.read(&value[value.size() - now], now))
+					return false;
+				done += now;
+			}
+			return true;
+		}
+		else if constexpr (IsPair_<T>::value) {
+			return decode_(reader, value.first) && decode_(reader, value.second);
+		}
+		else if constexpr (std::is_trivially_copyable_v<T>) {
+			return reader.read(&value, sizeof(T));
+		}
+		else {
+			return decodeRange_(reader, value);
+		}
+	}
+
+	/// @name serialize(container, sink) and deserialize<ContainerType>(source)
+	/// Binary serialization of containers.
+	///@{
+	///
+	/// Writes a container to a sink (MemorySink, FileSink, FdSink, or anything with
+	/// `bool write(const void*, size_t)` and `bool flush()`), for deserialize() to read back.
+	/// Works with the STL containers and the containers of this library that add() supports, holding
+	/// trivially copyable items (written as their bytes, all at once when the container is contiguous),
+	/// strings (length prefixed), pairs (maps) and containers of those.
+	/// With Compression::Lz the stream is compressed in 64 KB blocks.
+	/// Returns false if the sink failed to write.
+	/// @note Trivially copyable items are written as their bytes, so read them back on a machine with the
+	/// same endianness (and with the same type).
+	template<typename ContainerType, typename SinkType>
+	bool serialize(const ContainerType& container, SinkType&& sink, Compression compression = Compression::None)
+	{
+		BlockWriter_<std::remove_reference_t<SinkType>> writer(sink, compression);
+		encodeRange_(writer, container);
+		return writer.finish();
+	}
+	///
+	/// Reads a container written by serialize() from a source (MemorySource, FileSource, FdSource, or
+	/// anything with `size_t read(void*, size_t)`). Items are added as they are read, so a container
+	/// written in sorted order is rebuilt with end() hints. Vectors and hashed containers are reserved up
+	/// front when the source knows how many bytes it has left (MemorySource, and FileSource/FdSource on
+	/// regular files; other sources can have a `std::optional<uint64_t> remaining()`) and the stored item count
+	/// fits in them; otherwise they grow as the items arrive.
+	/// Returns nothing if the input is truncated or corrupt.
+	template<typename ContainerType, typename SourceType>
+	std::optional<ContainerType> deserialize(SourceType&& source)
+	{
+		BlockReader_<std::remove_reference_t<SourceType>> reader(source);
+		ContainerType container;
+		if (!reader.ok() || !decodeRange_(reader, container) || !reader.finish())
+			return std::nullopt;
+		return std::optional<ContainerType>(std::move(container));
+	}
+	///@}
+
+	/// A fixed set of worker threads for the parallel parts of the library (such as loadSnapshot()).
+	/// parallelFor() splits a loop over the workers and the calling thread. Calls may be nested (a task may
+	/// call parallelFor() itself), since a waiting caller keeps running items of its own loop.
+	class ThreadPool
+	{
+	public:
+		/// Creates the pool with threadCount - 1 workers (the thread calling parallelFor() is the last one).
+		explicit ThreadPool(size_t threadCount = std::max<size_t>(1, std::thread::hardware_concurrency()))
+		{
+			for (size_t i = 1; i < threadCount; ++i)
+				workers_.emplace_back([this]() { work_(); });
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				stopping_ = true;
+			}
+			wake_.notify_all();
+			for (auto& worker : workers_)
+				worker.join();
+		}
+
+		/// Number of threads that run parallelFor() items (the workers and the caller).
+		size_t threadCount() const { return workers_.size() + 1; }
+
+		/// Runs task(i) for every i in [0, count), spread over the threads, and returns once all have run.
+		/// If a task throws, the items that haven't started are skipped, and once the running ones have
+		/// finished the first exception is rethrown on the calling thread.
+		template<typename TaskType>
+		void parallelFor(size_t count, TaskType&& task)
+		{
+			if (count == 0)
+				return;
+			if (count == 1 || workers_.empty()) {
+				for (size_t i = 0; i < count; ++i)
+					task(i);
+				return;
+			}
+
+			// workers that only start after the loop is done find no item left, so the state is shared with them
+			struct Loop
+			{
+				std::atomic<size_t> next{ 0 };
+				std::atomic<size_t> done{ 0 };
+				std::atomic<bool> failed{ false };
+				std::exception_ptr error; // the first exception a task threw (guarded by mutex)
+				std::mutex mutex;
+				std::condition_variable finished;
+			};
+			auto loop = std::make_shared<Loop>();
+			size_t total = count;
+			auto* taskPointer = &task;
+			// every item is counted as done, even skipped ones, so the caller (and the task it refers to) outlives the tasks
+			auto runItems = [loop, total, taskPointer]() {
+				for (size_t i = loop->next++; i < total; i = loop->next++) {
+					if (!loop->failed) {
+						try {
+							(*taskPointer)(i);
+						}
+						catch (...) {
+							std::lock_guard<std::mutex> lock(loop->mutex);
+							if (!loop->error)
+								loop->error = std::current_exception();
+							loop->failed = true;
+						}
+					}
+					if (++loop->done == total) {
+						std::lock_guard<std::mutex> lock(loop->mutex);
+						loop->finished.notify_all();
+					}
+				}
+			};
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				for (size_t i = 0, helpers = std::min(workers_.size(), count - 1); i < helpers; ++i)
+					queue_.push_back(runItems);
+			}
+			wake_.notify_all();
+			runItems();
+			std::unique_lock<std::mutex> lock(loop->mutex);
+			loop->finished.wait(lock, [&]() { return loop->done == total; });
+			if (loop->error)
+				std::rethrow_exception(loop->error);
+		}
+
+		/// Runs the job on a worker, without waiting for it (or right away, on the calling thread, if the pool has no workers).
+		void post(std::function<void()> job)
+		{
+			if (workers_.empty()) {
+				job();
+				return;
+			}
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				queue_.push_back(std::move(job));
+			}
+			wake_.notify_one();
+		}
+
+	private:
+		void work_()
+		{
+			while (true) {
+				std::function<void()> job;
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					wake_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+					if (queue_.empty())
+						return;
+					job = std::move(queue_.front());
+					queue_.pop_front();
+				}
+				job();
+			}
+		}
+
+		std::vector<std::thread> workers_;
+		std::deque<std::function<void()>> queue_;
+		std::mutex mutex_;
+		std::condition_variable wake_;
+		bool stopping_ = false;
+	};
+
+	/// The pool the library uses when none is given, with one thread per core (created on first use).
+	inline ThreadPool& defaultThreadPool()
+	{
+		static ThreadPool pool;
+		return pool;
+	}
+
+	// internal, a snapshot file is the magic, the chunks (each a serialize() stream of up to itemsPerChunk
+	// items, decodable on its own), a directory of SnapshotChunk_ entries, and a SnapshotTrailer_
+	constexpr char snapshotMagic_[8] = { 'S', 'T', 'L', 'W', 'S', 'N', 'P', '1' };
+
+	struct SnapshotChunk_
+	{
+		uint64_t offset;
+		uint64_t size;
+		uint64_t itemCount;
+	};
+
+	struct SnapshotTrailer_
+	{
+		uint64_t chunkCount;
+		uint64_t directoryOffset;
+		uint64_t directoryChecksum;
+		char magic[8];
+	};
+
+	/// The shard (0 to shardCount - 1) loadSnapshotShards() puts a key in.
+	template<typename KeyType>
+	size_t shardOf(const KeyType& key, size_t shardCount)
+	{
+		return static_cast<size_t>(mixHash(FastHash<KeyType>()(key)) % shardCount);
+	}
+
+	/// Writes a container to a snapshot file, in chunks of itemsPerChunk items that loadSnapshot() decodes
+	/// in parallel. Items are stored like serialize() stores them (optionally compressed). An existing file is
+	/// replaced atomically (written under a temporary name, then renamed over it), so loads running on the old
+	/// file are unaffected. Returns false if the file couldn't be written.
+	template<typename ContainerType>
+	bool writeSnapshot(const std::string& path, const ContainerType& container, Compression compression = Compression::None, size_t itemsPerChunk = 1 << 16)
+	{
+		ReplacingFile_ replacing(path);
+		std::FILE* file = replacing.file();
+		if (file == nullptr)
+			return false;
+		bool ok = std::fwrite(snapshotMagic_, sizeof(snapshotMagic_), 1, file) == 1;
+		std::vector<SnapshotChunk_> directory;
+		uint64_t offset = sizeof(snapshotMagic_);
+		MemorySink chunk;
+		auto position = std::begin(container);
+		auto end = std::end(container);
+		while (ok && position != end) {
+			size_t itemCount = 0;
+			for (auto counter = position; counter != end && itemCount < std::max<size_t>(itemsPerChunk, 1); ++counter)
+				++itemCount;
+			chunk.bytes().clear();
+			BlockWriter_<MemorySink> writer(chunk, compression);
+			writer.writeVarint(itemCount);
+			for (size_t i = 0; i < itemCount; ++i, ++position)
+				encode_(writer, *position);
+			writer.finish();
+			ok = std::fwrite(chunk.bytes().data(), 1, chunk.bytes().size(), file) == chunk.bytes().size();
+			directory.push_back(SnapshotChunk_{ offset, chunk.bytes().size(), itemCount });
+			offset += chunk.bytes().size();
+		}
+		SnapshotTrailer_ trailer{ directory.size(), offset, hashBytes(directory.data(), directory.size() * sizeof(SnapshotChunk_)), {} };
+		std::memcpy(trailer.magic, snapshotMagic_, sizeof(snapshotMagic_));
+		ok = ok && (directory.empty() || std::fwrite(directory.data(), sizeof(SnapshotChunk_), directory.size(), file) == directory.size());
+		ok = ok && std::fwrite(&trailer, sizeof(trailer), 1, file) == 1;
+		return ok && replacing.commit();
+	}
+
+	// internal, maps a snapshot file and reads its directory of chunks. Returns false if the file is missing or corrupt.
+	template<typename ItemType>
+	bool openSnapshot_(const std::string& path, MappedFile_& file, std::vector<SnapshotChunk_>& directory)
+	{
+		if (!file.open(path) || file.size() < sizeof(snapshotMagic_) + sizeof(SnapshotTrailer_))
+			return false;
+		SnapshotTrailer_ trailer;
+		std::memcpy(&trailer, file.data() + file.size() - sizeof(trailer), sizeof(trailer));
+		size_t directoryLimit = file.size() - sizeof(trailer);
+		if (std::memcmp(file.data(), snapshotMagic_, sizeof(snapshotMagic_)) != 0 || std::memcmp(trailer.magic, snapshotMagic_, sizeof(snapshotMagic_)) != 0 ||
+			trailer.directoryOffset > directoryLimit || trailer.chunkCount > (directoryLimit - trailer.directoryOffset) / sizeof(SnapshotChunk_))
+			return false;
+		directory.resize(static_cast<size_t>(trailer.chunkCount));
+		if (!directory.empty())
+			std::memcpy(directory.data(), file.data() + trailer.directoryOffset, directory.size() * sizeof(SnapshotChunk_));
+		if (hashBytes(directory.data(), directory.size() * sizeof(SnapshotChunk_)) != trailer.directoryChecksum)
+			return false;
+		for (const auto& chunk : directory) {
+			// item counts are used to size containers before decoding, so they must fit in the chunk
+			if (chunk.offset > trailer.directoryOffset || chunk.size > trailer.directoryOffset - chunk.offset ||
+				chunk.itemCount > chunk.size * lzMaxExpansion_ / minEncodedSize_<ItemType>())
+				return false;
+		}
+		return true;
+	}
+
+	// internal, decodes a chunk of a snapshot into items (replacing them). Returns false if it is corrupt.
+	template<typename ItemType>
+	bool decodeSnapshotChunk_(const MappedFile_& file, const SnapshotChunk_& chunk, std::vector<ItemType>& items)
+	{
+		items.clear();
+		MemorySource source(file.data() + chunk.offset, static_cast<size_t>(chunk.size));
+		BlockReader_<MemorySource> reader(source);
+		return reader.ok() && decodeRange_(reader, items) && reader.finish() && items.size() == chunk.itemCount;
+	}
+
+	// internal, true for containers with insert(position, item) (the STL ones), which take the item by move
+	template<typename ContainerType, typename ItemType, typename = void>
+	struct HasMoveInsert_ : std::false_type {};
+	template<typename ContainerType, typename ItemType>
+	struct HasMoveInsert_<ContainerType, ItemType, std::void_t<decltype(std::declval<ContainerType&>().insert(std::end(std::declval<ContainerType&>()), std::declval<ItemType&&>()))>>
+		: std::true_type {};
+
+	// internal, adds an item that isn't needed anymore, moving it into the container when it can take it that way
+	template<typename ContainerType, typename ItemType>
+	void addMoved_(ContainerType& container, ItemType& item)
+	{
+		if constexpr (HasMoveInsert_<ContainerType, ItemType>::value)
+			container.insert(std::end(container), std::move(item));
+		else
+			add(container, item);
+	}
+
+	// internal, adds chunks of items to a container: a vector of the items is grown once and filled in parallel,
+	// other containers are reserved (if they can be) and filled in chunk order (each chunk is freed once added)
+	template<typename ContainerType, typename ItemType>
+	void addChunks_(ContainerType& container, std::vector<std::vector<ItemType>>& chunks, ThreadPool& pool)
+	{
+		size_t total = 0;
+		for (const auto& chunk : chunks)
+			total += chunk.size();
+		if constexpr (std::is_same_v<ContainerType, std::vector<ItemType>>) {
+			std::vector<size_t> offsets(chunks.size() + 1, container.size());
+			for (size_t i = 0; i < chunks.size(); ++i)
+				offsets[i + 1] = offsets[i] + chunks[i].size();
+			container.resize(offsets.back());
+			pool.parallelFor(chunks.size(), [&](size_t index) {
+				std::move(chunks[index].begin(), chunks[index].end(), container.begin() + offsets[index]);
+				std::vector<ItemType>().swap(chunks[index]);
+			});
+		}
+		else {
+			if constexpr (HasReserve_<ContainerType>::value)
+				container.reserve(std::size(container) + total);
+			for (auto& chunk : chunks) {
+				for (auto& item : chunk)
+					addMoved_(container, item);
+				std::vector<ItemType>().swap(chunk);
+			}
+		}
+	}
+
+	/// Loads a container from a file written by writeSnapshot(). The file is memory mapped and its chunks are
+	/// decoded in parallel on the pool, and each chunk is moved into the container as soon as it is decoded,
+	/// so only a few chunks are held besides the container. A vector is sized once and filled in parallel;
+	/// other containers are reserved (if they can be) and filled in chunk order, a few chunks at a time, so the
+	/// sorted runs of a snapshot of a sorted container are appended with end() hints.
+	/// Returns nothing if the file is missing or corrupt.
+	template<typename ContainerType>
+	std::optional<ContainerType> loadSnapshot(const std::string& path, ThreadPool& pool = defaultThreadPool())
+	{
+		using ItemType = typename Owned_<std::decay_t<decltype(*std::begin(std::declval<ContainerType&>()))>>::Type;
+		MappedFile_ file;
+		std::vector<SnapshotChunk_> directory;
+		if (!openSnapshot_<ItemType>(path, file, directory))
+			return std::nullopt;
+		size_t total = 0;
+		for (const auto& chunk : directory)
+			total += static_cast<size_t>(chunk.itemCount);
+
+		ContainerType container;
+		std::atomic<bool> ok{ true };
+		if constexpr (std::is_same_v<ContainerType, std::vector<ItemType>>) {
+			std::vector<size_t> offsets(directory.size() + 1, 0);
+			for (size_t i = 0; i < directory.size(); ++i)
+				offsets[i + 1] = offsets[i] + static_cast<size_t>(directory[i].itemCount);
+			container.resize(total);
+			pool.parallelFor(directory.size(), [&](size_t index) {
+				std::vector<ItemType> items;
+				if (!ok || !decodeSnapshotChunk_(file, directory[index], items)) {
+					ok = false;
+					return;
+				}
+				std::move(items.begin(), items.end(), container.begin() + offsets[index]);
+			});
+		}
+		else {
+			if constexpr (HasReserve_<ContainerType>::value)
+				container.reserve(total);
+			// a window of chunks is decoded in parallel, then added in order while the next window waits
+			std::vector<std::vector<ItemType>> chunks(pool.threadCount());
+			for (size_t first = 0; ok && first < directory.size(); first += chunks.size()) {
+				size_t count = std::min(chunks.size(), directory.size() - first);
+				pool.parallelFor(count, [&](size_t index) {
+					if (!decodeSnapshotChunk_(file, directory[first + index], chunks[index]))
+						ok = false;
+				});
+				for (size_t index = 0; ok && index < count; ++index) {
+					for (auto& item : chunks[index])
+						addMoved_(container, item);
+					chunks[index].clear();
+				}
+			}
+		}
+		if (!ok)
+			return std::nullopt;
+		return std::optional<ContainerType>(std::move(container));
+	}
+
+	/// Loads a snapshot into shardCount containers (of any hashed or sorted type), each item going to
+	/// shard shardOf(key, shardCount), where the key of a pair is its first member. A window of chunks is
+	/// decoded and partitioned in parallel (a chunk per thread), then moved into the shards in parallel (a
+	/// shard per thread), so a large hash map loads in about 1/threadCount the time while only a few chunks
+	/// are held besides the shards. Returns nothing if the file is missing or corrupt.
+	template<typename ContainerType>
+	std::optional<std::vector<ContainerType>> loadSnapshotShards(const std::string& path, size_t shardCount, ThreadPool& pool = defaultThreadPool())
+	{
+		using ItemType = typename Owned_<std::decay_t<decltype(*std::begin(std::declval<ContainerType&>()))>>::Type;
+		shardCount = std::max<size_t>(shardCount, 1);
+		MappedFile_ file;
+		std::vector<SnapshotChunk_> directory;
+		if (!openSnapshot_<ItemType>(path, file, directory))
+			return std::nullopt;
+
+		std::vector<ContainerType> shards(shardCount);
+		if constexpr (HasReserve_<ContainerType>::value) {
+			// the hash spreads the keys evenly, so each shard gets about total / shardCount of them
+			size_t total = 0;
+			for (const auto& chunk : directory)
+				total += static_cast<size_t>(chunk.itemCount);
+			size_t perShard = total / shardCount;
+			for (auto& shard : shards)
+				shard.reserve(perShard + perShard / 16);
+		}
+
+		std::atomic<bool> ok{ true };
+		std::vector<std::vector<ItemType>> chunks(pool.threadCount());
+		std::vector<std::vector<std::vector<ItemType>>> parts(chunks.size(), std::vector<std::vector<ItemType>>(shardCount)); // [chunk][shard]
+		for (size_t first = 0; ok && first < directory.size(); first += chunks.size()) {
+			size_t count = std::min(chunks.size(), directory.size() - first);
+			pool.parallelFor(count, [&](size_t index) {
+				if (!decodeSnapshotChunk_(file, directory[first + index], chunks[index])) {
+					ok = false;
+					return;
+				}
+				for (auto& item : chunks[index]) {
+					size_t shard;
+					if constexpr (IsPair_<ItemType>::value)
+						shard = shardOf(item.first, shardCount);
+					else
+						shard = shardOf(item, shardCount);
+					parts[index][shard].push_back(std::move(item));
+				}
+				chunks[index].clear();
+			});
+			if (!ok)
+				break;
+			pool.parallelFor(shardCount, [&](size_t shard) {
+				for (size_t index = 0; index < count; ++index) {
+					for (auto& item : parts[index][shard])
+						addMoved_(shards[shard], item);
+					parts[index][shard].clear();
+				}
+			});
+		}
+		if (!ok)
+			return std::nullopt;
+		return std::optional<std::vector<ContainerType>>(std::move(shards));
+	}
+
+	/// How addAllFromFile() splits a text file into items.
+	enum class TextFormat
+	{
+		Lines, ///< one item per line (a trailing '\r' is dropped, empty lines are skipped)
+		Words ///< items separated by any whitespace
+	};
+
+	// internal, true for the bytes that separate words
+	inline bool isSpace_(uint8_t byte)
+	{
+		return byte == ' ' || byte == '\n' || byte == '\t' || byte == '\r' || byte == '\f' || byte == '\v';
+	}
+
+	// internal, parses one item of text (integers with std::from_chars, strings as they are).
+	// Returns false if the text isn't a valid item.
+	template<typename ItemType>
+	bool parseText_(const char* first, const char* last, ItemType& item)
+	{
+		if constexpr (std::is_same_v<ItemType, std::string>) {
+			item.assign(first, last);
+			return true;
+		}
+		else {
+			static_assert(std::is_integral_v<ItemType>, "addAllFromFile() supports containers of integers and strings");
+			while (first != last && (*first == ' ' || *first == '\t'))
+				++first;
+			while (last != first && (last[-1] == ' ' || last[-1] == '\t'))
+				--last;
+			if (last - first > 1 && *first == '+' && first[1] != '-') // from_chars takes '-' but not '+' (and "+-5" isn't a number)
+				++first;
+			auto result = std::from_chars(first, last, item);
+			return result.ec == std::errc() && result.ptr == last;
+		}
+	}
+
+	// internal, parses the items of a range of text that starts and ends on item boundaries.
+	// Returns the number of items that couldn't be parsed.
+	template<typename ItemType>
+	size_t parseTextChunk_(const uint8_t* data, size_t size, TextFormat format, std::vector<ItemType>& items)
+	{
+		size_t failures = 0;
+		const uint8_t* end = data + size;
+		if (format == TextFormat::Lines) {
+			items.reserve(countByte_(data, size, '\n') + 1);
+			for (const uint8_t* line = data; line < end;) {
+				const uint8_t* newline = findByte_(line, static_cast<size_t>(end - line), '\n');
+				const uint8_t* lineEnd = newline == nullptr ? end : newline;
+				const uint8_t* itemEnd = lineEnd != line && lineEnd[-1] == '\r' ? lineEnd - 1 : lineEnd;
+				if (itemEnd != line) {
+					ItemType item{};
+					if (parseText_(reinterpret_cast<const char*>(line), reinterpret_cast<const char*>(itemEnd), item))
+						items.push_back(std::move(item));
+					else
+						++failures;
+				}
+				line = newline == nullptr ? end : newline + 1;
+			}
+		}
+		else {
+			for (const uint8_t* position = data; position < end;) {
+				while (position < end && isSpace_(*position))
+					++position;
+				const uint8_t* wordEnd = position;
+				while (wordEnd < end && !isSpace_(*wordEnd))
+					++wordEnd;
+				if (wordEnd != position) {
+					ItemType item{};
+					if (parseText_(reinterpret_cast<const char*>(position), reinterpret_cast<const char*>(wordEnd), item))
+						items.push_back(std::move(item));
+					else
+						++failures;
+				}
+				position = wordEnd;
+			}
+		}
+		return failures;
+	}
+
+	/// Adds the items of a text file to a container of integers (parsed with std::from_chars, in base 10)
+	/// or of strings. The file is memory mapped and, when it is large, split at item boundaries into chunks
+	/// that are parsed in parallel on the pool. The container is then reserved (if it can be) and filled
+	/// chunk by chunk, in file order.
+	/// Returns false if the file couldn't be read or any item couldn't be parsed (the other items are still added).
+	template<typename ContainerType>
+	bool addAllFromFile(ContainerType& container, const std::string& path, TextFormat format = TextFormat::Lines, ThreadPool& pool = defaultThreadPool())
+	{
+		using ItemType = typename Owned_<std::decay_t<decltype(*std::begin(container))>>::Type;
+		MappedFile_ file;
+		if (!file.open(path)) {
+			// an empty file can't be mapped, but has no items
+			std::FILE* empty = std::fopen(path.c_str(), "rb");
+			bool isEmpty = empty != nullptr && std::fgetc(empty) == EOF;
+			if (empty != nullptr)
+				std::fclose(empty);
+			return isEmpty;
+		}
+
+		// each chunk ends just after a separator, so no item is split between two chunks
+		const size_t chunkSize = 4 << 20;
+		const uint8_t* data = file.data();
+		const size_t size = file.size();
+		std::vector<size_t> boundaries{ 0 };
+		while (boundaries.back() < size) {
+			size_t boundary = std::min(boundaries.back() + chunkSize, size);
+			if (format == TextFormat::Lines) {
+				const uint8_t* newline = findByte_(data + boundary, size - boundary, '\n');
+				boundary = newline == nullptr ? size : static_cast<size_t>(newline - data) + 1;
+			}
+			else {
+				while (boundary < size && !isSpace_(data[boundary]))
+					++boundary;
+			}
+			boundaries.push_back(boundary);
+		}
+
+		std::vector<std::vector<ItemType>> chunks(boundaries.size() - 1);
+		std::atomic<size_t> failures{ 0 };
+		pool.parallelFor(chunks.size(), [&](size_t index) {
+			failures += parseTextChunk_(data + boundaries[index], boundaries[index + 1] - boundaries[index], format, chunks[index]);
+		});
+		addChunks_(container, chunks, pool);
+		return failures == 0;
+	}
+
+	/// Memory and disk settings of the external memory set operations.
+	struct ExternalMemoryOptions
+	{
+		size_t memoryLimit = size_t(256) << 20; ///< bytes used for sorting and merging buffers (at least 1 MB)
+		std::string tempDirectory = "."; ///< local directory for the temporary sorted runs (deleted when done)
+		size_t maxOpenFiles = 256; ///< temporary files open at once (runs are merged in more passes to stay under it, at least 4)
+	};
+
+	// internal, a temporary file, deleted when destroyed. It is created open for writing; close() it once
+	// written and openForReading() it only while it is read, so only the files in use hold a descriptor.
+	class TempFile_
+	{
+	public:
+		explicit TempFile_(const std::string& directory)
+		{
+			static std::atomic<uint64_t> counter{ 0 };
+			for (int attempt = 0; attempt < 100 && file_ == nullptr; ++attempt) {
+				path_ = directory + "/stlwrappers_" + std::to_string(processId_()) + "_" + std::to_string(counter++) + ".tmp";
+				file_ = std::fopen(path_.c_str(), "wbx"); // fails if the file exists
+			}
+			created_ = file_ != nullptr;
+		}
+
+		TempFile_(const TempFile_&) = delete;
+		TempFile_& operator=(const TempFile_&) = delete;
+
+		~TempFile_()
+		{
+			if (file_ != nullptr)
+				std::fclose(file_);
+			if (created_)
+				std::remove(path_.c_str());
+		}
+
+		std::FILE* file() const { return file_; }
+
+		// closes the file (which stays on disk). Returns false if it wasn't open or writing it failed.
+		bool close()
+		{
+			bool ok = file_ != nullptr && std::fclose(file_) == 0;
+			file_ = nullptr;
+			return ok;
+		}
+
+		// opens the (closed) file again, for reading from the start
+		bool openForReading()
+		{
+			if (file_ == nullptr && created_)
+				file_ = std::fopen(path_.c_str(), "rb");
+			return file_ != nullptr;
+		}
+
+	private:
+		std::string path_;
+		std::FILE* file_ = nullptr;
+		bool created_ = false;
+	};
+
+	// internal, LSD radix sort of unsigned integers (a byte per pass, skipping the bytes that all the items share)
+	template<typename UnsignedType>
+	void radixSort_(UnsignedType* items, UnsignedType* scratch, size_t size)
+	{
+		if (size < 2)
+			return;
+		UnsignedType* from = items;
+		UnsignedType* to = scratch;
+		for (unsigned shift = 0; shift < sizeof(UnsignedType) * 8; shift += 8) {
+			size_t counts[256] = {};
+			for (size_t i = 0; i < size; ++i)
+				++counts[(from[i] >> shift) & 0xff];
+			if (counts[(from[0] >> shift) & 0xff] == size)
+				continue;
+			size_t offset = 0;
+			for (size_t& count : counts) {
+				size_t next = offset + count;
+				count = offset;
+				offset = next;
+			}
+			for (size_t i = 0; i < size; ++i)
+				to[counts[(from[i] >> shift) & 0xff]++] = from[i];
+			std::swap(from, to);
+		}
+		if (from != items)
+			std::memcpy(items, from, size * sizeof(UnsignedType));
+	}
+
+	// internal, reads the items of a run file through a buffer
+	template<typename ItemType>
+	class RunReader_
+	{
+	public:
+		RunReader_(std::FILE* file, size_t bufferSize) : file_(file), buffer_(std::max<size_t>(bufferSize, 1))
+		{
+			failed_ = std::fseek(file_, 0, SEEK_SET) != 0;
+		}
+
+		bool next(ItemType& item)
+		{
+			if (position_ == count_) {
+				if (failed_ || std::feof(file_))
+					return false;
+				count_ = std::fread(buffer_.data(), sizeof(ItemType), buffer_.size(), file_);
+				position_ = 0;
+				failed_ = std::ferror(file_) != 0;
+				if (count_ == 0)
+					return false;
+			}
+			item = buffer_[position_++];
+			return true;
+		}
+
+		bool failed() const { return failed_; }
+
+	private:
+		std::FILE* file_;
+		std::vector<ItemType> buffer_;
+		size_t position_ = 0;
+		size_t count_ = 0;
+		bool failed_;
+	};
+
+	// internal, streams the sorted union (without duplicates) of sorted runs, with a k-way heap merge.
+	// The runs are opened for reading here, and stay open until they are destroyed.
+	template<typename ItemType>
+	class MergedRuns_
+	{
+	public:
+		MergedRuns_(const std::vector<std::unique_ptr<TempFile_>>& runs, size_t bufferSize)
+		{
+			readers_.reserve(runs.size());
+			for (size_t i = 0; i < runs.size(); ++i) {
+				if (!runs[i]->openForReading()) {
+					openFailed_ = true;
+					continue;
+				}
+				readers_.emplace_back(runs[i]->file(), bufferSize);
+				ItemType item;
+				if (readers_.back().next(item))
+					heap_.push_back({ item, readers_.size() - 1 });
+			}
+			std::make_heap(heap_.begin(), heap_.end(), std::greater<>());
+		}
+
+		bool next(ItemType& item)
+		{
+			while (!heap_.empty()) {
+				std::pop_heap(heap_.begin(), heap_.end(), std::greater<>());
+				auto& top = heap_.back();
+				item = top.first;
+				if (readers_[top.second].next(top.first))
+					std::push_heap(heap_.begin(), heap_.end(), std::greater<>());
+				else
+					heap_.pop_back();
+				if (!hasLast_ || last_ != item) {
+					hasLast_ = true;
+					last_ = item;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool failed() const
+		{
+			if (openFailed_)
+				return true;
+			for (const auto& reader : readers_) {
+				if (reader.failed())
+					return true;
+			}
+			return false;
+		}
+
+	private:
+		std::vector<RunReader_<ItemType>> readers_;
+		std::vector<std::pair<ItemType, size_t>> heap_;
+		ItemType last_{};
+		bool hasLast_ = false;
+		bool openFailed_ = false;
+	};
+
+	// internal, reads a source of raw items into sorted, duplicate free runs of as many items as fit in memory
+	// (each run is closed once written, so the number of runs isn't limited by the number of open files)
+	template<typename ItemType, typename SourceType>
+	bool makeRuns_(SourceType& source, const ExternalMemoryOptions& options, std::vector<std::unique_ptr<TempFile_>>& runs)
+	{
+		using KeyType = std::make_unsigned_t<ItemType>;
+		const KeyType signBit = std::is_signed_v<ItemType> ? KeyType(KeyType(1) << (sizeof(KeyType) * 8 - 1)) : KeyType(0);
+		size_t capacity = std::max<size_t>(options.memoryLimit, 1 << 20) / (2 * sizeof(ItemType));
+		std::vector<KeyType> keys(capacity);
+		std::vector<KeyType> scratch(capacity);
+		while (true) {
+			size_t bytes = source.read(keys.data(), capacity * sizeof(ItemType));
+			if (bytes % sizeof(ItemType) != 0)
+				return false;
+			size_t size = bytes / sizeof(ItemType);
+			if (size == 0)
+				return true;
+			// signed items sort as unsigned keys once their sign bit is flipped
+			for (size_t i = 0; i < size; ++i)
+				keys[i] ^= signBit;
+			radixSort_(keys.data(), scratch.data(), size);
+			for (size_t i = 0; i < size; ++i)
+				keys[i] ^= signBit;
+			size = static_cast<size_t>(std::unique(keys.begin(), keys.begin() + size) - keys.begin());
+
+			runs.push_back(std::make_unique<TempFile_>(options.tempDirectory));
+			std::FILE* file = runs.back()->file();
+			if (file == nullptr || std::fwrite(keys.data(), sizeof(ItemType), size, file) != size || !runs.back()->close())
+				return false;
+			if (bytes < capacity * sizeof(ItemType))
+				return true;
+		}
+	}
+
+	// internal, merges runs (maxRuns at a time, into new runs) until there are at most maxRuns
+	template<typename ItemType>
+	bool reduceRuns_(std::vector<std::unique_ptr<TempFile_>>& runs, size_t maxRuns, size_t bufferSize, const ExternalMemoryOptions& options)
+	{
+		std::vector<ItemType> output(bufferSize);
+		while (runs.size() > maxRuns) {
+			std::vector<std::unique_ptr<TempFile_>> group;
+			for (size_t i = 0; i < maxRuns; ++i)
+				group.push_back(std::move(runs[i]));
+			runs.erase(runs.begin(), runs.begin() + maxRuns);
+			auto merged = std::make_unique<TempFile_>(options.tempDirectory);
+			std::FILE* file = merged->file();
+			if (file == nullptr)
+				return false;
+			MergedRuns_<ItemType> input(group, bufferSize / maxRuns);
+			size_t count = 0;
+			ItemType item;
+			bool ok = true;
+			while (ok && input.next(item)) {
+				output[count++] = item;
+				if (count == output.size()) {
+					ok = std::fwrite(output.data(), sizeof(ItemType), count, file) == count;
+					count = 0;
+				}
+			}
+			ok = ok && std::fwrite(output.data(), sizeof(ItemType), count, file) == count && merged->close() && !input.failed();
+			if (!ok)
+				return false;
+			runs.push_back(std::move(merged));
+		}
+		return true;
+	}
+
+	// internal, sorts both inputs into runs, merges them, and writes the items in the first but not the second
+	// (or, for an intersection, in both) to the sink
+	template<typename ItemType, bool Intersection, typename FirstSourceType, typename SecondSourceType, typename SinkType>
+	bool externalSetOperation_(FirstSourceType& first, SecondSourceType& second, SinkType& sink, const ExternalMemoryOptions& options)
+	{
+		static_assert(std::is_integral_v<ItemType> && !std::is_same_v<ItemType, bool>, "external set operations work on integer items");
+		std::vector<std::unique_ptr<TempFile_>> firstRuns, secondRuns;
+		if (!makeRuns_<ItemType>(first, options, firstRuns) || !makeRuns_<ItemType>(second, options, secondRuns))
+			return false;
+
+		// every open run gets a buffer of at least 64 KB, so memory bounds how many runs are merged at once, and
+		// so does the number of open files (the last merge reads maxRuns runs of each input)
+		size_t memoryItems = std::max<size_t>(options.memoryLimit, 1 << 20) / sizeof(ItemType);
+		size_t minBufferItems = (64 << 10) / sizeof(ItemType);
+		size_t maxRuns = std::max<size_t>(2, std::min(memoryItems / minBufferItems / 4, options.maxOpenFiles / 2));
+		if (!reduceRuns_<ItemType>(firstRuns, maxRuns, memoryItems / 2, options) || !reduceRuns_<ItemType>(secondRuns, maxRuns, memoryItems / 2, options))
+			return false;
+
+		size_t bufferSize = memoryItems / (firstRuns.size() + secondRuns.size() + 1);
+		MergedRuns_<ItemType> a(firstRuns, bufferSize);
+		MergedRuns_<ItemType> b(secondRuns, bufferSize);
+		std::vector<ItemType> output(bufferSize);
+		size_t count = 0;
+		bool ok = true;
+		auto emit = [&](const ItemType& item) {
+			output[count++] = item;
+			if (count == output.size()) {
+				ok = ok && sink.write(output.data(), count * sizeof(ItemType));
+				count = 0;
+			}
+		};
+		ItemType x, y;
+		bool hasX = a.next(x);
+		bool hasY = b.next(y);
+		while (hasX && ok) {
+			if (!hasY || x < y) {
+				if (!Intersection)
+					emit(x);
+				hasX = a.next(x);
+			}
+			else if (y < x) {
+				hasY = b.next(y);
+			}
+			else {
+				if (Intersection)
+					emit(x);
+				hasX = a.next(x);
+				hasY = b.next(y);
+			}
+			if (Intersection && !hasY)
+				break;
+		}
+		ok = ok && sink.write(output.data(), count * sizeof(ItemType)) && sink.flush();
+		return ok && !a.failed() && !b.failed();
+	}
+
+	/// @name External memory set operations
+	/// Set operations on integer lists too large for memory. The inputs are sources of raw items (FileSource,
+	/// FdSource, MemorySource, ...), in any order and possibly with duplicates. Each input is read into
+	/// sorted runs (radix sorted, as many items as the memory limit allows) in temporary files, the runs are
+	/// merged with k-way streaming merges (in several passes if there are too many to merge at once), and
+	/// the result is written to the sink as raw items, sorted and without duplicates.
+	/// Memory use is bounded by options.memoryLimit, and the temporary files open at once by options.maxOpenFiles
+	/// (a run is only open while it is written or merged). Returns false if an input is not a whole number of
+	/// items or if reading or writing failed.
+	///@{
+	///
+	/// Writes the items that are in the first input but not in the second.
+	template<typename ItemType, typename FirstSourceType, typename SecondSourceType, typename SinkType>
+	bool externalInFirstButNotInSecond(FirstSourceType&& first, SecondSourceType&& second, SinkType&& sink, const ExternalMemoryOptions& options = ExternalMemoryOptions())
+	{
+		return externalSetOperation_<ItemType, false>(first, second, sink, options);
+	}
+	///
+	/// Writes the items that are in both inputs.
+	template<typename ItemType, typename FirstSourceType, typename SecondSourceType, typename SinkType>
+	bool externalIntersection(FirstSourceType&& first, SecondSourceType&& second, SinkType&& sink, const ExternalMemoryOptions& options = ExternalMemoryOptions())
+	{
+		return externalSetOperation_<ItemType, true>(first, second, sink, options);
+	}
+	///@}
+
+	/// Settings of a DiskHashSet.
+	struct DiskHashSetOptions
+	{
+		size_t expectedItems = size_t(1) << 20; ///< sizes the bucket pages of a new file, and the Bloom filter
+		size_t cacheBytes = size_t(64) << 20; ///< memory for cached pages
+		/// bits per expected item of the in-memory Bloom filter (0 for no filter). The filter isn't stored in the
+		/// file, so opening an existing file with a filter reads every page of it to rebuild the filter.
+		size_t bloomBitsPerItem = 10;
+	};
+
+	// internal, positions a file at a 64 bit offset
+	inline bool seekFile_(std::FILE* file, uint64_t offset)
+	{
+#if defined(_WIN32)
+		return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+		return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+	}
+
+	/// A hash set of trivially copyable items (such as ids) stored in a file, for sets larger than memory.
+	/// The file is a header page and an array of 4 KB bucket pages, each item hashed to one bucket; a bucket
+	/// that fills up chains to overflow pages appended to the file. Pages are read into an LRU cache of
+	/// cacheBytes and written back when evicted or on flush(). An optional in-memory Bloom filter answers most
+	/// searches for absent items without touching the file (it is rebuilt from the file when opened, which
+	/// reads the whole file).
+	/// While buckets don't overflow (size the set with expectedItems), a search reads at most one page.
+	/// addAll() sorts the new items by bucket first, so each page is read and written once, in file order.
+	/// @note A DiskHashSet owns an open file, so it can't be copied or moved. Changes reach the file on
+	/// flush() and close() (and when destroyed).
+	/// @note Searches are const but read pages into the cache (and move the file position), so unlike the
+	/// std containers, a DiskHashSet must not be used by several threads at once, even only for searches.
+	template<typename ItemType, typename Hash = FastHash<ItemType>>
+	class DiskHashSet
+	{
+		static_assert(std::is_trivially_copyable_v<ItemType>, "DiskHashSet stores trivially copyable items");
+
+	public:
+		static constexpr size_t pageSize = 4096;
+
+		using key_type = ItemType;
+		using value_type = ItemType;
+
+		DiskHashSet() = default;
+
+		/// Opens the set stored in the file, or creates the file if it doesn't exist (see open()).
+		explicit DiskHashSet(const std::string& path, const DiskHashSetOptions& options = DiskHashSetOptions())
+		{
+			open(path, options);
+		}
+
+		DiskHashSet(const DiskHashSet&) = delete;
+		DiskHashSet& operator=(const DiskHashSet&) = delete;
+
+		~DiskHashSet() { close(); }
+
+		/// Opens the set stored in the file, or creates the file (sized for options.expectedItems) if it
+		/// doesn't exist. Returns false if the file couldn't be created, or holds something else (such as a
+		/// set of another item size).
+		bool open(const std::string& path, const DiskHashSetOptions& options = DiskHashSetOptions())
+		{
+			close();
+			file_ = std::fopen(path.c_str(), "r+b");
+			bool created = file_ == nullptr;
+			if (created)
+				file_ = std::fopen(path.c_str(), "w+b");
+			if (file_ == nullptr)
+				return false;
+			failed_ = false;
+			frameCount_ = std::max<size_t>(options.cacheBytes / pageSize, 4);
+			frames_.reset(new Frame_[frameCount_]);
+			usedFrames_ = 0;
+
+			if (created) {
+				size_t perBucket = std::max<size_t>(itemsPerPage_ * 7 / 10, 1); // leaves room before buckets overflow
+				bucketCount_ = std::max<uint64_t>((options.expectedItems + perBucket - 1) / perBucket, 1);
+				pageCount_ = bucketCount_ + 1;
+				size_ = 0;
+				// writes the empty bucket pages in one sequential pass
+				std::vector<uint8_t> zeros(pageSize * 64, 0);
+				bool ok = writeHeader_();
+				for (uint64_t page = 1; ok && page < pageCount_; page += 64) {
+					size_t count = static_cast<size_t>(std::min<uint64_t>(64, pageCount_ - page));
+					ok = std::fwrite(zeros.data(), pageSize, count, file_) == count;
+				}
+				if (!ok || std::fflush(file_) != 0) {
+					closeFile_();
+					return false;
+				}
+			}
+			else if (!readHeader_()) {
+				closeFile_();
+				return false;
+			}
+
+			filter_.reset();
+			if (options.bloomBitsPerItem != 0) {
+				filter_ = std::make_unique<BloomFilter<ItemType, Hash>>(std::max<size_t>(options.expectedItems, static_cast<size_t>(size_)), options.bloomBitsPerItem);
+				for (uint64_t page = 1; page < pageCount_; ++page) {
+					const uint8_t* data = page_(page, false);
+					if (data == nullptr)
+						break;
+					for (uint32_t i = 0, count = header_(data).count; i < count; ++i)
+						filter_->add(item_(data, i));
+				}
+			}
+			return !failed_;
+		}
+
+		/// Writes the cached changes and closes the file.
+		void close()
+		{
+			if (file_ == nullptr)
+				return;
+			flush();
+			closeFile_();
+		}
+
+		bool isOpen() const { return file_ != nullptr; }
+
+		/// False once reading or writing the file has failed.
+		bool good() const { return file_ != nullptr && !failed_; }
+
+		/// Writes the changed pages (in file order) and the header. Returns false if that failed.
+		bool flush()
+		{
+			if (file_ == nullptr)
+				return false;
+			std::vector<Frame_*> dirty;
+			for (size_t i = 0; i < usedFrames_; ++i) {
+				if (frames_[i].dirty)
+					dirty.push_back(&frames_[i]);
+			}
+			std::sort(dirty.begin(), dirty.end(), [](const Frame_* a, const Frame_* b) { return a->page < b->page; });
+			for (Frame_* frame : dirty)
+				writeFrame_(*frame);
+			if (!writeHeader_() || std::fflush(file_) != 0)
+				failed_ = true;
+			return !failed_;
+		}
+
+		size_t size() const { return static_cast<size_t>(size_); }
+		bool empty() const { return size_ == 0; }
+
+		bool contains(const ItemType& item) const
+		{
+			if (file_ == nullptr || (filter_ && !filter_->mayContain(item)))
+				return false;
+			for (uint64_t page = bucketOf_(item); page != 0;) {
+				const uint8_t* data = page_(page, false);
+				if (data == nullptr)
+					return false;
+				if (slotOf_(data, item) != notFound_)
+					return true;
+				page = header_(data).overflow;
+			}
+			return false;
+		}
+
+		size_t count(const ItemType& item) const { return contains(item) ? 1 : 0; }
+
+		/// Adds the item, unless it is already in the set. Returns true if it was added.
+		bool insert(const ItemType& item)
+		{
+			if (file_ == nullptr)
+				return false;
+			bool mayContain = !filter_ || filter_->mayContain(item);
+			uint64_t page = bucketOf_(item);
+			uint64_t spacePage = 0;
+			while (true) {
+				const uint8_t* data = page_(page, false);
+				if (data == nullptr)
+					return false;
+				if (mayContain && slotOf_(data, item) != notFound_)
+					return false;
+				if (spacePage == 0 && header_(data).count < itemsPerPage_)
+					spacePage = page;
+				if (header_(data).overflow == 0)
+					break;
+				page = header_(data).overflow;
+			}
+			if (spacePage == 0) {
+				// chain a new overflow page to the last page of the bucket
+				spacePage = pageCount_++;
+				uint8_t* last = page_(page, true);
+				if (last == nullptr)
+					return false;
+				PageHeader_ header = header_(last);
+				header.overflow = spacePage;
+				std::memcpy(last, &header, sizeof(header));
+				if (page_(spacePage, true, true) == nullptr)
+					return false;
+			}
+			uint8_t* data = page_(spacePage, true);
+			if (data == nullptr)
+				return false;
+			PageHeader_ header = header_(data);
+			std::memcpy(data + sizeof(PageHeader_) + header.count * sizeof(ItemType), &item, sizeof(ItemType));
+			++header.count;
+			std::memcpy(data, &header, sizeof(header));
+			++size_;
+			if (filter_)
+				filter_->add(item);
+			return true;
+		}
+
+		/// Adds all the items, sorted by bucket first so the pages are visited once each, in file order.
+		/// Returns the number of items added.
+		template<typename ContainerType>
+		size_t insertAll(const ContainerType& items)
+		{
+			std::vector<std::pair<uint64_t, ItemType>> byBucket;
+			for (const auto& item : items)
+				byBucket.emplace_back(bucketOf_(item), item);
+			std::stable_sort(byBucket.begin(), byBucket.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+			size_t added = 0;
+			for (const auto& entry : byBucket)
+				added += insert(entry.second) ? 1 : 0;
+			return added;
+		}
+
+		/// Removes the item (if it is in the set). Returns true if it was removed.
+		bool erase(const ItemType& item)
+		{
+			if (file_ == nullptr || (filter_ && !filter_->mayContain(item)))
+				return false;
+			for (uint64_t page = bucketOf_(item); page != 0;) {
+				const uint8_t* found = page_(page, false);
+				if (found == nullptr)
+					return false;
+				size_t slot = slotOf_(found, item);
+				if (slot != notFound_) {
+					// the last item of the page takes the place of the removed one
+					uint8_t* data = page_(page, true);
+					PageHeader_ header = header_(data);
+					--header.count;
+					std::memmove(data + sizeof(PageHeader_) + slot * sizeof(ItemType), data + sizeof(PageHeader_) + header.count * sizeof(ItemType), sizeof(ItemType));
+					std::memcpy(data, &header, sizeof(header));
+					--size_;
+					return true;
+				}
+				page = header_(found).overflow;
+			}
+			return false;
+		}
+
+	private:
+		static constexpr char magic_[8] = { 'S', 'T', 'L', 'W', 'D', 'H', 'S', '1' };
+		static constexpr size_t notFound_ = ~size_t(0);
+
+		struct PageHeader_
+		{
+			uint32_t count;
+			uint32_t unused;
+			uint64_t overflow; // next page of the bucket, 0 if none
+		};
+
+		static constexpr size_t itemsPerPage_ = (pageSize - sizeof(PageHeader_)) / sizeof(ItemType);
+		static_assert(itemsPerPage_ >= 1, "DiskHashSet items must fit in a page");
+
+		struct FileHeader_
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t itemSize;
+			uint32_t pageSize;
+			uint32_t unused;
+			uint64_t bucketCount;
+			uint64_t pageCount;
+			uint64_t itemCount;
+		};
+
+		struct Frame_ : IntrusiveListHook<>
+		{
+			uint64_t page = 0;
+			bool dirty = false;
+			uint8_t data[pageSize];
+		};
+
+		static PageHeader_ header_(const uint8_t* data)
+		{
+			PageHeader_ header;
+			std::memcpy(&header, data, sizeof(header));
+			return header;
+		}
+
+		static ItemType item_(const uint8_t* data, size_t slot)
+		{
+			ItemType item;
+			std::memcpy(&item, data + sizeof(PageHeader_) + slot * sizeof(ItemType), sizeof(ItemType));
+			return item;
+		}
+
+		static size_t slotOf_(const uint8_t* data, const ItemType& item)
+		{
+			for (uint32_t i = 0, count = header_(data).count; i < count; ++i) {
+				if (item_(data, i) == item)
+					return i;
+			}
+			return notFound_;
+		}
+
+		uint64_t bucketOf_(const ItemType& item) const
+		{
+			return mixHash(static_cast<uint64_t>(Hash{}(item))) % bucketCount_ + 1;
+		}
+
+		// the cached contents of a page (read from the file if needed, or zeroed for a new page), or nullptr
+		// if the file couldn't be read; the pointer is valid until the next call
+		uint8_t* page_(uint64_t page, bool forWriting, bool isNew = false) const
+		{
+			auto cached = cache_.find(page);
+			Frame_* frame;
+			if (cached != cache_.end()) {
+				frame = cached->second;
+				lru_.erase(*frame);
+			}
+			else {
+				if (usedFrames_ < frameCount_) {
+					frame = &frames_[usedFrames_++];
+				}
+				else {
+					if (lru_.empty()) {
+						failed_ = true;
+						return nullptr;
+					}
+					frame = &lru_.front();
+					lru_.pop_front();
+					if (frame->dirty)
+						writeFrame_(*frame);
+					cache_.erase(frame->page);
+				}
+				frame->page = page;
+				frame->dirty = false;
+				if (isNew) {
+					std::memset(frame->data, 0, pageSize);
+				}
+				else if (!seekFile_(file_, page * pageSize) || std::fread(frame->data, pageSize, 1, file_) != 1) {
+					// the frame holds no page (page 0, the header, is never cached), and is the first to be reused
+					frame->page = 0;
+					lru_.push_front(*frame);
+					failed_ = true;
+					return nullptr;
+				}
+				cache_[page] = frame;
+			}
+			frame->dirty = frame->dirty || forWriting;
+			lru_.push_back(*frame);
+			return frame->data;
+		}
+
+		void writeFrame_(Frame_& frame) const
+		{
+			if (!seekFile_(file_, frame.page * pageSize) || std::fwrite(frame.data, pageSize, 1, file_) != 1)
+				failed_ = true;
+			frame.dirty = false;
+		}
+
+		bool writeHeader_()
+		{
+			FileHeader_ header{};
+			std::memcpy(header.magic, magic_, sizeof(magic_));
+			header.version = 1;
+			header.itemSize = sizeof(ItemType);
+			header.pageSize = pageSize;
+			header.bucketCount = bucketCount_;
+			header.pageCount = pageCount_;
+			header.itemCount = size_;
+			std::vector<uint8_t> page(pageSize, 0);
+			std::memcpy(page.data(), &header, sizeof(header));
+			return seekFile_(file_, 0) && std::fwrite(page.data(), pageSize, 1, file_) == 1;
+		}
+
+		bool readHeader_()
+		{
+			FileHeader_ header;
+			if (!seekFile_(file_, 0) || std::fread(&header, sizeof(header), 1, file_) != 1)
+				return false;
+			if (std::memcmp(header.magic, magic_, sizeof(magic_)) != 0 || header.version != 1 || header.itemSize != sizeof(ItemType) ||
+				header.pageSize != pageSize || header.bucketCount == 0 || header.pageCount <= header.bucketCount)
+				return false;
+			bucketCount_ = header.bucketCount;
+			pageCount_ = header.pageCount;
+			size_ = header.itemCount;
+			return true;
+		}
+
+		void closeFile_()
+		{
+			std::fclose(file_);
+			file_ = nullptr;
+			lru_.clear();
+			cache_.clear();
+			frames_.reset();
+			usedFrames_ = 0;
+			filter_.reset();
+		}
+
+		std::FILE* file_ = nullptr;
+		uint64_t bucketCount_ = 0;
+		uint64_t pageCount_ = 0; // including the header page
+		uint64_t size_ = 0;
+		std::unique_ptr<BloomFilter<ItemType, Hash>> filter_;
+		// the page cache (searching is const, but reads pages into it)
+		mutable std::unique_ptr<Frame_[]> frames_;
+		size_t frameCount_ = 0;
+		mutable size_t usedFrames_ = 0;
+		mutable std::unordered_map<uint64_t, Frame_*> cache_;
+		mutable IntrusiveList<Frame_> lru_; // least recently used first
+		mutable bool failed_ = false;
+	};
+
+	/// @name DiskHashSet overloads
+	/// Overloads of the wrapper functions for DiskHashSet.
+	/// contains() and count() read at most one page (none if the Bloom filter rules the item out).
+	///@{
+	///
+	/// contains() overload for disk hash set.
+	template<typename ItemType, typename Hash, typename KeyType>
+	bool contains(const DiskHashSet<ItemType, Hash>& container, const KeyType& item)
+	{
+		return container.contains(item);
+	}
+	///
+	/// count() overload for disk hash set.
+	template<typename ItemType, typename Hash, typename KeyType>
+	size_t count(const DiskHashSet<ItemType, Hash>& inContainer, const KeyType& item)
+	{
+		return inContainer.count(item);
+	}
+	///
+	/// add() overload for disk hash set.
+	template<typename ItemType, typename Hash, typename KeyType>
+	void add(DiskHashSet<ItemType, Hash>& inContainer, const KeyType& item)
+	{
+		inContainer.insert(item);
+	}
+	///
+	/// addAll() overload for disk hash set, adding the items in page order.
+	template<typename ItemType, typename Hash, typename ContainerOfItemsType>
+	void addAll(DiskHashSet<ItemType, Hash>& inContainer, const ContainerOfItemsType& items)
+	{
+		inContainer.insertAll(items);
+	}
+	///
+	/// remove() overload for disk hash set.
+	template<typename ItemType, typename Hash, typename KeyType>
+	void remove(DiskHashSet<ItemType, Hash>& fromContainer, const KeyType& item)
+	{
+		fromContainer.erase(item);
+	}
+	///@}
+
+	/// A single pass (input) range over the values a function generates, for passing generated items to
+	/// the functions that take a range (such as inFirstButNotInSecondStream()). The function returns a
+	/// std::optional, and the range ends at the first empty one. Create one with fromGenerator().
+	template<typename Function>
+	class GeneratorRange
+	{
+	public:
+		using value_type = typename std::decay_t<decltype(std::declval<Function&>()())>::value_type;
+
+		class iterator
+		{
+		public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = GeneratorRange::value_type;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const value_type*;
+			using reference = const value_type&;
+
+			iterator() = default;
+			explicit iterator(GeneratorRange* range) : range_(range) {}
+
+			reference operator*() const { return *range_->current_; }
+			pointer operator->() const { return &*range_->current_; }
+			iterator& operator++() { range_->current_ = range_->function_(); return *this; }
+			void operator++(int) { ++*this; }
+			bool operator==(const iterator& other) const { return atEnd_() == other.atEnd_(); }
+			bool operator!=(const iterator& other) const { return !(*this == other); }
+
+		private:
+			bool atEnd_() const { return range_ == nullptr || !range_->current_; }
+
+			GeneratorRange* range_ = nullptr;
+		};
+
+		explicit GeneratorRange(Function function) : function_(std::move(function)) {}
+
+		/// Generates the first value (so call it once).
+		iterator begin()
+		{
+			current_ = function_();
+			return iterator(this);
+		}
+
+		iterator end() { return iterator(); }
+
+	private:
+		Function function_;
+		std::optional<value_type> current_;
+	};
+
+	/// Returns a single pass range over the values the function generates, until it returns an empty std::optional.
+	template<typename Function>
+	GeneratorRange<Function> fromGenerator(Function function)
+	{
+		return GeneratorRange<Function>(std::move(function));
+	}
+
+	/// A single pass view of the items of a range that are not in a set, returned by inFirstButNotInSecondStream().
+	/// Items are read from the range only as the view is iterated.
+	template<typename RangeType, typename ItemType>
+	class DifferenceView
+	{
+		using RangeIterator_ = decltype(std::begin(std::declval<RangeType&>()));
+		using RangeEnd_ = decltype(std::end(std::declval<RangeType&>()));
+
+	public:
+		using value_type = std::decay_t<decltype(*std::declval<RangeIterator_&>())>;
+
+		class iterator
+		{
+		public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = DifferenceView::value_type;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const value_type*;
+			using reference = decltype(*std::declval<RangeIterator_&>());
+
+			iterator() = default;
+			explicit iterator(DifferenceView* view) : view_(view) {}
+
+			reference operator*() const { return **view_->position_; }
+			iterator& operator++()
+			{
+				++*view_->position_;
+				view_->skip_();
+				return *this;
+			}
+			void operator++(int) { ++*this; }
+			bool operator==(const iterator& other) const { return atEnd_() == other.atEnd_(); }
+			bool operator!=(const iterator& other) const { return !(*this == other); }
+
+		private:
+			bool atEnd_() const { return view_ == nullptr || view_->position_ == view_->end_; }
+
+			DifferenceView* view_ = nullptr;
+		};
+
+		template<typename SecondContainerType>
+		DifferenceView(RangeType&& range, const SecondContainerType& second)
+			: range_(std::forward<RangeType>(range)), index_(std::begin(second), std::end(second))
+		{
+		}
+
+		DifferenceView(const DifferenceView&) = delete;
+		DifferenceView& operator=(const DifferenceView&) = delete;
+
+		/// Starts reading the range (so call it once).
+		iterator begin()
+		{
+			position_.emplace(std::begin(range_));
+			end_.emplace(std::end(range_));
+			skip_();
+			return iterator(this);
+		}
+
+		iterator end() { return iterator(); }
+
+	private:
+		// moves to the next item of the range that isn't in the index
+		void skip_()
+		{
+			while (*position_ != *end_ && index_.count(**position_) != 0)
+				++*position_;
+		}
+
+		RangeType range_; // a reference for lvalue ranges, a copy for temporaries
+		std::unordered_set<ItemType, FastHash<ItemType>> index_;
+		std::optional<RangeIterator_> position_;
+		std::optional<RangeEnd_> end_;
+	};
+
+	/// @name Streaming inFirstButNotInSecond(firstRange, secondContainer)
+	/// Versions of inFirstButNotInSecond() for a first range that is read once, item by item (an input
+	/// range such as std::istream_iterator pairs, or fromGenerator()). Only the second container is indexed
+	/// (in a hash set), so memory use is bounded by the second container however long the first range is.
+	/// Items are produced as soon as they are read, in the order of the first range; an item that appears
+	/// more than once in the first range is produced each time.
+	///@{
+	///
+	/// Returns a single pass view of the items of the first range that are not in the second container.
+	/// The view holds a temporary first range (a container of the caller is referred to, and must outlive the view).
+	template<typename FirstRangeType, typename SecondContainerType>
+	auto inFirstButNotInSecondStream(FirstRangeType&& firstRange, const SecondContainerType& secondContainer)
+	{
+		using ItemType = typename Owned_<std::decay_t<decltype(*std::begin(secondContainer))>>::Type;
+		return DifferenceView<FirstRangeType, ItemType>(std::forward<FirstRangeType>(firstRange), secondContainer);
+	}
+	///
+	/// Calls the function with each item of the first range that is not in the second container, as it is read.
+	template<typename FirstRangeType, typename SecondContainerType, typename Function>
+	void forEachInFirstButNotInSecond(FirstRangeType&& firstRange, const SecondContainerType& secondContainer, Function function)
+	{
+		using ItemType = typename Owned_<std::decay_t<decltype(*std::begin(secondContainer))>>::Type;
+		std::unordered_set<ItemType, FastHash<ItemType>> index(std::begin(secondContainer), std::end(secondContainer));
+		for (auto&& item : firstRange) {
+			if (index.count(item) == 0)
+				function(item);
+		}
+	}
+	///@}
+
+#if defined(STLWRAPPERS_COROUTINES_)
+	/// Where the async bulk operations (addAllAsync(), ...) do their work.
+	struct AsyncOptions
+	{
+		/// Items processed per slice; between slices the operation yields to the scheduler.
+		size_t sliceSize = 4096;
+		/// Called with the suspended operation between slices (and, after offloading, when done), to resume it
+		/// later, e.g. by posting it to the caller's event loop. Without a scheduler, slices run back to back.
+		std::function<void(std::coroutine_handle<>)> scheduler;
+		/// If set, the whole operation runs on a worker of this pool, then the worker hands it to the scheduler
+		/// (so the scheduler must accept calls from other threads), which resumes it on the caller's thread.
+		/// A pool needs a scheduler: without one the operation would complete on the worker, racing with the
+		/// caller's done() and result(), so the pool is ignored. The containers must not be used by anything
+		/// else until the operation completes.
+		ThreadPool* pool = nullptr;
+	};
+
+	/// The result of the async bulk operations, a lazily started C++20 coroutine: co_await it to run the
+	/// operation and get its result. Outside a coroutine, start() runs it (until it first yields) and
+	/// done()/result() report the outcome.
+	template<typename ResultType>
+	class AsyncTask
+	{
+	public:
+		struct promise_type
+		{
+			std::optional<ResultType> result;
+			std::exception_ptr exception;
+			std::coroutine_handle<> continuation;
+
+			AsyncTask get_return_object() { return AsyncTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+			std::suspend_always initial_suspend() noexcept { return {}; }
+
+			struct FinalAwaiter
+			{
+				bool await_ready() noexcept { return false; }
+				// resumes whatever awaited the task (symmetric transfer, so no stack grows)
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+				{
+					auto continuation = handle.promise().continuation;
+					return continuation ? continuation : std::noop_coroutine();
+				}
+				void await_resume() noexcept {}
+			};
+			FinalAwaiter final_suspend() noexcept { return {}; }
+
+			void return_value(ResultType value) { result = std::move(value); }
+			void unhandled_exception() { exception = std::current_exception(); }
+		};
+
+		AsyncTask(AsyncTask&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+		AsyncTask& operator=(AsyncTask&& other) noexcept
+		{
+			if (handle_)
+				handle_.destroy();
+			handle_ = std::exchange(other.handle_, nullptr);
+			return *this;
+		}
+		AsyncTask(const AsyncTask&) = delete;
+		AsyncTask& operator=(const AsyncTask&) = delete;
+
+		~AsyncTask()
+		{
+			if (handle_)
+				handle_.destroy();
+		}
+
+		bool await_ready() const noexcept { return false; }
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept
+		{
+			handle_.promise().continuation = awaiter;
+			return handle_;
+		}
+		ResultType await_resume() { return result(); }
+
+		/// Starts the operation from outside a coroutine; it runs until it first yields (or completes).
+		void start() { handle_.resume(); }
+
+		bool done() const { return handle_.done(); }
+
+		/// The result of a completed operation (rethrows what it threw, such as std::bad_alloc).
+		ResultType result()
+		{
+			if (handle_.promise().exception)
+				std::rethrow_exception(handle_.promise().exception);
+			return std::move(*handle_.promise().result);
+		}
+
+	private:
+		explicit AsyncTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+		std::coroutine_handle<promise_type> handle_;
+	};
+
+	// internal, suspends an async operation and hands it to the scheduler (does nothing without one)
+	struct YieldToScheduler_
+	{
+		const std::function<void(std::coroutine_handle<>)>& scheduler;
+
+		bool await_ready() const noexcept { return !scheduler; }
+		void await_suspend(std::coroutine_handle<> handle) const { scheduler(handle); }
+		void await_resume() const noexcept {}
+	};
+
+	// internal, moves an async operation to a worker of the pool (does nothing without a pool)
+	struct ResumeOnPool_
+	{
+		ThreadPool* pool;
+
+		bool await_ready() const noexcept { return pool == nullptr; }
+		void await_suspend(std::coroutine_handle<> handle) const { pool->post([handle]() { handle.resume(); }); }
+		void await_resume() const noexcept {}
+	};
+
+	// internal, calls function(item) for each item, in slices separated by yields to the scheduler
+	// (or all of them on the pool); returns the number of items
+	template<typename ContainerType, typename Function>
+	AsyncTask<size_t> forEachAsync_(const ContainerType& items, Function function, AsyncOptions options)
+	{
+		size_t count = 0;
+		assert((options.pool == nullptr || options.scheduler) && "a pool needs a scheduler to get back to the caller's thread");
+		if (options.pool != nullptr && options.scheduler) {
+			co_await ResumeOnPool_{ options.pool };
+			for (const auto& item : items) {
+				function(item);
+				++count;
+			}
+			co_await YieldToScheduler_{ options.scheduler }; // the scheduler resumes it on the caller's thread
+		}
+		else {
+			size_t sliceSize = std::max<size_t>(options.sliceSize, 1);
+			for (const auto& item : items) {
+				function(item);
+				if (++count % sliceSize == 0)
+					co_await YieldToScheduler_{ options.scheduler };
+			}
+		}
+		co_return count;
+	}
+
+	/// @name Async bulk operations
+	/// C++20 coroutine versions of the bulk operations, for event loop threads that can't block on large
+	/// containers. `co_await addAllAsync(container, items, options)` processes options.sliceSize items at a
+	/// time, handing the operation to options.scheduler between slices, or runs it on options.pool (see
+	/// AsyncOptions). The containers must outlive the operation and not be changed by anything else meanwhile.
+	/// Only available when compiling as C++20 (or later) with coroutine support.
+	///@{
+	///
+	/// Adds all the items to the container (like addAll()). Returns the number of items.
+	template<typename ToContainerType, typename FromContainerType>
+	AsyncTask<size_t> addAllAsync(ToContainerType& inContainer, const FromContainerType& items, AsyncOptions options = AsyncOptions())
+	{
+		return forEachAsync_(items, [&inContainer](const auto& item) { add(inContainer, item); }, std::move(options));
+	}
+	///
+	/// Removes all the items from the container (like remove() for each). Returns the number of items.
+	template<typename FromContainerType, typename ContainerOfItemsType>
+	AsyncTask<size_t> removeAllAsync(FromContainerType& fromContainer, const ContainerOfItemsType& items, AsyncOptions options = AsyncOptions())
+	{
+		return forEachAsync_(items, [&fromContainer](const auto& item) { remove(fromContainer, item); }, std::move(options));
+	}
+	///
+	/// Returns the items in the first container but not in the second (like inFirstButNotInSecond()).
+	template<typename FirstContainerType, typename SecondContainerType>
+	auto inFirstButNotInSecondAsync(const FirstContainerType& firstContainer, const SecondContainerType& secondContainer, AsyncOptions options = AsyncOptions())
+		-> AsyncTask<decltype(inFirstButNotInSecond_(firstContainer, secondContainer))>
+	{
+		using ResultType = decltype(inFirstButNotInSecond_(firstContainer, secondContainer));
+		ResultType result;
+		co_await forEachAsync_(firstContainer, [&](const auto& item) {
+			if (!contains(secondContainer, item))
+				result.insert(item);
+		}, std::move(options));
+		co_return result;
+	}
+	///@}
+#endif
+
+	// internal, true for containers with a mapped_type (maps)
+	template<typename ContainerType, typename = void>
+	struct IsMap_ : std::false_type {};
+	template<typename ContainerType>
+	struct IsMap_<ContainerType, std::void_t<typename ContainerType::mapped_type>> : std::true_type {};
+
+	// internal, the key type of a set or map
+	template<typename ContainerType, typename = void>
+	struct KeyOf_ { using Type = typename ContainerType::value_type; };
+	template<typename ContainerType>
+	struct KeyOf_<ContainerType, std::void_t<typename ContainerType::key_type>> { using Type = typename ContainerType::key_type; };
+
+	/// A wrapper around a set or map that records the changes made through it (add(), remove(), addAll())
+	/// in a change log, so the difference between the current contents and an earlier version can be
+	/// computed from the changes alone instead of comparing whole containers.
+	/// version() numbers the changes; delta(since) returns the keys added, removed (and, for maps, whose
+	/// value was replaced) since a version in O(changes since then). Changes that cancel out (a key added and
+	/// then removed again) don't appear. Only changes that take effect are recorded.
+	/// The log is compacted by compact(version) (dropping what no reader needs any more), and automatically
+	/// when it grows beyond maxLogSize() (dropping its oldest half); delta() can't go back further than the
+	/// compacted part.
+	template<typename ContainerType>
+	class Tracked
+	{
+	public:
+		using value_type = typename ContainerType::value_type;
+		using key_type = typename KeyOf_<ContainerType>::Type;
+		using const_iterator = typename ContainerType::const_iterator;
+		using iterator = const_iterator;
+		using Version = uint64_t;
+
+		/// The changes between two versions.
+		struct Delta
+		{
+			std::vector<key_type> added; ///< keys that weren't there and are now
+			std::vector<key_type> removed; ///< keys that were there and aren't now
+			std::vector<key_type> updated; ///< (maps) keys that are still there but whose value was replaced
+		};
+
+		Tracked() = default;
+		Tracked(ContainerType container) : container_(std::move(container)) {}
+		Tracked(std::initializer_list<value_type> items) : container_(items) {}
+
+		/// Returns the container, for reading (changes must go through the Tracked to be recorded).
+		const ContainerType& get() const { return container_; }
+		const ContainerType& operator*() const { return container_; }
+		const ContainerType* operator->() const { return &container_; }
+
+		const_iterator begin() const { return std::cbegin(container_); }
+		const_iterator end() const { return std::cend(container_); }
+		size_t size() const { return std::size(container_); }
+		bool empty() const { return std::size(container_) == 0; }
+
+		/// The current version (the number of changes made so far).
+		Version version() const { return firstVersion_ + log_.size(); }
+
+		/// The oldest version delta() can still start from.
+		Version oldestVersion() const { return firstVersion_; }
+
+		/// Adds an item (a key-value pair for a map, which is left as it is if the key is already there).
+		void add(const value_type& item)
+		{
+			if constexpr (IsMap_<ContainerType>::value) {
+				if (count(container_, item.first) == 0) {
+					STLWrappers::add(container_, item);
+					record_(item.first, Change_::added);
+				}
+			}
+			else if (count(container_, item) == 0) {
+				STLWrappers::add(container_, item);
+				record_(item, Change_::added);
+			}
+		}
+
+		/// Sets the value of a key of a map (adding the key if needed).
+		template<typename ValueType>
+		void add(const key_type& key, const ValueType& value)
+		{
+			bool existed = count(container_, key) != 0;
+			STLWrappers::add(container_, key, value);
+			record_(key, existed ? Change_::updated : Change_::added);
+		}
+
+		/// Removes a key (if it is there).
+		void remove(const key_type& key)
+		{
+			if (count(container_, key) != 0) {
+				STLWrappers::remove(container_, key);
+				record_(key, Change_::removed);
+			}
+		}
+
+		/// Returns the changes since a version, or nothing if the version is older than oldestVersion()
+		/// (or newer than version()), in which case the caller has to compare whole containers instead.
+		/// Keys are listed in the order they were first changed.
+		std::optional<Delta> delta(Version since) const
+		{
+			if (since < firstVersion_ || since > version())
+				return std::nullopt;
+			// the first change of a key tells whether it was there at 'since', the last whether it is there now
+			struct History
+			{
+				key_type key;
+				Change_ first;
+				Change_ last;
+				bool replaced;
+			};
+			std::vector<History> histories;
+			std::unordered_map<key_type, size_t, FastHash<key_type>> indexes;
+			for (size_t i = static_cast<size_t>(since - firstVersion_); i < log_.size(); ++i) {
+				const Entry_& entry = log_[i];
+				auto found = indexes.find(entry.key);
+				if (found == indexes.end()) {
+					indexes.emplace(entry.key, histories.size());
+					histories.push_back(History{ entry.key, entry.change, entry.change, entry.change == Change_::updated });
+				}
+				else {
+					History& history = histories[found->second];
+					history.last = entry.change;
+					history.replaced = true;
+				}
+			}
+			Delta result;
+			for (auto& history : histories) {
+				bool wasThere = history.first != Change_::added;
+				bool isThere = history.last != Change_::removed;
+				if (!wasThere && isThere)
+					result.added.push_back(std::move(history.key));
+				else if (wasThere && !isThere)
+					result.removed.push_back(std::move(history.key));
+				else if (wasThere && isThere && history.replaced && IsMap_<ContainerType>::value)
+					result.updated.push_back(std::move(history.key));
+			}
+			return result;
+		}
+
+		/// Drops the changes before a version (once no reader will ask for a delta from an older version).
+		void compact(Version upTo)
+		{
+			upTo = std::min(upTo, version());
+			if (upTo <= firstVersion_)
+				return;
+			log_.erase(log_.begin(), log_.begin() + static_cast<std::ptrdiff_t>(upTo - firstVersion_));
+			firstVersion_ = upTo;
+		}
+
+		/// The number of changes kept before the oldest half is dropped (a million by default).
+		size_t maxLogSize() const { return maxLogSize_; }
+		void setMaxLogSize(size_t size) { maxLogSize_ = std::max<size_t>(size, 2); }
+
+	private:
+		enum class Change_ : uint8_t { added, removed, updated };
+
+		struct Entry_
+		{
+			key_type key;
+			Change_ change;
+		};
+
+		void record_(const key_type& key, Change_ change)
+		{
+			log_.push_back(Entry_{ key, change });
+			if (log_.size() > maxLogSize_)
+				compact(firstVersion_ + log_.size() / 2);
+		}
+
+		ContainerType container_;
+		std::deque<Entry_> log_;
+		Version firstVersion_ = 0; // version of the first change in the log
+		size_t maxLogSize_ = size_t(1) << 20;
+	};
+
+	/// @name Tracked overloads
+	/// Overloads of the wrapper functions for Tracked. Searching goes to the wrapped container; add(),
+	/// remove() and addAll() go through the Tracked, so the changes are recorded.
+	///@{
+	///
+	/// find() overload for tracked, returns what find() returns for the wrapped container.
+	template<typename ContainerType, typename ItemType>
+	auto find(const Tracked<ContainerType>& inContainer, const ItemType& item)
+	{
+		return find(inContainer.get(), item);
+	}
+	///
+	/// contains() overload for tracked.
+	template<typename ContainerType, typename ItemType>
+	bool contains(const Tracked<ContainerType>& container, const ItemType& item)
+	{
+		return contains(container.get(), item);
+	}
+	///
+	/// count() overload for tracked.
+	template<typename ContainerType, typename ItemType>
+	size_t count(const Tracked<ContainerType>& inContainer, const ItemType& item)
+	{
+		return count(inContainer.get(), item);
+	}
+	///
+	/// add() overload for tracked.
+	template<typename ContainerType, typename ItemType>
+	void add(Tracked<ContainerType>& inContainer, const ItemType& item)
+	{
+		inContainer.add(item);
+	}
+	///
+	/// add() overload for a tracked map.
+	template<typename ContainerType, typename KeyType, typename ValueType>
+	void add(Tracked<ContainerType>& inMap, const KeyType& key, const ValueType& value)
+	{
+		inMap.add(key, value);
+	}
+	///
+	/// remove() overload for tracked.
+	template<typename ContainerType, typename ItemType>
+	void remove(Tracked<ContainerType>& fromContainer, const ItemType& item)
+	{
+		fromContainer.remove(item);
+	}
+	///@}
+
+	// internal, true for ordered containers that take insertion hints (std::set, std::map)
+	template<typename ContainerType, typename = void>
+	struct IsHintable_ : std::false_type {};
+	template<typename ContainerType>
+	struct IsHintable_<ContainerType, std::void_t<decltype(std::declval<ContainerType&>().key_comp()),
+		decltype(std::declval<ContainerType&>().lower_bound(std::declval<const typename ContainerType::key_type&>())),
+		decltype(std::declval<ContainerType&>().emplace_hint(std::declval<ContainerType&>().end(), std::declval<typename ContainerType::value_type>()))>>
+		: std::true_type {};
+
+	// internal, true for hashed containers with buckets (std::unordered_set, std::unordered_map)
+	template<typename ContainerType, typename = void>
+	struct IsBucketed_ : std::false_type {};
+	template<typename ContainerType>
+	struct IsBucketed_<ContainerType, std::void_t<decltype(std::declval<const ContainerType&>().bucket(std::declval<const typename ContainerType::key_type&>())),
+		decltype(std::declval<ContainerType&>().reserve(size_t()))>>
+		: std::true_type {};
+
+	// internal, the mapped type of a map (an empty placeholder for sets)
+	template<typename ContainerType, typename = void>
+	struct MappedOf_ { struct Type {}; };
+	template<typename ContainerType>
+	struct MappedOf_<ContainerType, std::void_t<typename ContainerType::mapped_type>> { using Type = typename ContainerType::mapped_type; };
+
+	/// A write-combining buffer in front of a set or map (with unique keys): add() and remove() calls are
+	/// buffered, and flush() applies them together. Operations on the same key are combined first (the
+	/// last one wins, so a key added and removed again costs a single removal, which is still needed in case
+	/// the key was there before). Then, for std::map and std::set,
+	/// the operations are sorted by key and applied in one ordered pass: each search starts from where the
+	/// previous one ended when the keys are close, the others walk mostly cached tree paths, and inserts
+	/// and erases use the found position. For std::unordered_map and std::unordered_set, the table is
+	/// grown once and the operations are applied in bucket order. Other containers get the operations one by
+	/// one, in the order they were made.
+	/// The buffer is flushed when it reaches maxPending operations and when the BatchWriter is destroyed;
+	/// the container doesn't see buffered operations, so flush() before reading it.
+	/// @note Applying the operations can throw (such as std::bad_alloc). The destructor can't report that,
+	/// so call flush() before the BatchWriter is destroyed: a flush that throws in the destructor drops the
+	/// operations that weren't applied yet.
+	template<typename ContainerType>
+	class BatchWriter
+	{
+	public:
+		using value_type = typename ContainerType::value_type;
+		using key_type = typename KeyOf_<ContainerType>::Type;
+
+		explicit BatchWriter(ContainerType& container, size_t maxPending = size_t(1) << 16)
+			: container_(container), maxPending_(std::max<size_t>(maxPending, 1))
+		{
+		}
+
+		BatchWriter(const BatchWriter&) = delete;
+		BatchWriter& operator=(const BatchWriter&) = delete;
+
+		~BatchWriter()
+		{
+			try {
+				flush();
+			}
+			catch (...) {
+				// a destructor must not throw; see the note above
+			}
+		}
+
+		/// The container the operations are applied to.
+		ContainerType& get() const { return container_; }
+
+		/// The number of buffered operations.
+		size_t pending() const { return operations_.size(); }
+
+		/// Adds an item (a key-value pair for a map, which is left as it is if the key is already there).
+		void add(const value_type& item)
+		{
+			if constexpr (IsMap_<ContainerType>::value)
+				push_(Operation_{ item.first, Kind_::insert, item.second, 0 });
+			else
+				push_(Operation_{ item, Kind_::insert, std::nullopt, 0 });
+		}
+
+		/// Sets the value of a key of a map (adding the key if needed).
+		template<typename ValueType>
+		void add(const key_type& key, const ValueType& value)
+		{
+			push_(Operation_{ key, Kind_::assign, value, 0 });
+		}
+
+		/// Removes a key (if it is there).
+		void remove(const key_type& key)
+		{
+			push_(Operation_{ key, Kind_::remove, std::nullopt, 0 });
+		}
+
+		/// Applies the buffered operations to the container.
+		void flush()
+		{
+			if (operations_.empty())
+				return;
+			if constexpr (IsHintable_<ContainerType>::value)
+				flushOrdered_();
+			else if constexpr (IsBucketed_<ContainerType>::value)
+				flushBucketed_();
+			else
+				flushInOrder_();
+			operations_.clear();
+		}
+
+		/// Drops the buffered operations without applying them.
+		void discard() { operations_.clear(); }
+
+	private:
+		enum class Kind_ : uint8_t { insert, assign, remove };
+
+		using Mapped_ = typename MappedOf_<ContainerType>::Type;
+
+		struct Operation_
+		{
+			key_type key;
+			Kind_ kind;
+			std::optional<Mapped_> value;
+			size_t bucket;
+		};
+
+		void push_(Operation_ operation)
+		{
+			operations_.push_back(std::move(operation));
+			if (operations_.size() >= maxPending_)
+				flush();
+		}
+
+		// combines a later operation on a key into an earlier one, so applying the result has the effect of both
+		static void combine_(Operation_& earlier, Operation_& later)
+		{
+			if (later.kind != Kind_::insert)
+				earlier = std::move(later);
+			else if (earlier.kind == Kind_::remove) {
+				// the key is gone after the removal, so the insert always takes effect
+				earlier = std::move(later);
+				earlier.kind = Kind_::assign;
+			}
+			// (an insert after an insert or assign does nothing)
+		}
+
+		// sorts the operations by key (keeping their order per key) and combines those on the same key
+		template<typename Less>
+		void sortAndCombine_(Less less)
+		{
+			std::stable_sort(operations_.begin(), operations_.end(), [&less](const Operation_& a, const Operation_& b) { return less(a.key, b.key); });
+			size_t last = 0;
+			for (size_t i = 1; i < operations_.size(); ++i) {
+				if (!less(operations_[last].key, operations_[i].key))
+					combine_(operations_[last], operations_[i]);
+				else if (++last != i)
+					operations_[last] = std::move(operations_[i]);
+			}
+			operations_.resize(last + 1);
+		}
+
+		void flushOrdered_()
+		{
+			auto comp = container_.key_comp();
+			auto keyOf = [](const value_type& item) -> const key_type& {
+				if constexpr (IsMap_<ContainerType>::value)
+					return item.first;
+				else
+					return item;
+			};
+			sortAndCombine_(comp);
+
+			// position is the first item not less than the key of the next operation, found from the
+			// previous position when it is a few items away and from the root otherwise
+			auto position = container_.begin();
+			for (auto& operation : operations_) {
+				int steps = 0;
+				while (position != container_.end() && comp(keyOf(*position), operation.key)) {
+					if (++steps > 4) {
+						position = container_.lower_bound(operation.key);
+						break;
+					}
+					++position;
+				}
+				bool found = position != container_.end() && !comp(operation.key, keyOf(*position));
+				if (operation.kind == Kind_::remove) {
+					if (found)
+						position = container_.erase(position);
+				}
+				else if (found) {
+					if constexpr (IsMap_<ContainerType>::value) {
+						if (operation.kind == Kind_::assign)
+							position->second = std::move(*operation.value);
+					}
+					++position;
+				}
+				else {
+					if constexpr (IsMap_<ContainerType>::value)
+						position = container_.emplace_hint(position, std::move(operation.key), std::move(*operation.value));
+					else
+						position = container_.emplace_hint(position, std::move(operation.key));
+					++position;
+				}
+			}
+		}
+
+		void flushBucketed_()
+		{
+			// grow the table first, so the buckets don't change while the operations are applied
+			size_t inserts = 0;
+			for (const auto& operation : operations_)
+				inserts += operation.kind != Kind_::remove;
+			container_.reserve(container_.size() + inserts);
+			for (auto& operation : operations_)
+				operation.bucket = container_.bucket(operation.key);
+			std::stable_sort(operations_.begin(), operations_.end(), [](const Operation_& a, const Operation_& b) { return a.bucket < b.bucket; });
+
+			// combine the operations on the same key (which are in the same bucket, so only buckets are searched)
+			auto equal = container_.key_eq();
+			size_t bucketStart = 0;
+			size_t last = 0;
+			for (size_t i = 0; i < operations_.size(); ++i) {
+				if (i == 0 || operations_[i].bucket != operations_[last].bucket) {
+					bucketStart = i == 0 ? 0 : last + 1;
+					if (bucketStart != i)
+						operations_[bucketStart] = std::move(operations_[i]);
+					last = bucketStart;
+					continue;
+				}
+				size_t same = bucketStart;
+				while (same <= last && !equal(operations_[same].key, operations_[i].key))
+					++same;
+				if (same <= last)
+					combine_(operations_[same], operations_[i]);
+				else if (++last != i)
+					operations_[last] = std::move(operations_[i]);
+			}
+			operations_.resize(last + 1);
+
+			for (auto& operation : operations_) {
+				if (operation.kind == Kind_::remove) {
+					container_.erase(operation.key);
+					continue;
+				}
+				auto position = container_.find(operation.key);
+				if (position != container_.end()) {
+					if constexpr (IsMap_<ContainerType>::value) {
+						if (operation.kind == Kind_::assign)
+							position->second = std::move(*operation.value);
+					}
+				}
+				else if constexpr (IsMap_<ContainerType>::value)
+					container_.emplace(std::move(operation.key), std::move(*operation.value));
+				else
+					container_.emplace(std::move(operation.key));
+			}
+		}
+
+		void flushInOrder_()
+		{
+			for (auto& operation : operations_) {
+				if (operation.kind == Kind_::remove)
+					STLWrappers::remove(container_, operation.key);
+				else if constexpr (IsMap_<ContainerType>::value) {
+					if (operation.kind == Kind_::assign)
+						STLWrappers::add(container_, operation.key, *operation.value);
+					else
+						STLWrappers::add(container_, value_type(operation.key, *operation.value));
+				}
+				else
+					STLWrappers::add(container_, operation.key);
+			}
+		}
+
+		ContainerType& container_;
+		size_t maxPending_;
+		std::vector<Operation_> operations_;
+	};
+
+	/// @name BatchWriter overloads
+	/// add(), remove() and addAll() on a BatchWriter buffer the operations for its container.
+	///@{
+	///
+	/// add() overload for BatchWriter.
+	template<typename ContainerType, typename ItemType>
+	void add(BatchWriter<ContainerType>& inContainer, const ItemType& item)
+	{
+		inContainer.add(item);
+	}
+	///
+	/// add() overload for a BatchWriter of a map.
+	template<typename ContainerType, typename KeyType, typename ValueType>
+	void add(BatchWriter<ContainerType>& inMap, const KeyType& key, const ValueType& value)
+	{
+		inMap.add(key, value);
+	}
+	///
+	/// remove() overload for BatchWriter.
+	template<typename ContainerType, typename ItemType>
+	void remove(BatchWriter<ContainerType>& fromContainer, const ItemType& item)
+	{
+		fromContainer.remove(item);
 	}
 	///@}
 }
\ No newline at end of file
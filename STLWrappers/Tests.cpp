@@ -3,6 +3,10 @@
 
 #include "STLWrappers.h"
 
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
 TEST_CASE("operations work on containers")
 {
 	// set up containers
@@ -276,4 +280,1343 @@ TEST_CASE("inFirstButNotSecond()") {
 
 		STLWrappers::inFirstButNotInSecond(std::vector<int>{1, 2, 3}, std::vector<int>{3});
 	}
-}
\ No newline at end of file
+
+	SECTION("the result is a std::unordered_set") {
+		std::unordered_set<int> results = STLWrappers::inFirstButNotInSecond(std::vector<int>{ 1, 2, 3 }, std::set<int>{ 2 });
+		REQUIRE(results == std::unordered_set<int>{ 1, 3 });
+	}
+}
+
+TEST_CASE("PackedMemoryArray") {
+	STLWrappers::PackedMemoryArray<int> pma{ 3,1,2 };
+
+	SECTION("search works") {
+		REQUIRE(STLWrappers::find(pma, 3) != std::end(pma));
+		REQUIRE(STLWrappers::find(pma, 0) == std::end(pma));
+		REQUIRE(STLWrappers::contains(pma, 1));
+		REQUIRE(!STLWrappers::contains(pma, 0));
+		REQUIRE(STLWrappers::count(pma, 2) == 1);
+		REQUIRE(STLWrappers::count(pma, 0) == 0);
+		REQUIRE(STLWrappers::containsAll(pma, { 1,2,3 }));
+		REQUIRE(STLWrappers::containsAny(pma, { 0,3 }));
+	}
+
+	SECTION("add and remove work") {
+		STLWrappers::add(pma, 4);
+		STLWrappers::add(pma, 4);
+		REQUIRE(std::size(pma) == 4);
+		STLWrappers::remove(pma, 1);
+		REQUIRE(std::size(pma) == 3);
+		REQUIRE(!STLWrappers::contains(pma, 1));
+		std::vector<int> compare{ 2,3,4 };
+		REQUIRE(std::equal(std::begin(pma), std::end(pma), std::begin(compare), std::end(compare)));
+	}
+
+	SECTION("stays sorted through many adds and removes") {
+		std::set<int> expected{ 1,2,3 };
+		for (int i = 0; i < 5000; ++i) {
+			int item = (i * 7919) % 3001;
+			if (i % 3 == 2) {
+				STLWrappers::remove(pma, item);
+				STLWrappers::remove(expected, item);
+			}
+			else {
+				STLWrappers::add(pma, item);
+				STLWrappers::add(expected, item);
+			}
+		}
+		REQUIRE(std::size(pma) == std::size(expected));
+		REQUIRE(std::equal(std::begin(pma), std::end(pma), std::begin(expected), std::end(expected)));
+
+		for (int item : std::vector<int>(std::begin(expected), std::end(expected)))
+			STLWrappers::remove(pma, item);
+		REQUIRE(std::size(pma) == 0);
+		REQUIRE(std::begin(pma) == std::end(pma));
+	}
+}
+
+TEST_CASE("LsmSet") {
+	STLWrappers::LsmSet<int> lsm(4);
+	STLWrappers::addAll(lsm, { 5,1,4,2,3 });
+
+	SECTION("search works across the buffer and the runs") {
+		REQUIRE(lsm.runCount() >= 1);
+		REQUIRE(STLWrappers::find(lsm, 5) != nullptr);
+		REQUIRE(*STLWrappers::find(lsm, 5) == 5);
+		REQUIRE(STLWrappers::find(lsm, 0) == nullptr);
+		REQUIRE(STLWrappers::contains(lsm, 1));
+		REQUIRE(!STLWrappers::contains(lsm, 6));
+		REQUIRE(STLWrappers::count(lsm, 4) == 1);
+		REQUIRE(STLWrappers::containsAll(lsm, { 1,2,3,4,5 }));
+		REQUIRE(!STLWrappers::containsAny(lsm, { 0,6 }));
+	}
+
+	SECTION("remove hides older adds") {
+		STLWrappers::remove(lsm, 2);
+		REQUIRE(!STLWrappers::contains(lsm, 2));
+		STLWrappers::add(lsm, 2);
+		REQUIRE(STLWrappers::contains(lsm, 2));
+		STLWrappers::remove(lsm, 1);
+		STLWrappers::add(lsm, 1);
+		STLWrappers::add(lsm, 1);
+		REQUIRE(std::size(lsm) == 5);
+	}
+
+	SECTION("iterates in order after many writes") {
+		std::set<int> expected{ 1,2,3,4,5 };
+		for (int i = 0; i < 2000; ++i) {
+			int item = (i * 31) % 257;
+			if (i % 4 == 3) {
+				STLWrappers::remove(lsm, item);
+				STLWrappers::remove(expected, item);
+			}
+			else {
+				STLWrappers::add(lsm, item);
+				STLWrappers::add(expected, item);
+			}
+		}
+		for (int item = 0; item < 300; ++item)
+			REQUIRE(STLWrappers::contains(lsm, item) == STLWrappers::contains(expected, item));
+		REQUIRE(std::equal(std::begin(lsm), std::end(lsm), std::begin(expected), std::end(expected)));
+		REQUIRE(lsm.runCount() == 1);
+	}
+
+	SECTION("lookups in a large buffer see the newest write") {
+		STLWrappers::LsmSet<int> buffered;
+		for (int i = 0; i < 800; ++i) {
+			STLWrappers::add(buffered, i % 300);
+			if (i % 7 == 0)
+				STLWrappers::remove(buffered, i % 300);
+		}
+		REQUIRE(buffered.runCount() == 0);
+		std::set<int> expected;
+		for (int i = 0; i < 800; ++i) {
+			STLWrappers::add(expected, i % 300);
+			if (i % 7 == 0)
+				STLWrappers::remove(expected, i % 300);
+		}
+		for (int item = -1; item <= 300; ++item)
+			REQUIRE(STLWrappers::contains(buffered, item) == STLWrappers::contains(expected, item));
+	}
+
+	SECTION("compact() leaves nothing for const reads to merge") {
+		STLWrappers::remove(lsm, 3);
+		lsm.compact();
+		REQUIRE(lsm.runCount() == 1);
+		const auto& reader = lsm;
+		REQUIRE(std::size(reader) == 4);
+		REQUIRE(std::vector<int>(std::begin(reader), std::end(reader)) == std::vector<int>{ 1, 2, 4, 5 });
+		REQUIRE(lsm.runCount() == 1);
+	}
+}
+
+TEST_CASE("PersistentHashMap and PersistentHashSet") {
+	SECTION("map") {
+		STLWrappers::PersistentHashMap<int, int> m{ {1,2}, {2,3}, {3,4} };
+		REQUIRE(STLWrappers::find(m, 3) != nullptr);
+		REQUIRE(STLWrappers::find(m, 3)->second == 4);
+		REQUIRE(STLWrappers::find(m, 0) == nullptr);
+		REQUIRE(STLWrappers::contains(m, 1));
+		REQUIRE(STLWrappers::count(m, 2) == 1);
+		REQUIRE(STLWrappers::containsAll(m, { 1,2,3 }));
+
+		auto snapshot = m;
+		STLWrappers::add(m, 4, 5);
+		STLWrappers::add(m, std::make_pair(1, 10));
+		STLWrappers::remove(m, 2);
+		REQUIRE(std::size(m) == 3);
+		REQUIRE(STLWrappers::find(m, 1)->second == 10);
+		REQUIRE(!STLWrappers::contains(m, 2));
+		REQUIRE(std::size(snapshot) == 3);
+		REQUIRE(STLWrappers::find(snapshot, 1)->second == 2);
+		REQUIRE(STLWrappers::contains(snapshot, 2));
+		REQUIRE(!STLWrappers::contains(snapshot, 4));
+	}
+
+	SECTION("set") {
+		STLWrappers::PersistentHashSet<int> s;
+		std::vector<STLWrappers::PersistentHashSet<int>> versions;
+		for (int i = 0; i < 1000; ++i) {
+			versions.push_back(s);
+			STLWrappers::add(s, i);
+		}
+		REQUIRE(std::size(s) == 1000);
+		REQUIRE(std::size(versions[500]) == 500);
+		REQUIRE(STLWrappers::contains(versions[500], 499));
+		REQUIRE(!STLWrappers::contains(versions[500], 500));
+
+		for (int i = 0; i < 1000; i += 2)
+			STLWrappers::remove(s, i);
+		REQUIRE(std::size(s) == 500);
+		REQUIRE(STLWrappers::count(s, 2) == 0);
+		REQUIRE(STLWrappers::count(s, 3) == 1);
+		REQUIRE(std::distance(std::begin(s), std::end(s)) == 500);
+		REQUIRE(std::size(versions[999]) == 999);
+	}
+}
+
+TEST_CASE("Cow") {
+	STLWrappers::Cow<std::vector<int>> v{ 1,2,3 };
+	STLWrappers::Cow<std::set<int>> s{ 1,2,3 };
+
+	SECTION("search works without copying") {
+		auto copy = v;
+		REQUIRE(copy.isShared());
+		REQUIRE(STLWrappers::find(copy, 3) != std::end(copy));
+		REQUIRE(STLWrappers::contains(copy, 1));
+		REQUIRE(STLWrappers::count(copy, 2) == 1);
+		REQUIRE(STLWrappers::containsAll(s, { 1,2,3 }));
+		REQUIRE(&copy.get() == &v.get());
+	}
+
+	SECTION("add and remove copy only shared containers") {
+		auto copy = s;
+		STLWrappers::add(copy, 4);
+		STLWrappers::remove(copy, 1);
+		REQUIRE(!copy.isShared());
+		REQUIRE(!s.isShared());
+		REQUIRE(std::size(copy) == 3);
+		REQUIRE(STLWrappers::containsAll(copy, { 2,3,4 }));
+		REQUIRE(std::size(s) == 3);
+		REQUIRE(STLWrappers::containsAll(s, { 1,2,3 }));
+
+		const std::set<int>* before = &copy.get();
+		STLWrappers::addAll(copy, { 5,6 });
+		REQUIRE(&copy.get() == before);
+	}
+
+	SECTION("works on maps") {
+		STLWrappers::Cow<std::map<int, int>> m{ {1,2} };
+		auto copy = m;
+		STLWrappers::add(copy, 2, 3);
+		REQUIRE(STLWrappers::contains(copy, 2));
+		REQUIRE(!STLWrappers::contains(m, 2));
+	}
+
+	SECTION("a moved-from cow is empty and usable") {
+		auto moved = std::move(s);
+		REQUIRE(std::size(moved) == 3);
+		REQUIRE(s.empty());
+		REQUIRE(!STLWrappers::contains(s, 1));
+		REQUIRE(std::begin(s) == std::end(s));
+		STLWrappers::add(s, 7);
+		REQUIRE(std::size(s) == 1);
+		REQUIRE(std::size(moved) == 3);
+	}
+
+	SECTION("copies can be dropped on other threads") {
+		auto copy = s;
+		size_t seen = 0;
+		std::thread reader([shared = std::move(copy), &seen]() mutable {
+			seen = std::size(shared);
+			shared = STLWrappers::Cow<std::set<int>>();
+		});
+		reader.join();
+		REQUIRE(seen == 3);
+		REQUIRE(!s.isShared());
+		const std::set<int>* before = &s.get();
+		STLWrappers::add(s, 4);
+		REQUIRE(&s.get() == before);
+	}
+}
+
+TEST_CASE("RadixTreeMap and RadixTreeSet") {
+	SECTION("set") {
+		STLWrappers::RadixTreeSet s{ "/api/users", "/api/users/42", "/api/orders", "/static/app.js" };
+		REQUIRE(STLWrappers::find(s, "/api/users") != std::end(s));
+		REQUIRE(*STLWrappers::find(s, "/api/users") == "/api/users");
+		REQUIRE(STLWrappers::find(s, "/api") == std::end(s));
+		REQUIRE(STLWrappers::contains(s, std::string("/api/orders")));
+		REQUIRE(!STLWrappers::contains(s, "/api/orders/1"));
+		REQUIRE(STLWrappers::count(s, "/static/app.js") == 1);
+		REQUIRE(STLWrappers::containsAll(s, { "/api/users", "/api/users/42" }));
+
+		REQUIRE(STLWrappers::containsPrefix(s, "/api/us"));
+		REQUIRE(STLWrappers::containsPrefix(s, ""));
+		REQUIRE(!STLWrappers::containsPrefix(s, "/apx"));
+		std::vector<std::string> users{ "/api/users", "/api/users/42" };
+		REQUIRE(STLWrappers::findByPrefix(s, "/api/u") == users);
+		REQUIRE(STLWrappers::findByPrefix(s, "/nothing").empty());
+
+		STLWrappers::add(s, "/api");
+		STLWrappers::remove(s, "/api/users");
+		REQUIRE(std::size(s) == 4);
+		REQUIRE(STLWrappers::contains(s, "/api"));
+		REQUIRE(!STLWrappers::contains(s, "/api/users"));
+		REQUIRE(STLWrappers::contains(s, "/api/users/42"));
+		std::vector<std::string> sorted{ "/api", "/api/orders", "/api/users/42", "/static/app.js" };
+		REQUIRE(std::equal(std::begin(s), std::end(s), std::begin(sorted), std::end(sorted)));
+	}
+
+	SECTION("map") {
+		STLWrappers::RadixTreeMap<int> m{ {"a", 1}, {"ab", 2} };
+		STLWrappers::add(m, "abc", 3);
+		STLWrappers::add(m, std::make_pair(std::string("a"), 10));
+		REQUIRE(std::size(m) == 3);
+		REQUIRE(STLWrappers::find(m, "a")->second == 10);
+		REQUIRE(STLWrappers::contains(m, "abc"));
+		STLWrappers::remove(m, "ab");
+		REQUIRE(!STLWrappers::contains(m, "ab"));
+		REQUIRE(STLWrappers::findByPrefix(m, "ab") == std::vector<std::string>{ "abc" });
+	}
+
+	SECTION("nodes grow and shrink") {
+		std::set<std::string> expected;
+		STLWrappers::RadixTreeSet s;
+		for (int i = 0; i < 3000; ++i) {
+			std::string key = "k" + std::to_string(i * 7 % 1000);
+			if (i % 3 == 2) {
+				STLWrappers::remove(s, key);
+				STLWrappers::remove(expected, key);
+			}
+			else {
+				STLWrappers::add(s, key);
+				STLWrappers::add(expected, key);
+			}
+		}
+		REQUIRE(std::size(s) == std::size(expected));
+		REQUIRE(std::equal(std::begin(s), std::end(s), std::begin(expected), std::end(expected)));
+	}
+
+	SECTION("wide nodes grow to 256 children and shrink back") {
+		// every byte value after a shared prefix, so one node goes through all four layouts
+		auto keyOf = [](int byte) { return std::string("p") + static_cast<char>(byte) + "x"; };
+		auto same = [](const auto& a, const auto& b) { return a.first == b.first && a.second == b.second; };
+		STLWrappers::RadixTreeMap<int> m;
+		std::map<std::string, int> expected;
+		for (int byte = 0; byte < 256; ++byte) {
+			int b = byte * 37 % 256; // not in sorted order
+			STLWrappers::add(m, keyOf(b), b);
+			expected[keyOf(b)] = b;
+			if (byte == 4 || byte == 16 || byte == 48 || byte == 255) {
+				REQUIRE(std::size(m) == std::size(expected));
+				REQUIRE(std::equal(std::begin(m), std::end(m), std::begin(expected), std::end(expected), same));
+			}
+		}
+		for (int byte = 0; byte < 256; ++byte) {
+			REQUIRE(STLWrappers::find(m, keyOf(byte))->second == byte);
+			REQUIRE(!STLWrappers::contains(m, keyOf(byte) + "y"));
+		}
+		REQUIRE(STLWrappers::findByPrefix(m, std::string("p") + static_cast<char>(200)) == std::vector<std::string>{ keyOf(200) });
+
+		for (int byte = 0; byte < 256; ++byte) {
+			int b = byte * 91 % 256;
+			STLWrappers::remove(m, keyOf(b));
+			expected.erase(keyOf(b));
+			REQUIRE(!STLWrappers::contains(m, keyOf(b)));
+			if (expected.size() == 40 || expected.size() == 37 || expected.size() == 12 || expected.size() == 3 || expected.size() == 1) {
+				REQUIRE(std::size(m) == std::size(expected));
+				REQUIRE(std::equal(std::begin(m), std::end(m), std::begin(expected), std::end(expected), same));
+				for (const auto& item : expected)
+					REQUIRE(STLWrappers::find(m, item.first)->second == item.second);
+			}
+		}
+		REQUIRE(std::size(m) == 0);
+		REQUIRE(std::begin(m) == std::end(m));
+	}
+}
+
+TEST_CASE("containsAnySubstring() and findAllSubstrings()") {
+	std::string text = "GET /index.html from 10.0.0.1, user agent: curl";
+
+	SECTION("with an initializer list") {
+		REQUIRE(STLWrappers::containsAnySubstring(text, { "wget", "curl" }));
+		REQUIRE(!STLWrappers::containsAnySubstring(text, { "POST", "wget" }));
+	}
+
+	SECTION("with a compiled matcher") {
+		std::vector<std::string> keywords{ "he", "she", "his", "hers" };
+		STLWrappers::MultiPattern matcher(keywords);
+		REQUIRE(matcher.patternCount() == 4);
+		REQUIRE(STLWrappers::containsAnySubstring("ushers", matcher));
+		REQUIRE(!STLWrappers::containsAnySubstring("usher", STLWrappers::MultiPattern{ "x", "y" }));
+
+		std::vector<STLWrappers::SubstringMatch> expected{ {1,1}, {2,0}, {2,3} };
+		REQUIRE(STLWrappers::findAllSubstrings("ushers", matcher) == expected);
+		REQUIRE(STLWrappers::findAllSubstrings("nothing here", keywords).size() == 1);
+	}
+
+	SECTION("skips ahead over long texts") {
+		std::string log(10000, '.');
+		log.replace(9000, 5, "ERROR");
+		auto matches = STLWrappers::findAllSubstrings(log, { "ERROR", "FATAL", "PANIC" });
+		REQUIRE(matches.size() == 1);
+		REQUIRE(matches[0].position == 9000);
+		REQUIRE(matches[0].pattern == 0);
+	}
+}
+
+TEST_CASE("byte search") {
+	std::string text = "first line\nsecond line\nthird line, the last one is a bit longer than the others\n";
+	std::vector<char> bytes(std::begin(text), std::end(text));
+
+	SECTION("find and count") {
+		REQUIRE(STLWrappers::find(text, '\n') - std::begin(text) == 10);
+		REQUIRE(STLWrappers::find(text, 'z') == std::end(text));
+		REQUIRE(STLWrappers::contains(text, ','));
+		REQUIRE(STLWrappers::count(text, '\n') == 3);
+		REQUIRE(STLWrappers::count(text, 'z') == 0);
+		REQUIRE(STLWrappers::find(bytes, 's') - std::begin(bytes) == 3);
+		REQUIRE(STLWrappers::count(bytes, '\n') == 3);
+		REQUIRE(STLWrappers::count(std::string(), 'x') == 0);
+	}
+
+	SECTION("findSubsequence and containsSubsequence") {
+		REQUIRE(STLWrappers::findSubsequence(text, "line") - std::begin(text) == 6);
+		REQUIRE(STLWrappers::findSubsequence(text, std::string("others\n")) - std::begin(text) == text.size() - 7);
+		REQUIRE(STLWrappers::findSubsequence(text, "lines") == std::end(text));
+		REQUIRE(STLWrappers::containsSubsequence(text, "bit longer"));
+		REQUIRE(!STLWrappers::containsSubsequence(text, "bit shorter"));
+		REQUIRE(STLWrappers::containsSubsequence(bytes, std::vector<char>{ 'o','n','e' }));
+		REQUIRE(STLWrappers::containsSubsequence(std::vector<int>{ 1,2,3,4 }, { 2,3 }));
+		REQUIRE(!STLWrappers::containsSubsequence(std::vector<int>{ 1,2,3,4 }, std::vector<int>{ 3,2 }));
+	}
+}
+
+TEST_CASE("StringPool, InternedSet and InternedMap") {
+	STLWrappers::StringPool pool;
+	STLWrappers::StringId a = pool.intern("https://example.com/a");
+	REQUIRE(pool.intern(std::string("https://example.com/a")) == a);
+	REQUIRE(pool.intern("https://example.com/b") != a);
+	REQUIRE(pool.view(a) == "https://example.com/a");
+	REQUIRE(pool.size() == 2);
+	REQUIRE(!pool.lookup("https://example.com/c"));
+
+	SECTION("set") {
+		STLWrappers::InternedSet s(pool, { "https://example.com/a", "https://example.com/b" });
+		REQUIRE(STLWrappers::find(s, "https://example.com/a") != std::end(s));
+		REQUIRE(*STLWrappers::find(s, a) == "https://example.com/a");
+		REQUIRE(STLWrappers::contains(s, std::string("https://example.com/b")));
+		REQUIRE(!STLWrappers::contains(s, "https://example.com/c"));
+		REQUIRE(STLWrappers::count(s, a) == 1);
+
+		STLWrappers::InternedSet other(pool);
+		STLWrappers::addAll(other, s);
+		STLWrappers::add(other, "https://example.com/c");
+		STLWrappers::remove(other, a);
+		REQUIRE(std::size(other) == 2);
+		REQUIRE(STLWrappers::containsAll(other, { "https://example.com/b", "https://example.com/c" }));
+		REQUIRE(pool.size() == 3);
+	}
+
+	SECTION("map") {
+		STLWrappers::InternedMap<int> m(pool);
+		STLWrappers::add(m, "GET", 1);
+		STLWrappers::add(m, std::make_pair(std::string("POST"), 2));
+		REQUIRE(STLWrappers::find(m, "GET")->second == 1);
+		REQUIRE(STLWrappers::contains(m, pool.intern("POST")));
+		STLWrappers::remove(m, "GET");
+		REQUIRE(!STLWrappers::contains(m, "GET"));
+		REQUIRE(std::size(m) == 1);
+	}
+
+	SECTION("a moved-from pool is empty and usable") {
+		STLWrappers::StringPool moved(std::move(pool));
+		REQUIRE(moved.view(a) == "https://example.com/a");
+		REQUIRE(pool.size() == 0);
+		REQUIRE(!pool.lookup("https://example.com/a"));
+		STLWrappers::StringId c = pool.intern(std::string(100, 'c'));
+		REQUIRE(pool.view(c) == std::string(100, 'c'));
+		REQUIRE(moved.view(a) == "https://example.com/a");
+
+		pool = std::move(moved);
+		REQUIRE(pool.view(a) == "https://example.com/a");
+		REQUIRE(moved.size() == 0);
+		REQUIRE(moved.intern("x") == STLWrappers::StringId{ 0 });
+	}
+}
+
+TEST_CASE("ArenaStringMap and ArenaStringSet") {
+	SECTION("map") {
+		STLWrappers::ArenaStringMap<int> m{ {"alpha", 1}, {"beta", 2} };
+		std::string key = "gamma";
+		STLWrappers::add(m, key, 3);
+		STLWrappers::add(m, std::make_pair("alpha", 10));
+		REQUIRE(std::size(m) == 3);
+		REQUIRE(STLWrappers::find(m, "alpha")->second == 10);
+		REQUIRE(STLWrappers::find(m, std::string_view("delta")) == std::end(m));
+		REQUIRE(STLWrappers::contains(m, key));
+		REQUIRE(STLWrappers::count(m, "beta") == 1);
+		STLWrappers::remove(m, "beta");
+		REQUIRE(!STLWrappers::contains(m, "beta"));
+		m.clear();
+		REQUIRE(std::size(m) == 0);
+		REQUIRE(!STLWrappers::contains(m, "alpha"));
+	}
+
+	SECTION("set through many adds and removes") {
+		STLWrappers::ArenaStringSet s;
+		std::set<std::string> expected;
+		for (int i = 0; i < 3000; ++i) {
+			std::string item = "key" + std::to_string(i * 13 % 700);
+			if (i % 3 == 2) {
+				STLWrappers::remove(s, item);
+				STLWrappers::remove(expected, item);
+			}
+			else {
+				STLWrappers::add(s, item);
+				STLWrappers::add(expected, item);
+			}
+		}
+		REQUIRE(std::size(s) == std::size(expected));
+		for (int i = 0; i < 700; ++i) {
+			std::string item = "key" + std::to_string(i);
+			REQUIRE(STLWrappers::contains(s, item) == STLWrappers::contains(expected, item));
+		}
+		REQUIRE(std::set<std::string>(std::begin(s), std::end(s)) == expected);
+	}
+
+	SECTION("keys can't be changed, and adding an existing key doesn't grow the table") {
+		STLWrappers::ArenaStringMap<int> m;
+		static_assert(!std::is_assignable_v<decltype((std::begin(m)->first)), std::string_view>, "keys are const");
+		for (int i = 0; i < 12; ++i) // the table grows when a 13th key is added
+			STLWrappers::add(m, "key" + std::to_string(i), i);
+		auto position = STLWrappers::find(m, "key0");
+		auto added = m.insert("key0", 100);
+		REQUIRE(!added.second);
+		REQUIRE(added.first == m.find("key0"));
+		REQUIRE(&*position == &*added.first);
+		REQUIRE(position->second == 0);
+		m.find("key5")->second = 50;
+		REQUIRE(STLWrappers::find(m, "key5")->second == 50);
+	}
+
+	SECTION("moved-from containers are empty and usable") {
+		STLWrappers::ArenaStringMap<int> m{ {"alpha", 1}, {"beta", 2} };
+		STLWrappers::ArenaStringMap<int> moved(std::move(m));
+		REQUIRE(std::size(m) == 0);
+		REQUIRE(!STLWrappers::contains(m, "alpha"));
+		REQUIRE(std::begin(m) == std::end(m));
+		STLWrappers::add(m, "gamma", 3);
+		REQUIRE(STLWrappers::find(m, "gamma")->second == 3);
+		REQUIRE(STLWrappers::find(moved, "alpha")->second == 1);
+		REQUIRE(STLWrappers::find(moved, "beta")->second == 2);
+
+		m = std::move(moved);
+		REQUIRE(std::size(m) == 2);
+		REQUIRE(std::size(moved) == 0);
+		REQUIRE(!STLWrappers::contains(moved, "beta"));
+
+		STLWrappers::ArenaStringSet s{ "x", "y" };
+		STLWrappers::ArenaStringSet other(std::move(s));
+		STLWrappers::add(s, "z");
+		REQUIRE(std::size(s) == 1);
+		REQUIRE(STLWrappers::containsAll(other, { "x", "y" }));
+		REQUIRE(!STLWrappers::contains(other, "z"));
+	}
+}
+
+TEST_CASE("HashedKey and prehash") {
+	STLWrappers::HashedSet<std::string> s;
+	STLWrappers::add(s, std::string("alpha"));
+	STLWrappers::add(s, std::string("beta"));
+	STLWrappers::HashedMap<std::string, int> m;
+	STLWrappers::add(m, std::string("beta"), 2);
+	STLWrappers::add(m, std::string("gamma"), 3);
+
+	// hash once, probe both containers
+	auto beta = STLWrappers::prehash(std::string("beta"));
+	REQUIRE(STLWrappers::contains(s, beta));
+	REQUIRE(STLWrappers::find(m, beta)->second == 2);
+
+	// plain keys are hashed for the call
+	REQUIRE(STLWrappers::contains(s, std::string("alpha")));
+	REQUIRE(STLWrappers::count(m, std::string("alpha")) == 0);
+	REQUIRE(STLWrappers::find(m, std::string("gamma"))->second == 3);
+	STLWrappers::remove(s, std::string("alpha"));
+	STLWrappers::remove(m, beta);
+	REQUIRE(!STLWrappers::contains(s, std::string("alpha")));
+	REQUIRE(!STLWrappers::contains(m, std::string("beta")));
+	REQUIRE(std::size(s) == 1);
+	REQUIRE(std::size(m) == 1);
+}
+
+TEST_CASE("FastHash") {
+	SECTION("equal values hash equal") {
+		STLWrappers::FastHash<std::string> stringHash;
+		REQUIRE(stringHash(std::string("hello world")) == STLWrappers::FastHash<std::string_view>{}("hello world"));
+		REQUIRE(stringHash(std::string("hello")) != stringHash(std::string("hellp")));
+		REQUIRE(STLWrappers::FastHash<double>{}(0.0) == STLWrappers::FastHash<double>{}(-0.0));
+		auto pair = std::make_pair(1, std::string("one"));
+		REQUIRE(STLWrappers::FastHash<std::pair<int, std::string>>{}(pair) == STLWrappers::FastHash<std::pair<int, std::string>>{}(pair));
+		REQUIRE(STLWrappers::FastHash<std::pair<int, int>>{}({ 1, 2 }) != STLWrappers::FastHash<std::pair<int, int>>{}({ 2, 1 }));
+		REQUIRE(STLWrappers::FastHash<std::tuple<int, char>>{}({ 1, 'a' }) == STLWrappers::FastHash<std::tuple<int, char>>{}({ 1, 'a' }));
+		std::string bytes(100, 'x');
+		REQUIRE(STLWrappers::hashBytes(bytes.data(), bytes.size()) == STLWrappers::hashBytes(bytes.data(), bytes.size()));
+		REQUIRE(STLWrappers::hashBytes(bytes.data(), bytes.size()) != STLWrappers::hashBytes(bytes.data(), bytes.size() - 1));
+	}
+
+	SECTION("sequential integers spread over the low bits") {
+		std::set<size_t> buckets;
+		for (int i = 0; i < 1024; ++i)
+			buckets.insert(STLWrappers::FastHash<int>{}(i * 1024) & 1023);
+		REQUIRE(std::size(buckets) > 500);
+	}
+
+	SECTION("works as the hash of a std container") {
+		std::unordered_set<std::string, STLWrappers::FastHash<std::string>> s{ "a", "b" };
+		REQUIRE(STLWrappers::contains(s, std::string("a")));
+		REQUIRE(!STLWrappers::contains(s, std::string("c")));
+	}
+}
+
+TEST_CASE("ArrayMap") {
+	enum class Opcode { Nop = 0, Load = 3, Store = 64, Halt = 200 };
+	STLWrappers::ArrayMap<std::string, 255> m{ {0, "nop"}, {3, "load"} };
+	STLWrappers::add(m, Opcode::Halt, std::string("halt"));
+	STLWrappers::addAll(m, std::vector<std::pair<int, std::string>>{ {64, "store"}, {3, "LOAD"} });
+
+	REQUIRE(std::size(m) == 4);
+	REQUIRE(STLWrappers::find(m, Opcode::Load)->second == "LOAD");
+	REQUIRE(STLWrappers::contains(m, 200));
+	REQUIRE(!STLWrappers::contains(m, 1));
+	REQUIRE(!STLWrappers::contains(m, 1000));
+	REQUIRE(!STLWrappers::contains(m, -1));
+	REQUIRE(STLWrappers::count(m, Opcode::Store) == 1);
+	REQUIRE(STLWrappers::containsAll(m, { 0, 3, 64 }));
+
+	// iteration is in key order
+	std::vector<size_t> keys;
+	for (const auto& entry : m)
+		keys.push_back(entry.first);
+	REQUIRE(keys == std::vector<size_t>{ 0, 3, 64, 200 });
+
+	STLWrappers::remove(m, Opcode::Nop);
+	STLWrappers::remove(m, 7);
+	REQUIRE(std::size(m) == 3);
+	REQUIRE(!STLWrappers::contains(m, Opcode::Nop));
+	REQUIRE(std::begin(m)->first == 3);
+
+	// keys outside 0 to MaxKey are rejected instead of written out of bounds
+	STLWrappers::add(m, 256, std::string("past the end"));
+	STLWrappers::add(m, -1, std::string("negative"));
+	REQUIRE(!m.insert(1000, "far"));
+	REQUIRE(std::size(m) == 3);
+	REQUIRE(!STLWrappers::contains(m, 256));
+	m.clear();
+	REQUIRE(std::begin(m) == std::end(m));
+}
+
+TEST_CASE("SoaFlatMap") {
+	SECTION("small map") {
+		STLWrappers::SoaFlatMap<int, std::string> m{ {3, "three"}, {1, "one"}, {3, "THREE"} };
+		STLWrappers::add(m, std::make_pair(2, std::string("two")));
+		REQUIRE(std::size(m) == 3);
+		REQUIRE(STLWrappers::find(m, 3)->second == "three");
+		REQUIRE(STLWrappers::contains(m, 2));
+		REQUIRE(!STLWrappers::contains(m, 4));
+		REQUIRE(STLWrappers::count(m, 1) == 1);
+		STLWrappers::remove(m, 1);
+		REQUIRE(!STLWrappers::contains(m, 1));
+		REQUIRE(std::vector<int>(std::begin(m.keys()), std::end(m.keys())) == std::vector<int>{ 2, 3 });
+	}
+
+	SECTION("large map against std::map") {
+		STLWrappers::SoaFlatMap<int, int> m;
+		std::map<int, int> expected;
+		for (int i = 0; i < 2000; ++i) {
+			int key = (i * 7919) % 1500 - 300;
+			if (i % 4 == 3) {
+				STLWrappers::remove(m, key);
+				STLWrappers::remove(expected, key);
+			}
+			else {
+				STLWrappers::add(m, key, i);
+				STLWrappers::add(expected, key, i);
+			}
+		}
+		REQUIRE(std::size(m) == std::size(expected));
+		for (int key = -400; key < 1300; ++key)
+			REQUIRE(STLWrappers::contains(m, key) == STLWrappers::contains(expected, key));
+		REQUIRE(std::equal(std::begin(m), std::end(m), std::begin(expected), std::end(expected),
+			[](const auto& a, const auto& b) { return a.first == b.first && a.second == b.second; }));
+	}
+
+	SECTION("keys() works with the set operations") {
+		STLWrappers::SoaFlatMap<int, char> m{ {1, 'a'}, {2, 'b'}, {3, 'c'} };
+		std::set<int> other{ 2, 3, 4 };
+		REQUIRE(STLWrappers::containsAll(other, STLWrappers::SoaFlatMap<int, char>{ {2, 'x'}, {3, 'y'} }.keys()));
+		REQUIRE(STLWrappers::containsAny(m.keys(), { 3, 5 }));
+		auto onlyInMap = STLWrappers::inFirstButNotInSecond(m.keys(), other);
+		REQUIRE(std::size(onlyInMap) == 1);
+		REQUIRE(STLWrappers::contains(onlyInMap, 1));
+	}
+}
+
+TEST_CASE("GroupedMap") {
+	SECTION("built from pairs") {
+		STLWrappers::GroupedMap<std::string, int> m{ {"b", 1}, {"a", 2}, {"b", 3}, {"c", 4}, {"b", 5} };
+		REQUIRE(std::size(m) == 3);
+		REQUIRE(m.valueCount() == 5);
+		auto group = STLWrappers::find(m, std::string("b"));
+		REQUIRE(std::vector<int>(std::begin(group), std::end(group)) == std::vector<int>{ 1, 3, 5 });
+		REQUIRE(STLWrappers::count(m, std::string("b")) == 3);
+		REQUIRE(STLWrappers::count(m, std::string("z")) == 0);
+		REQUIRE(STLWrappers::find(m, std::string("z")).empty());
+		REQUIRE(STLWrappers::contains(m, std::string("a")));
+		REQUIRE(!STLWrappers::contains(m, std::string("z")));
+		REQUIRE(STLWrappers::containsAll(m, std::string("b"), { 5, 1 }));
+		REQUIRE(!STLWrappers::containsAll(m, std::string("b"), std::vector<int>{ 1, 2 }));
+		REQUIRE(std::begin(m)->first == "a");
+	}
+
+	SECTION("built from a map of vectors") {
+		std::unordered_map<int, std::vector<int>> groups{ {1, {10, 11}}, {2, {}}, {3, {30}} };
+		STLWrappers::GroupedMap<int, int> m(groups);
+		REQUIRE(std::size(m) == 2); // empty groups have no values, so no key
+		REQUIRE(STLWrappers::count(m, 1) == 2);
+		REQUIRE(STLWrappers::find(m, 3)[0] == 30);
+	}
+
+	SECTION("built incrementally") {
+		STLWrappers::GroupedMap<int, int>::Builder builder;
+		std::map<int, std::vector<int>> expected;
+		for (int i = 0; i < 1000; ++i) {
+			STLWrappers::add(builder, i % 37, i);
+			expected[i % 37].push_back(i);
+		}
+		STLWrappers::add(builder, std::make_pair(100, 1));
+		expected[100].push_back(1);
+		auto m = builder.build();
+		REQUIRE(builder.size() == 0);
+		REQUIRE(std::size(m) == std::size(expected));
+		for (const auto& entry : m)
+			REQUIRE(std::vector<int>(std::begin(entry.second), std::end(entry.second)) == expected[entry.first]);
+	}
+}
+
+namespace {
+	struct ByName {};
+
+	struct Task : STLWrappers::IntrusiveListHook<>, STLWrappers::IntrusiveSetHook<>, STLWrappers::IntrusiveSetHook<ByName> {
+		Task(int id, std::string name) : id(id), name(std::move(name)) {}
+		int id;
+		std::string name;
+	};
+
+	struct TaskIdLess {
+		bool operator()(const Task& a, const Task& b) const { return a.id < b.id; }
+		bool operator()(const Task& a, int b) const { return a.id < b; }
+		bool operator()(int a, const Task& b) const { return a < b.id; }
+	};
+
+	struct TaskNameLess {
+		bool operator()(const Task& a, const Task& b) const { return a.name < b.name; }
+	};
+}
+
+TEST_CASE("IntrusiveList and IntrusiveSet") {
+	std::vector<Task> pool{ {3, "c"}, {1, "b"}, {2, "a"} };
+	STLWrappers::IntrusiveList<Task> queue;
+	STLWrappers::IntrusiveSet<Task, TaskIdLess> byId;
+	STLWrappers::IntrusiveSet<Task, TaskNameLess, ByName> byName;
+
+	// the same objects are in all three containers at once
+	STLWrappers::addAll(queue, pool);
+	STLWrappers::addAll(byId, pool);
+	for (auto& task : pool)
+		STLWrappers::add(byName, task);
+
+	REQUIRE(std::size(queue) == 3);
+	REQUIRE(STLWrappers::contains(queue, pool[1]));
+	REQUIRE(&*STLWrappers::find(byId, 2) == &pool[2]);
+	REQUIRE(STLWrappers::count(byId, 4) == 0);
+	REQUIRE(std::begin(byName)->id == 2);
+	std::vector<int> ids;
+	for (const auto& task : byId)
+		ids.push_back(task.id);
+	REQUIRE(ids == std::vector<int>{ 1, 2, 3 });
+
+	STLWrappers::remove(queue, pool[0]);
+	STLWrappers::remove(byId, 1);
+	REQUIRE(!STLWrappers::contains(queue, pool[0]));
+	REQUIRE(std::begin(queue)->id == 1);
+	REQUIRE(!STLWrappers::contains(byId, 1));
+	REQUIRE(std::size(byId) == 2);
+	REQUIRE(std::size(byName) == 3);
+
+	// removed objects can be added again
+	STLWrappers::add(queue, pool[0]);
+	REQUIRE(queue.back().id == 3);
+
+	// adding an object that is already linked (here or in another container with the same tag) does nothing
+	STLWrappers::add(queue, pool[0]);
+	REQUIRE(std::size(queue) == 3);
+	STLWrappers::IntrusiveList<Task> other;
+	STLWrappers::add(other, pool[1]);
+	REQUIRE(other.empty());
+	REQUIRE(STLWrappers::contains(queue, pool[1]));
+	std::vector<int> queued;
+	for (const auto& task : queue)
+		queued.push_back(task.id);
+	REQUIRE(queued == std::vector<int>{ 1, 2, 3 });
+
+	STLWrappers::add(byId, pool[2]);
+	REQUIRE(std::size(byId) == 2);
+	STLWrappers::IntrusiveSet<Task, TaskIdLess> otherById;
+	REQUIRE(!otherById.insert(pool[2]).second);
+	REQUIRE(otherById.empty());
+	REQUIRE(&*STLWrappers::find(byId, 2) == &pool[2]);
+	queue.clear();
+	REQUIRE(!static_cast<const STLWrappers::IntrusiveListHook<>&>(pool[0]).isLinked());
+}
+
+TEST_CASE("MappedSet and MappedMap") {
+	const std::string path = "STLWrappers_mapped_test.bin";
+
+	SECTION("set of integers, hashed and sorted") {
+		std::vector<int> items{ 5, -3, 12, 5, 40000 };
+		for (auto layout : { STLWrappers::MappedLayout::Hashed, STLWrappers::MappedLayout::Sorted }) {
+			REQUIRE(STLWrappers::writeMappedSet(path, items, layout));
+			STLWrappers::MappedSet<int> s(path, true);
+			REQUIRE(s.isOpen());
+			REQUIRE(std::size(s) == 4);
+			REQUIRE(STLWrappers::contains(s, -3));
+			REQUIRE(STLWrappers::contains(s, 40000));
+			REQUIRE(!STLWrappers::contains(s, 6));
+			REQUIRE(STLWrappers::count(s, 12) == 1);
+			REQUIRE(std::set<int>(std::begin(s), std::end(s)) == std::set<int>(std::begin(items), std::end(items)));
+		}
+	}
+
+	SECTION("map of strings") {
+		std::map<std::string, std::string> m{ {"apple", "red"}, {"banana", "yellow"}, {"", "empty"} };
+		REQUIRE(STLWrappers::writeMappedMap(path, m, STLWrappers::MappedLayout::Sorted));
+		STLWrappers::MappedMap<std::string, std::string> mapped(path);
+		REQUIRE(mapped.isOpen());
+		REQUIRE(mapped.verifyChecksum());
+		REQUIRE(STLWrappers::find(mapped, "banana")->second == "yellow");
+		REQUIRE(STLWrappers::find(mapped, std::string(""))->second == "empty");
+		REQUIRE(!STLWrappers::contains(mapped, "cherry"));
+		REQUIRE(std::begin(mapped)->first == "");
+
+		// a file of another type (or a corrupt one) isn't opened
+		STLWrappers::MappedSet<std::string> wrongType(path);
+		REQUIRE(!wrongType.isOpen());
+		REQUIRE(std::size(wrongType) == 0);
+	}
+
+	SECTION("corrupt file") {
+		REQUIRE(STLWrappers::writeMappedSet(path, std::set<std::string>{ "a", "b" }));
+		{
+			std::FILE* file = std::fopen(path.c_str(), "r+b");
+			std::fseek(file, -1, SEEK_END);
+			std::fputc('z', file);
+			std::fclose(file);
+		}
+		REQUIRE(STLWrappers::MappedSet<std::string>(path).isOpen());
+		REQUIRE(!STLWrappers::MappedSet<std::string>(path, true).isOpen());
+	}
+
+	SECTION("rewriting a file doesn't disturb readers of the old one") {
+		REQUIRE(STLWrappers::writeMappedSet(path, std::vector<int>{ 1, 2, 3 }));
+		STLWrappers::MappedSet<int> old(path);
+		REQUIRE(STLWrappers::writeMappedSet(path, std::vector<int>{ 4 }));
+		REQUIRE(old.verifyChecksum());
+		REQUIRE(std::size(old) == 3);
+		REQUIRE(STLWrappers::containsAll(old, { 1, 2, 3 }));
+		STLWrappers::MappedSet<int> rewritten(path, true);
+		REQUIRE(std::size(rewritten) == 1);
+		REQUIRE(STLWrappers::contains(rewritten, 4));
+	}
+
+	SECTION("header offsets outside the file") {
+		REQUIRE(STLWrappers::writeMappedSet(path, std::vector<int>{ 1, 2 }));
+		STLWrappers::MappedHeader_ header;
+		auto rewriteHeader = [&](uint64_t keysOffset) {
+			std::FILE* file = std::fopen(path.c_str(), "r+b");
+			REQUIRE(std::fread(&header, sizeof(header), 1, file) == 1);
+			header.keysOffset = keysOffset;
+			header.headerChecksum = STLWrappers::hashBytes(&header, offsetof(STLWrappers::MappedHeader_, headerChecksum));
+			std::fseek(file, 0, SEEK_SET);
+			std::fwrite(&header, sizeof(header), 1, file);
+			std::fclose(file);
+		};
+		// an offset that wraps around to the values once the keys are added to it
+		rewriteHeader(~uint64_t(0) - 2 * sizeof(int) + 1);
+		REQUIRE(!STLWrappers::MappedSet<int>(path).isOpen());
+		// an offset inside the header
+		rewriteHeader(0);
+		REQUIRE(!STLWrappers::MappedSet<int>(path).isOpen());
+		rewriteHeader(sizeof(header));
+		REQUIRE(STLWrappers::MappedSet<int>(path).isOpen());
+	}
+	std::remove(path.c_str());
+}
+
+TEST_CASE("serialize() and deserialize()") {
+	SECTION("vector of integers, with and without compression") {
+		std::vector<int> v;
+		for (int i = 0; i < 100000; ++i)
+			v.push_back(i % 100);
+		for (auto compression : { STLWrappers::Compression::None, STLWrappers::Compression::Lz }) {
+			STLWrappers::MemorySink sink;
+			REQUIRE(STLWrappers::serialize(v, sink, compression));
+			auto result = STLWrappers::deserialize<std::vector<int>>(STLWrappers::MemorySource(sink.bytes()));
+			REQUIRE(result);
+			REQUIRE(*result == v);
+		}
+	}
+
+	SECTION("containers are reserved once when the input size is known") {
+		std::vector<int> v(200000, 7);
+		STLWrappers::MemorySink sink;
+		REQUIRE(STLWrappers::serialize(v, sink));
+		auto vector = STLWrappers::deserialize<std::vector<int>>(STLWrappers::MemorySource(sink.bytes()));
+		REQUIRE(vector->capacity() == v.size());
+
+		std::unordered_set<int> u;
+		for (int i = 0; i < 200000; ++i)
+			u.insert(i);
+		STLWrappers::MemorySink other;
+		REQUIRE(STLWrappers::serialize(u, other, STLWrappers::Compression::Lz));
+		std::unordered_set<int> reserved;
+		reserved.reserve(u.size());
+		auto set = STLWrappers::deserialize<std::unordered_set<int>>(STLWrappers::MemorySource(other.bytes()));
+		REQUIRE(*set == u);
+		REQUIRE(set->bucket_count() == reserved.bucket_count());
+	}
+
+	SECTION("maps and sets of strings") {
+		std::map<std::string, std::vector<int>> m{ {"a", {1, 2}}, {"", {}}, {"long key", {3}} };
+		std::unordered_set<std::string> u{ "x", "yy", "zzz" };
+		STLWrappers::MemorySink sink;
+		REQUIRE(STLWrappers::serialize(m, sink));
+		REQUIRE(*STLWrappers::deserialize<std::map<std::string, std::vector<int>>>(STLWrappers::MemorySource(sink.bytes())) == m);
+
+		STLWrappers::MemorySink other;
+		REQUIRE(STLWrappers::serialize(u, other, STLWrappers::Compression::Lz));
+		REQUIRE(*STLWrappers::deserialize<std::unordered_set<std::string>>(STLWrappers::MemorySource(other.bytes())) == u);
+
+		// truncated input is rejected
+		std::vector<uint8_t> truncated(sink.bytes().begin(), sink.bytes().end() - 3);
+		REQUIRE(!STLWrappers::deserialize<std::map<std::string, std::vector<int>>>(STLWrappers::MemorySource(truncated)));
+	}
+
+	SECTION("file") {
+		const char* path = "STLWrappers_serialize_test.bin";
+		std::set<int> s{ 5, 1, 9 };
+		std::FILE* file = std::fopen(path, "wb");
+		REQUIRE(STLWrappers::serialize(s, STLWrappers::FileSink(file)));
+		std::fclose(file);
+		file = std::fopen(path, "rb");
+		auto result = STLWrappers::deserialize<std::set<int>>(STLWrappers::FileSource(file));
+		std::fclose(file);
+		std::remove(path);
+		REQUIRE(result);
+		REQUIRE(*result == s);
+	}
+}
+
+TEST_CASE("writeSnapshot() and loadSnapshot()") {
+	const std::string path = "STLWrappers_snapshot_test.bin";
+	STLWrappers::ThreadPool pool(3);
+
+	SECTION("parallelFor") {
+		std::vector<int> squares(1000);
+		pool.parallelFor(squares.size(), [&](size_t i) { squares[i] = int(i * i); });
+		REQUIRE(squares[999] == 998001);
+	}
+
+	SECTION("parallelFor rethrows the first exception once the running tasks are done") {
+		std::atomic<int> ran{ 0 };
+		auto throwing = [&](size_t i) {
+			++ran;
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+			if (i % 100 == 7)
+				throw std::runtime_error("task " + std::to_string(i));
+		};
+		REQUIRE_THROWS_AS(pool.parallelFor(1000, throwing), std::runtime_error);
+		REQUIRE(ran < 1000); // the items after the failure were skipped
+		// the pool still works
+		std::atomic<int> sum{ 0 };
+		pool.parallelFor(100, [&](size_t i) { sum += int(i); });
+		REQUIRE(sum == 4950);
+	}
+
+	SECTION("vector and set, in several chunks") {
+		std::vector<int> v;
+		for (int i = 0; i < 10000; ++i)
+			v.push_back((i * 37) % 1000);
+		REQUIRE(STLWrappers::writeSnapshot(path, v, STLWrappers::Compression::Lz, 999));
+		REQUIRE(*STLWrappers::loadSnapshot<std::vector<int>>(path, pool) == v);
+
+		std::set<int> s(v.begin(), v.end());
+		REQUIRE(STLWrappers::writeSnapshot(path, s, STLWrappers::Compression::None, 64));
+		REQUIRE(*STLWrappers::loadSnapshot<std::set<int>>(path, pool) == s);
+	}
+
+	SECTION("strings, moved in chunk by chunk, and a file that is rewritten") {
+		std::vector<std::string> v;
+		for (int i = 0; i < 3000; ++i)
+			v.push_back("item " + std::to_string(i % 1700));
+		REQUIRE(STLWrappers::writeSnapshot(path, v, STLWrappers::Compression::Lz, 100));
+		REQUIRE(*STLWrappers::loadSnapshot<std::vector<std::string>>(path, pool) == v);
+		REQUIRE(*STLWrappers::loadSnapshot<std::unordered_set<std::string>>(path, pool) == std::unordered_set<std::string>(v.begin(), v.end()));
+
+		REQUIRE(STLWrappers::writeSnapshot(path, std::vector<std::string>{ "new" }));
+		REQUIRE(*STLWrappers::loadSnapshot<std::vector<std::string>>(path, pool) == std::vector<std::string>{ "new" });
+	}
+
+	SECTION("sharded map") {
+		std::unordered_map<std::string, int> m;
+		for (int i = 0; i < 500; ++i)
+			m[std::to_string(i)] = i;
+		REQUIRE(STLWrappers::writeSnapshot(path, m, STLWrappers::Compression::None, 100));
+		auto shards = STLWrappers::loadSnapshotShards<std::unordered_map<std::string, int>>(path, 4, pool);
+		REQUIRE(shards);
+		REQUIRE(shards->size() == 4);
+		auto& shard = (*shards)[STLWrappers::shardOf(std::string("123"), 4)];
+		REQUIRE(shard.at("123") == 123);
+		size_t total = 0;
+		for (auto& each : *shards)
+			total += each.size();
+		REQUIRE(total == 500);
+	}
+
+	SECTION("missing file") {
+		REQUIRE(!STLWrappers::loadSnapshot<std::vector<int>>("STLWrappers_no_such_file.bin", pool));
+	}
+	std::remove(path.c_str());
+}
+
+TEST_CASE("addAllFromFile()") {
+	const std::string path = "STLWrappers_text_test.txt";
+	{
+		std::FILE* file = std::fopen(path.c_str(), "wb");
+		std::fputs("12\n-7\r\n\n  40 \n12", file);
+		std::fclose(file);
+	}
+
+	SECTION("integers, one per line") {
+		std::vector<int> v{ 1 };
+		REQUIRE(STLWrappers::addAllFromFile(v, path));
+		REQUIRE(v == std::vector<int>{ 1, 12, -7, 40, 12 });
+
+		std::unordered_set<int> s;
+		REQUIRE(STLWrappers::addAllFromFile(s, path));
+		REQUIRE(s == std::unordered_set<int>{ 12, -7, 40 });
+	}
+
+	SECTION("strings and words") {
+		std::vector<std::string> lines;
+		REQUIRE(STLWrappers::addAllFromFile(lines, path));
+		REQUIRE(lines == std::vector<std::string>{ "12", "-7", "  40 ", "12" });
+
+		std::set<std::string> words;
+		REQUIRE(STLWrappers::addAllFromFile(words, path, STLWrappers::TextFormat::Words));
+		REQUIRE(words == std::set<std::string>{ "12", "-7", "40" });
+	}
+
+	SECTION("bad items and missing files") {
+		std::vector<unsigned> v;
+		REQUIRE(!STLWrappers::addAllFromFile(v, path)); // -7 isn't unsigned
+		REQUIRE(v == std::vector<unsigned>{ 12, 40, 12 });
+		REQUIRE(!STLWrappers::addAllFromFile(v, "STLWrappers_no_such_file.txt"));
+
+		{
+			std::FILE* file = std::fopen(path.c_str(), "wb");
+			std::fputs("+5\n+-5\n-+5\n+\n-3", file);
+			std::fclose(file);
+		}
+		std::vector<int> signs;
+		REQUIRE(!STLWrappers::addAllFromFile(signs, path));
+		REQUIRE(signs == std::vector<int>{ 5, -3 });
+	}
+	std::remove(path.c_str());
+}
+
+TEST_CASE("externalInFirstButNotInSecond() and externalIntersection()") {
+	std::vector<int64_t> first, second;
+	for (int64_t i = 0; i < 300000; ++i) {
+		first.push_back((i * 7919) % 200000 - 1000);
+		second.push_back(i % 100000 * 2);
+	}
+	STLWrappers::ExternalMemoryOptions options;
+	options.memoryLimit = 1 << 20; // several runs per input, merged in more than one pass
+
+	STLWrappers::MemorySink difference;
+	REQUIRE(STLWrappers::externalInFirstButNotInSecond<int64_t>(STLWrappers::MemorySource(first.data(), first.size() * sizeof(int64_t)),
+		STLWrappers::MemorySource(second.data(), second.size() * sizeof(int64_t)), difference, options));
+	STLWrappers::MemorySink intersection;
+	REQUIRE(STLWrappers::externalIntersection<int64_t>(STLWrappers::MemorySource(first.data(), first.size() * sizeof(int64_t)),
+		STLWrappers::MemorySource(second.data(), second.size() * sizeof(int64_t)), intersection, options));
+
+	std::set<int64_t> firstSet(first.begin(), first.end());
+	std::set<int64_t> secondSet(second.begin(), second.end());
+	std::vector<int64_t> expectedDifference, expectedIntersection;
+	std::set_difference(firstSet.begin(), firstSet.end(), secondSet.begin(), secondSet.end(), std::back_inserter(expectedDifference));
+	std::set_intersection(firstSet.begin(), firstSet.end(), secondSet.begin(), secondSet.end(), std::back_inserter(expectedIntersection));
+
+	auto items = [](const STLWrappers::MemorySink& sink) {
+		std::vector<int64_t> result(sink.bytes().size() / sizeof(int64_t));
+		std::memcpy(result.data(), sink.bytes().data(), sink.bytes().size());
+		return result;
+	};
+	REQUIRE(items(difference) == expectedDifference);
+	REQUIRE(items(intersection) == expectedIntersection);
+	REQUIRE(expectedDifference.front() == -1000);
+
+	SECTION("many runs with few files open") {
+		const uint32_t count = 40 * 131072; // 40 runs of 1 MB / 8 items
+		std::vector<uint32_t> many(count);
+		for (uint32_t i = 0; i < count; ++i)
+			many[i] = uint32_t(uint64_t(i) * 7919 % count);
+		std::vector<uint32_t> evens;
+		for (uint32_t i = 0; i < 1000; i += 2)
+			evens.push_back(i);
+		options.maxOpenFiles = 6;
+#if !defined(_WIN32)
+		// the runs must not all be open at once
+		rlimit limit;
+		REQUIRE(getrlimit(RLIMIT_NOFILE, &limit) == 0);
+		rlimit lowered = limit;
+		lowered.rlim_cur = std::min<rlim_t>(limit.rlim_cur, 32);
+		REQUIRE(setrlimit(RLIMIT_NOFILE, &lowered) == 0);
+#endif
+		STLWrappers::MemorySink result;
+		bool ok = STLWrappers::externalInFirstButNotInSecond<uint32_t>(STLWrappers::MemorySource(many.data(), many.size() * sizeof(uint32_t)),
+			STLWrappers::MemorySource(evens.data(), evens.size() * sizeof(uint32_t)), result, options);
+#if !defined(_WIN32)
+		setrlimit(RLIMIT_NOFILE, &limit);
+#endif
+		REQUIRE(ok);
+		REQUIRE(result.bytes().size() == (count - evens.size()) * sizeof(uint32_t));
+		uint32_t firstItems[3];
+		std::memcpy(firstItems, result.bytes().data(), sizeof(firstItems));
+		REQUIRE(firstItems[0] == 1);
+		REQUIRE(firstItems[1] == 3);
+		REQUIRE(firstItems[2] == 5);
+	}
+}
+
+TEST_CASE("DiskHashSet") {
+	const std::string path = "STLWrappers_disk_set_test.bin";
+	std::remove(path.c_str());
+	STLWrappers::DiskHashSetOptions options;
+	options.expectedItems = 1000; // small, so buckets overflow
+	options.cacheBytes = 16 * 4096; // small, so pages are evicted
+
+	{
+		STLWrappers::DiskHashSet<uint64_t> s(path, options);
+		REQUIRE(s.isOpen());
+		std::vector<uint64_t> items;
+		for (uint64_t i = 0; i < 5000; ++i)
+			items.push_back(i * 3);
+		STLWrappers::addAll(s, items);
+		STLWrappers::add(s, 1);
+		STLWrappers::add(s, 3);
+		STLWrappers::remove(s, 6);
+		REQUIRE(s.size() == 5000);
+		REQUIRE(STLWrappers::contains(s, 1));
+		REQUIRE(!STLWrappers::contains(s, 6));
+		REQUIRE(STLWrappers::count(s, 14997) == 1);
+	}
+
+	STLWrappers::DiskHashSet<uint64_t> reopened(path, options);
+	REQUIRE(reopened.size() == 5000);
+	size_t wrong = 0;
+	for (uint64_t i = 0; i < 15000; ++i)
+		wrong += STLWrappers::contains(reopened, i) != ((i % 3 == 0 && i != 6) || i == 1) ? 1 : 0;
+	REQUIRE(wrong == 0);
+
+	STLWrappers::DiskHashSet<uint32_t> otherType(path);
+	REQUIRE(!otherType.isOpen());
+	reopened.close();
+
+	SECTION("a truncated file fails searches without crashing") {
+		{
+			std::vector<uint8_t> pages(8 * 4096);
+			std::FILE* file = std::fopen(path.c_str(), "rb");
+			REQUIRE(std::fread(pages.data(), pages.size(), 1, file) == 1);
+			std::fclose(file);
+			file = std::fopen(path.c_str(), "wb");
+			std::fwrite(pages.data(), pages.size(), 1, file);
+			std::fclose(file);
+		}
+		options.cacheBytes = 4 * 4096;
+		options.bloomBitsPerItem = 0;
+		STLWrappers::DiskHashSet<uint64_t> truncated(path, options);
+		REQUIRE(truncated.isOpen());
+		size_t found = 0;
+		for (uint64_t i = 0; i < 15000; i += 3)
+			found += STLWrappers::contains(truncated, i) ? 1 : 0;
+		REQUIRE(found < 5000);
+		REQUIRE(!truncated.good());
+		STLWrappers::add(truncated, 20000);
+	}
+	std::remove(path.c_str());
+}
+
+TEST_CASE("inFirstButNotInSecondStream()") {
+	std::vector<int> first{ 1, 2, 3, 2, 4, 5 };
+	std::set<int> second{ 2, 5 };
+
+	SECTION("from a container") {
+		std::vector<int> result;
+		for (int item : STLWrappers::inFirstButNotInSecondStream(first, second))
+			result.push_back(item);
+		REQUIRE(result == std::vector<int>{ 1, 3, 4 });
+	}
+
+	SECTION("from a generator, read item by item") {
+		int next = 0;
+		int read = 0;
+		auto view = STLWrappers::inFirstButNotInSecondStream(STLWrappers::fromGenerator([&]() -> std::optional<int> {
+			++read;
+			return next < 1000000 ? std::optional<int>(next++) : std::nullopt;
+		}), std::vector<int>{ 0, 1, 2 });
+		auto position = view.begin();
+		REQUIRE(*position == 3);
+		++position;
+		REQUIRE(*position == 4);
+		REQUIRE(read == 5);
+	}
+
+	SECTION("with a callback") {
+		std::vector<std::string> result;
+		STLWrappers::forEachInFirstButNotInSecond(std::vector<std::string>{ "a", "b", "c" }, std::vector<std::string>{ "b" },
+			[&](const std::string& item) { result.push_back(item); });
+		REQUIRE(result == std::vector<std::string>{ "a", "c" });
+	}
+}
+
+#if defined(STLWRAPPERS_COROUTINES_)
+namespace
+{
+	STLWrappers::AsyncTask<size_t> addThenRemove(std::set<int>& s, const std::vector<int>& items, const std::vector<int>& removed, STLWrappers::AsyncOptions options)
+	{
+		size_t added = co_await STLWrappers::addAllAsync(s, items, options);
+		co_await STLWrappers::removeAllAsync(s, removed, options);
+		co_return added;
+	}
+}
+
+TEST_CASE("addAllAsync() and removeAllAsync()") {
+	std::vector<int> items;
+	for (int i = 0; i < 1000; ++i)
+		items.push_back(i);
+	std::vector<int> removed{ 1, 2, 3 };
+	std::vector<std::coroutine_handle<>> ready;
+	STLWrappers::AsyncOptions options;
+	options.sliceSize = 100;
+	options.scheduler = [&](std::coroutine_handle<> handle) { ready.push_back(handle); };
+
+	std::set<int> s;
+	auto task = addThenRemove(s, items, removed, options);
+	task.start();
+	size_t slices = 1;
+	while (!ready.empty()) {
+		auto handle = ready.back();
+		ready.pop_back();
+		handle.resume();
+		++slices;
+	}
+	REQUIRE(task.done());
+	REQUIRE(task.result() == 1000);
+	REQUIRE(slices == 11); // the additions yield after every 100 items
+	REQUIRE(s.size() == 997);
+
+	auto difference = STLWrappers::inFirstButNotInSecondAsync(items, s);
+	difference.start();
+	REQUIRE(difference.done());
+	REQUIRE(difference.result().size() == 3);
+}
+
+TEST_CASE("addAllAsync() and removeAllAsync() on a pool") {
+	std::vector<int> items;
+	for (int i = 0; i < 1000; ++i)
+		items.push_back(i);
+	std::vector<int> removed{ 1, 2, 3 };
+
+	// a thread safe scheduler: workers queue the operation, and this thread (the "event loop") resumes it
+	std::mutex mutex;
+	std::condition_variable queued;
+	std::vector<std::coroutine_handle<>> ready;
+	bool fromOtherThread = true;
+	const auto caller = std::this_thread::get_id();
+	STLWrappers::ThreadPool pool(2);
+	STLWrappers::AsyncOptions options;
+	options.pool = &pool;
+	options.scheduler = [&](std::coroutine_handle<> handle) {
+		std::lock_guard<std::mutex> lock(mutex);
+		fromOtherThread = fromOtherThread && std::this_thread::get_id() != caller;
+		ready.push_back(handle);
+		queued.notify_one();
+	};
+
+	std::set<int> s;
+	auto task = addThenRemove(s, items, removed, options);
+	task.start();
+	size_t resumed = 0;
+	while (!task.done()) {
+		std::coroutine_handle<> handle;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			queued.wait(lock, [&]() { return !ready.empty(); });
+			handle = ready.back();
+			ready.pop_back();
+		}
+		handle.resume();
+		++resumed;
+	}
+	REQUIRE(task.result() == 1000);
+	REQUIRE(resumed == 2); // once after the additions, once after the removals
+	REQUIRE(fromOtherThread);
+	REQUIRE(s.size() == 997);
+}
+#endif
+
+TEST_CASE("Tracked") {
+	STLWrappers::Tracked<std::set<int>> s{ 1, 2, 3 };
+	auto start = s.version();
+	add(s, 4);
+	add(s, 4); // already there, not recorded
+	remove(s, 1);
+	add(s, 5);
+	remove(s, 5); // cancels out
+	auto delta = s.delta(start);
+	REQUIRE(delta);
+	REQUIRE(delta->added == std::vector<int>{ 4 });
+	REQUIRE(delta->removed == std::vector<int>{ 1 });
+	REQUIRE(contains(s, 4));
+	REQUIRE(s.size() == 3);
+
+	STLWrappers::Tracked<std::map<int, int>> m;
+	add(m, 1, 10);
+	auto afterAdd = m.version();
+	add(m, 1, 11);
+	add(m, 2, 20);
+	auto mapDelta = m.delta(afterAdd);
+	REQUIRE(mapDelta->added == std::vector<int>{ 2 });
+	REQUIRE(mapDelta->updated == std::vector<int>{ 1 });
+
+	m.compact(m.version());
+	REQUIRE(!m.delta(afterAdd));
+	REQUIRE(m.delta(m.version())->added.empty());
+}
+
+TEST_CASE("BatchWriter") {
+	std::map<int, int> m{ { 1, 10 }, { 2, 20 } };
+	{
+		STLWrappers::BatchWriter<std::map<int, int>> writer(m);
+		add(writer, 3, 30);
+		remove(writer, 3); // cancels out
+		remove(writer, 1);
+		add(writer, 1, 11); // the last operation wins
+		add(writer, std::pair<const int, int>(2, 0)); // 2 is already there
+		add(writer, 4, 40);
+		REQUIRE(writer.pending() == 6);
+		REQUIRE(m.size() == 2);
+	}
+	REQUIRE(m == std::map<int, int>{ { 1, 11 }, { 2, 20 }, { 4, 40 } });
+
+	std::unordered_set<int> s{ 1, 2, 3 };
+	STLWrappers::BatchWriter<std::unordered_set<int>> writer(s);
+	addAll(writer, { 4, 5, 6 });
+	remove(writer, 1);
+	remove(writer, 5);
+	writer.flush();
+	REQUIRE(writer.pending() == 0);
+	REQUIRE(s == std::unordered_set<int>{ 2, 3, 4, 6 });
+}